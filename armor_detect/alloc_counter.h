@@ -0,0 +1,19 @@
+#ifndef ARMOR_ALLOC_COUNTER_H
+#define ARMOR_ALLOC_COUNTER_H
+
+#include <cstddef>
+
+// 堆分配计数
+// glibc 下覆盖进程的 malloc 系列函数（OpenCV 的 fastMalloc 也会被统计到），
+// 其他平台只替换全局 operator new。只统计调用过 arm() 的线程上的分配，
+// 用来检查检测路径在稳态下是否还在申请内存。
+class AllocCounter {
+public:
+    // 清零当前线程的计数并开始统计
+    static void arm();
+    static void disarm();
+    // 当前线程最近一次 arm() 以来的分配次数
+    static size_t count();
+};
+
+#endif // ARMOR_ALLOC_COUNTER_H
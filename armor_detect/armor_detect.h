@@ -5,18 +5,42 @@
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <string>
+#include "fused_preprocess.h"
+#include "color_mask.h"
+#include "light_bar_pairing.h"
+#include "association.h"
+#include "box_kalman.h"
+#include "ccl.h"
+
+// 单帧检测结果：外接框，以及按 左上、右上、右下、左下 排列的四个角点
+struct ArmorDetection {
+    cv::Rect bbox;
+    cv::Point2f corners[4];
+};
 
 // 跟踪的装甲板结构体
 struct TrackedArmor {
     int id;
-    cv::Rect bbox;
+    cv::Rect bbox;                       // 匹配上时是检测框，丢失期间是预测框
     std::vector<cv::Point2f> corners;
     int age;
     int hits;
     int misses;
+    BoxKalman motion;                    // 框中心和尺寸的匀速运动模型
+    cv::Rect predicted;                  // 本帧关联时使用的预测框
+    
+    // 相机坐标系下的位姿，在 processFrame 中求解，pose_valid 为 true 时有效
+    cv::Vec3d rvec;
+    cv::Vec3d tvec;
+    bool pose_valid;
+    std::vector<cv::Point2f> pose_corners;   // 上一次求解位姿时用的角点
     
     TrackedArmor(int _id, const cv::Rect& _bbox, const std::vector<cv::Point2f>& _corners)
-        : id(_id), bbox(_bbox), corners(_corners), age(0), hits(1), misses(0) {}
+        : id(_id), bbox(_bbox), corners(_corners), age(0), hits(1), misses(0), predicted(_bbox),
+          pose_valid(false) {
+        motion.init(_bbox);
+    }
 };
 
 // 装甲板跟踪器类
@@ -27,35 +51,188 @@ private:
     double iou_threshold_;
     int max_misses_;
     
+    // 关联用的缓冲区，跨帧复用
+    GatedAssociator associator_;
+    std::vector<cv::Rect> track_boxes_;
+    std::vector<cv::Rect> detection_boxes_;
+    std::vector<int> track_to_detection_;
+    std::vector<int> detection_to_track_;
+    
 public:
     ArmorTracker(double iou_thresh = 0.3, int max_miss = 5);
-    double calculateIOU(const cv::Rect& rect1, const cv::Rect& rect2);
-    std::vector<TrackedArmor> update(const std::vector<std::pair<cv::Rect, std::vector<cv::Point2f>>>& detections);
+    static double calculateIOU(const cv::Rect& rect1, const cv::Rect& rect2);
+    // 先用运动模型把每个目标预测 dt 帧，再和检测框关联；隔帧检测时 dt 传 2。
+    // 返回内部跟踪列表的引用，下一次 update 或 clear 之前有效
+    const std::vector<TrackedArmor>& update(const std::vector<ArmorDetection>& detections, float dt = 1.f);
     void clear();
+    const std::vector<TrackedArmor>& tracks() const { return tracked_armors_; }
+    std::vector<TrackedArmor>& tracks() { return tracked_armors_; }
+};
+
+// 一帧检测的工作区，由 ArmorDetector 持有并跨帧复用。
+// 容器只 clear 或增长、Mat 尺寸不变时不重新分配，稳态下检测器自身不再申请堆内存。
+struct ArmorFrameContext {
+    cv::Mat binary;
+    cv::Mat window_binary;                        // ROI 窗口的二值图，按整帧大小分配，取左上角子区域
+    std::vector<std::vector<cv::Point>> contours;
+    std::vector<ccl::Component> components;       // 连通域统计模式下代替 contours
+    std::vector<uchar> outer;                     // 各连通域是否在最外层
+    std::vector<cv::RotatedRect> light_bars;
+    std::vector<std::pair<int, int>> pairs;
+    std::vector<ArmorDetection> detections;
+};
+
+// 最近一次 processFrame 各阶段的耗时（毫秒），ROI 模式下是所有窗口之和
+struct ArmorStageTimes {
+    double preprocess;
+    double find_light_bars;
+    double pair_light_bars;      // 灯条配对 + 角点计算
+    double tracker;
+    double pose;
+    
+    ArmorStageTimes() : preprocess(0), find_light_bars(0), pair_light_bars(0), tracker(0), pose(0) {}
 };
 
 // 装甲板检测器类
 class ArmorDetector {
+    friend class ArmorPipeline;
+
 private:
     ArmorTracker tracker_;
+    FusedPreprocessor preprocessor_;
+    LightBarPairer pairer_;
+    ArmorFrameContext ctx_;
+    ArmorStageTimes stage_times_;
     cv::Mat camera_matrix_;
     cv::Mat dist_coeffs_;
     std::vector<cv::Point3f> obj_points_;
     
-    cv::Mat preprocessFrame(const cv::Mat& frame);
-    std::vector<cv::RotatedRect> findLightBars(const cv::Mat& binary);
-    std::vector<std::pair<cv::RotatedRect, cv::RotatedRect>> pairLightBars(const std::vector<cv::RotatedRect>& light_bars);
-    std::vector<cv::Point2f> calculateArmorCorners(const cv::RotatedRect& left_bar, const cv::RotatedRect& right_bar);
-    bool estimatePose(const std::vector<cv::Point2f>& corners, cv::Vec3d& rvec, cv::Vec3d& tvec);
-    void drawCoordinateAxes(cv::Mat& frame, const cv::Vec3d& rvec, const cv::Vec3d& tvec);
+    // 关闭时跳过位姿阶段；位姿缓存：角点移动都小于 pose_tolerance_ 像素时沿用上一次的解
+    bool pose_enabled_;
+    double pose_tolerance_;
+    size_t pose_solves_;
+    size_t pose_reuses_;
+    
+    // 跟踪引导的 ROI 检测
+    bool roi_enabled_;
+    int full_scan_interval_;      // 每隔多少帧强制全图搜索一次
+    float roi_expand_ratio_;      // 窗口每边按 bbox 尺寸扩展的比例
+    int frames_since_full_scan_;
+    bool need_full_scan_;
+    double last_search_coverage_;
+    std::vector<cv::Rect> search_windows_;
+    
+    // 颜色差分预处理
+    bool color_mode_;
+    ColorMaskParams color_params_;
+    
+    // 积分图均值阈值预处理
+    bool mean_mode_;
+    MeanPreprocessor mean_preprocessor_;
+    
+    // 连通域统计找灯条
+    bool label_mode_;
+    ccl::Labeller labeller_;
+    ccl::OuterFilter outer_filter_;
+    
+    // 相邻两次 processFrame 之间隔了几帧，传给跟踪器的 dt
+    float frame_step_;
+    
+    void preprocessFrame(const cv::Mat& frame, cv::Mat& binary);
+    // 找到的灯条加上 offset 后追加到 light_bars
+    void findLightBars(const cv::Mat& binary, std::vector<cv::RotatedRect>& light_bars,
+                       cv::Point offset = cv::Point());
+    void findLightBarsInWindows(const cv::Mat& frame, std::vector<cv::RotatedRect>& light_bars);
+    void computeSearchWindows(const cv::Size& frame_size);
+    void calculateArmorCorners(const cv::RotatedRect& left_bar, const cv::RotatedRect& right_bar,
+                               cv::Point2f corners[4]);
+    void buildDetections(const std::vector<cv::RotatedRect>& light_bars, std::vector<ArmorDetection>& detections);
+    void updatePoses();
+#ifndef ARMOR_HEADLESS
+    void drawCoordinateAxes(cv::Mat& frame, const cv::Vec3d& rvec, const cv::Vec3d& tvec) const;
+    void drawArmorContours(cv::Mat& frame, const std::vector<TrackedArmor>& armors) const;
+    std::string getPoseInfo(const cv::Vec3d& tvec, const cv::Vec3d& rvec) const;
+#endif
     
 public:
     ArmorDetector();
-    std::vector<TrackedArmor> processFrame(const cv::Mat& frame);
-    void drawResults(cv::Mat& frame, const std::vector<TrackedArmor>& armors);
+    // 返回跟踪器内部列表的引用，下一次 processFrame 之前有效
+    const std::vector<TrackedArmor>& processFrame(const cv::Mat& frame);
+    const ArmorStageTimes& lastStageTimes() const { return stage_times_; }
+#ifndef ARMOR_HEADLESS
+    // 只读取相机参数，可以在渲染线程里和 processFrame 并发调用
+    void drawResults(cv::Mat& frame, const std::vector<TrackedArmor>& armors) const;
+#endif
+    
+    // 求解一组角点的位姿。use_guess 为 true 时以传入的 rvec/tvec 为初值迭代；
+    // 角点退化（不是 4 个、非有限值、面积过小）时直接返回 false，不会抛异常
+    bool estimatePose(const std::vector<cv::Point2f>& corners, cv::Vec3d& rvec, cv::Vec3d& tvec,
+                      bool use_guess = false) const;
+    // 更新单个跟踪目标的位姿：有上一帧的解就热启动，角点几乎没动就直接复用
+    void updatePose(TrackedArmor& armor);
+    void setPoseTolerance(double pixels) { pose_tolerance_ = pixels; }
+    // 关闭后 processFrame 和流水线都不再求位姿，跟踪目标的 pose_valid 一律为 false
+    void setPoseEnabled(bool enabled) { pose_enabled_ = enabled; }
+    bool poseEnabled() const { return pose_enabled_; }
+    size_t poseSolveCount() const { return pose_solves_; }
+    size_t poseReuseCount() const { return pose_reuses_; }
+    const cv::Mat& cameraMatrix() const { return camera_matrix_; }
+    const cv::Mat& distCoeffs() const { return dist_coeffs_; }
+    const std::vector<cv::Point3f>& objectPoints() const { return obj_points_; }
+    
+    // 开启后只在已跟踪装甲板附近的窗口里做预处理和找灯条，
+    // 每 full_scan_interval 帧或有目标丢失时退回全图搜索
+    void setRoiMode(bool enabled, int full_scan_interval = 10, float expand_ratio = 1.0f);
+    // 上一帧实际搜索的像素占整帧的比例
+    double lastSearchCoverage() const { return last_search_coverage_; }
+    const std::vector<cv::Rect>& searchWindows() const { return search_windows_; }
+    
+    // 开启后预处理改为按敌方颜色做颜色差分二值化，代替灰度自适应阈值和形态学，
+    // 白色灯光、反光等非敌方颜色的光源直接被排除
+    void setColorMode(bool enabled, const ColorMaskParams& params = ColorMaskParams());
+    bool colorMode() const { return color_mode_; }
+    
+    // 开启后灰度自适应阈值改为积分图上的均值阈值（ADAPTIVE_THRESH_MEAN_C），耗时与窗口大小无关，
+    // 形态学不变。颜色差分模式优先
+    void setMeanThresholdMode(bool enabled, int block_size = FusedPreprocessor::kBlockSize);
+    bool meanThresholdMode() const { return mean_mode_; }
+    // 均值阈值模式下最近一次预处理的积分图（ROI 模式下是最后一个窗口的），可以查询任意框的亮度均值和方差
+    const integral::IntegralImage& frameIntegral() const { return mean_preprocessor_.integralImage(); }
+    
+    // 开启后找灯条改为一次连通域标记，按面积和二阶矩过滤小块、圆块，用等效矩形代替
+    // findContours + contourArea + minAreaRect，不提取轮廓点。和 RETR_EXTERNAL 一样，
+    // 嵌在别的块的洞里的连通域不算
+    void setLabelMode(bool enabled) { label_mode_ = enabled; }
+    bool labelMode() const { return label_mode_; }
+    
+    // 两次 processFrame 之间相隔的帧数，跟踪器按它预测运动；隔帧检测时设为 2，跳帧数可以随时改
+    void setFrameStep(float dt) { CV_Assert(dt > 0); frame_step_ = dt; }
+    float frameStep() const { return frame_step_; }
+    
+    // 合并有重叠的窗口，直到任意两个窗口都不相交
+    static void mergeSearchWindows(std::vector<cv::Rect>& windows);
 };
 
 // 测试函数声明
 bool test_armor_detect();
+bool test_fused_preprocess();
+bool bench_fused_preprocess();
+bool test_armor_pipeline();
+bool test_armor_roi();
+bool test_light_bar_pairing();
+bool bench_light_bar_pairing();
+bool test_armor_association();
+bool bench_armor_association();
+bool test_armor_motion();
+bool bench_armor_pose();
+bool bench_armor_render();
+bool test_armor_zero_alloc();
+bool test_armor_scene();
+bool bench_armor_scene();
+bool test_color_mask();
+bool bench_color_mask();
+bool test_label_light_bars();
+bool test_mean_preprocess();
+bool bench_mean_preprocess();
 
 #endif // ARMOR_DETECT_H
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include "association.h"
+#include "iou_batch.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace cv;
+using namespace std;
+
+// 向下取整的整数除法（b > 0）
+static inline int floorDiv(int a, int b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+void GatedAssociator::buildCandidates(const vector<Rect>& tracks, const vector<Rect>& detections,
+                                      double iou_threshold) {
+    edges_.clear();
+    if (tracks.empty() || detections.empty()) return;
+
+    // 中心点坐标统一乘 2，保持整数运算
+    int max_side = 1;
+    for (const auto& r : tracks) max_side = max(max_side, max(r.width, r.height));
+    for (const auto& r : detections) max_side = max(max_side, max(r.width, r.height));
+
+    int min_x = INT_MAX, min_y = INT_MAX, max_x = INT_MIN, max_y = INT_MIN;
+    for (const auto& r : detections) {
+        min_x = min(min_x, 2 * r.x + r.width);
+        min_y = min(min_y, 2 * r.y + r.height);
+        max_x = max(max_x, 2 * r.x + r.width);
+        max_y = max(max_y, 2 * r.y + r.height);
+    }
+
+    // 相交的两个框中心距离小于最大边长，所以格子边长取最大边长就只需要查相邻格子；
+    // 框很小而分布很散时再放大格子，让格子总数和检测框数量同阶
+    int cell = 2 * max_side;
+    int span = max(max_x - min_x, max_y - min_y);
+    int per_axis = (int)std::sqrt((double)detections.size()) + 1;
+    cell = max(cell, span / per_axis + 1);
+
+    const int grid_w = (max_x - min_x) / cell + 1;
+    const int grid_h = (max_y - min_y) / cell + 1;
+    const int n = (int)detections.size();
+
+    cell_of_.resize(n);
+    cell_start_.assign(grid_w * grid_h + 1, 0);
+    for (int j = 0; j < n; j++) {
+        const Rect& r = detections[j];
+        int gx = (2 * r.x + r.width - min_x) / cell;
+        int gy = (2 * r.y + r.height - min_y) / cell;
+        cell_of_[j] = gy * grid_w + gx;
+        cell_start_[cell_of_[j] + 1]++;
+    }
+    for (int c = 0; c < grid_w * grid_h; c++) {
+        cell_start_[c + 1] += cell_start_[c];
+    }
+    cell_fill_.assign(cell_start_.begin(), cell_start_.end() - 1);
+    cell_items_.resize(n);
+    for (int j = 0; j < n; j++) {
+        cell_items_[cell_fill_[cell_of_[j]]++] = j;
+    }
+
+    // 检测框按格子顺序排成 SoA，相邻几个格子在同一行时是一段连续区间，
+    // 每个跟踪框对每一行格子调一次批量 IoU
+    track_soa_.assign(tracks);
+    det_soa_.clear();
+    for (int k = 0; k < n; k++) {
+        det_soa_.push_back(detections[cell_items_[k]]);
+    }
+
+    pairs_.clear();
+    for (int i = 0; i < (int)tracks.size(); i++) {
+        const Rect& t = tracks[i];
+        int gx = floorDiv(2 * t.x + t.width - min_x, cell);
+        int gy = floorDiv(2 * t.y + t.height - min_y, cell);
+        int x_lo = max(gx - 1, 0), x_hi = min(gx + 1, grid_w - 1);
+        if (x_lo > x_hi) continue;
+
+        for (int y = max(gy - 1, 0); y <= min(gy + 1, grid_h - 1); y++) {
+            int begin = cell_start_[y * grid_w + x_lo];
+            int end = cell_start_[y * grid_w + x_hi + 1];
+            iou_batch::iou_row_pairs(track_soa_, i, det_soa_, begin, end, iou_threshold, pairs_);
+        }
+    }
+
+    for (const auto& p : pairs_) {
+        Edge e = {p.a, cell_items_[p.b], p.iou};
+        edges_.push_back(e);
+    }
+}
+
+int GatedAssociator::findRoot(int x) {
+    while (parent_[x] != x) {
+        parent_[x] = parent_[parent_[x]];
+        x = parent_[x];
+    }
+    return x;
+}
+
+void GatedAssociator::hungarian(int rows, int cols) {
+    // 经典的 O(n^2 m) 势能法，rows <= cols，下标从 1 开始
+    const double inf = numeric_limits<double>::infinity();
+    u_.assign(rows + 1, 0.0);
+    v_.assign(cols + 1, 0.0);
+    p_.assign(cols + 1, 0);
+    way_.assign(cols + 1, 0);
+
+    for (int i = 1; i <= rows; i++) {
+        p_[0] = i;
+        int j0 = 0;
+        minv_.assign(cols + 1, inf);
+        used_.assign(cols + 1, 0);
+        do {
+            used_[j0] = 1;
+            int i0 = p_[j0], j1 = 0;
+            double delta = inf;
+            for (int j = 1; j <= cols; j++) {
+                if (used_[j]) continue;
+                double cur = cost_[(i0 - 1) * cols + (j - 1)] - u_[i0] - v_[j];
+                if (cur < minv_[j]) {
+                    minv_[j] = cur;
+                    way_[j] = j0;
+                }
+                if (minv_[j] < delta) {
+                    delta = minv_[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= cols; j++) {
+                if (used_[j]) {
+                    u_[p_[j]] += delta;
+                    v_[j] -= delta;
+                } else {
+                    minv_[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p_[j0] != 0);
+
+        do {
+            int j1 = way_[j0];
+            p_[j0] = p_[j1];
+            j0 = j1;
+        } while (j0);
+    }
+}
+
+void GatedAssociator::solveComponent(int begin, int end, vector<int>& track_to_det, vector<int>& det_to_track) {
+    if (end - begin == 1) {
+        const Edge& e = sorted_edges_[begin];
+        track_to_det[e.track] = e.detection;
+        det_to_track[e.detection] = e.track;
+        return;
+    }
+
+    // 给连通块内的跟踪框和检测框编局部下标，节点编号: 跟踪框 i -> i，检测框 j -> T + j
+    const int num_tracks = (int)track_to_det.size();
+    row_nodes_.clear();
+    col_nodes_.clear();
+    for (int k = begin; k < end; k++) {
+        const Edge& e = sorted_edges_[k];
+        if (local_index_[e.track] < 0) {
+            local_index_[e.track] = (int)row_nodes_.size();
+            row_nodes_.push_back(e.track);
+        }
+        int d = num_tracks + e.detection;
+        if (local_index_[d] < 0) {
+            local_index_[d] = (int)col_nodes_.size();
+            col_nodes_.push_back(d);
+        }
+    }
+
+    // 匈牙利算法要求行数不多于列数，必要时把检测框当作行
+    const bool transposed = row_nodes_.size() > col_nodes_.size();
+    const int rows = (int)(transposed ? col_nodes_.size() : row_nodes_.size());
+    const int cols = (int)(transposed ? row_nodes_.size() : col_nodes_.size());
+
+    // 最大化总 IoU 等价于最小化 -IoU，没有候选边的位置代价为 0（相当于不匹配）
+    cost_.assign(rows * cols, 0.0);
+    for (int k = begin; k < end; k++) {
+        const Edge& e = sorted_edges_[k];
+        int r = local_index_[e.track];
+        int c = local_index_[num_tracks + e.detection];
+        if (transposed) swap(r, c);
+        cost_[r * cols + c] = -e.iou;
+    }
+
+    hungarian(rows, cols);
+
+    for (int j = 1; j <= cols; j++) {
+        if (p_[j] == 0) continue;
+        int r = p_[j] - 1, c = j - 1;
+        if (cost_[r * cols + c] >= 0.0) continue;   // 落在没有候选边的位置，不算匹配
+
+        int track = transposed ? row_nodes_[c] : row_nodes_[r];
+        int det = (transposed ? col_nodes_[r] : col_nodes_[c]) - num_tracks;
+        track_to_det[track] = det;
+        det_to_track[det] = track;
+    }
+
+    for (int node : row_nodes_) local_index_[node] = -1;
+    for (int node : col_nodes_) local_index_[node] = -1;
+}
+
+void GatedAssociator::associate(const vector<Rect>& tracks, const vector<Rect>& detections,
+                                double iou_threshold, vector<int>& track_to_det, vector<int>& det_to_track) {
+    track_to_det.assign(tracks.size(), -1);
+    det_to_track.assign(detections.size(), -1);
+
+    buildCandidates(tracks, detections, iou_threshold);
+    if (edges_.empty()) return;
+
+    // 并查集求连通块
+    const int num_tracks = (int)tracks.size();
+    const int num_nodes = num_tracks + (int)detections.size();
+    parent_.resize(num_nodes);
+    for (int i = 0; i < num_nodes; i++) parent_[i] = i;
+    for (const auto& e : edges_) {
+        int a = findRoot(e.track), b = findRoot(num_tracks + e.detection);
+        if (a != b) parent_[a] = b;
+    }
+
+    // 按连通块的根把边排成连续区间
+    comp_start_.assign(num_nodes + 1, 0);
+    comp_of_edge_.resize(edges_.size());
+    for (size_t k = 0; k < edges_.size(); k++) {
+        comp_of_edge_[k] = findRoot(edges_[k].track);
+        comp_start_[comp_of_edge_[k] + 1]++;
+    }
+    for (int c = 0; c < num_nodes; c++) {
+        comp_start_[c + 1] += comp_start_[c];
+    }
+    comp_fill_.assign(comp_start_.begin(), comp_start_.end() - 1);
+    sorted_edges_.resize(edges_.size());
+    for (size_t k = 0; k < edges_.size(); k++) {
+        sorted_edges_[comp_fill_[comp_of_edge_[k]]++] = edges_[k];
+    }
+
+    local_index_.assign(num_nodes, -1);
+    for (int c = 0; c < num_nodes; c++) {
+        if (comp_start_[c + 1] > comp_start_[c]) {
+            solveComponent(comp_start_[c], comp_start_[c + 1], track_to_det, det_to_track);
+        }
+    }
+}
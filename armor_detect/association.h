@@ -0,0 +1,67 @@
+#ifndef ARMOR_ASSOCIATION_H
+#define ARMOR_ASSOCIATION_H
+
+#include "iou_batch.h"
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// 跟踪框与检测框的全局最优关联
+// 1. 检测框按中心点放进网格（格子边长不小于最大框的边长），每个跟踪框只和
+//    相邻 3x3 个格子里的检测框算 IoU（批量 SIMD，见 iou_batch.h），IoU 超过阈值的对
+//    组成稀疏代价矩阵；
+// 2. 候选边把跟踪框和检测框连成若干互不相交的连通块，每块单独用匈牙利算法
+//    求总 IoU 最大的一一匹配。
+// 所有缓冲区跨帧复用，稳态下不分配内存。
+class GatedAssociator {
+public:
+    // track_to_det[i] 为跟踪框 i 匹配到的检测框下标，未匹配为 -1；det_to_track 同理
+    void associate(const std::vector<cv::Rect>& tracks, const std::vector<cv::Rect>& detections,
+                   double iou_threshold, std::vector<int>& track_to_det, std::vector<int>& det_to_track);
+
+    // 上一次关联生成的候选边数，用来观察门控效果
+    size_t candidateCount() const { return edges_.size(); }
+
+private:
+    struct Edge {
+        int track;
+        int detection;
+        double iou;
+    };
+
+    void buildCandidates(const std::vector<cv::Rect>& tracks, const std::vector<cv::Rect>& detections,
+                         double iou_threshold);
+    int findRoot(int x);
+    void solveComponent(int begin, int end, std::vector<int>& track_to_det, std::vector<int>& det_to_track);
+    void hungarian(int rows, int cols);
+
+    std::vector<Edge> edges_;
+
+    // 批量 IoU 的输入（检测框按格子顺序）和输出
+    iou_batch::RectSoA track_soa_;
+    iou_batch::RectSoA det_soa_;
+    std::vector<iou_batch::IouPair> pairs_;
+
+    // 网格（CSR）
+    std::vector<int> cell_of_;
+    std::vector<int> cell_start_;
+    std::vector<int> cell_fill_;
+    std::vector<int> cell_items_;
+
+    // 连通块：并查集，以及按连通块排好序的边
+    std::vector<int> parent_;
+    std::vector<int> comp_start_;
+    std::vector<int> comp_fill_;
+    std::vector<int> comp_of_edge_;
+    std::vector<Edge> sorted_edges_;
+    std::vector<int> local_index_;
+    std::vector<int> row_nodes_;
+    std::vector<int> col_nodes_;
+
+    // 匈牙利算法的工作区（1 起始下标）
+    std::vector<double> cost_;
+    std::vector<double> u_, v_, minv_;
+    std::vector<int> p_, way_;
+    std::vector<char> used_;
+};
+
+#endif // ARMOR_ASSOCIATION_H
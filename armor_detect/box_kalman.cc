@@ -0,0 +1,65 @@
+#include "box_kalman.h"
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+// 加速度噪声的标准差（像素/帧^2），中心点比尺寸变化快
+static const float kAccelNoise[4] = {4.f, 4.f, 2.f, 2.f};
+// 观测噪声的方差（像素^2）
+static const float kMeasurementVar = 4.f;
+// 新目标速度未知，初始速度方差取大一些
+static const float kInitVelocityVar = 100.f;
+
+BoxKalman::BoxKalman() {
+    init(Rect());
+}
+
+void BoxKalman::init(const Rect& box) {
+    x_ = Vec4f(box.x + box.width * 0.5f, box.y + box.height * 0.5f,
+               (float)box.width, (float)box.height);
+    v_ = Vec4f(0.f, 0.f, 0.f, 0.f);
+    for (int k = 0; k < 4; k++) {
+        P_[k] = Matx22f(kMeasurementVar, 0.f, 0.f, kInitVelocityVar);
+    }
+}
+
+void BoxKalman::predict(float dt) {
+    // F = [1 dt; 0 1]，Q 为白噪声加速度模型
+    const Matx22f F(1.f, dt, 0.f, 1.f);
+    const float dt2 = dt * dt;
+    for (int k = 0; k < 4; k++) {
+        float q = kAccelNoise[k] * kAccelNoise[k];
+        Matx22f Q(dt2 * dt2 / 4 * q, dt2 * dt / 2 * q,
+                  dt2 * dt / 2 * q, dt2 * q);
+        x_[k] += v_[k] * dt;
+        P_[k] = F * P_[k] * F.t() + Q;
+    }
+    x_[2] = max(x_[2], 1.f);
+    x_[3] = max(x_[3], 1.f);
+}
+
+void BoxKalman::correct(const Rect& box) {
+    const Vec4f z(box.x + box.width * 0.5f, box.y + box.height * 0.5f,
+                  (float)box.width, (float)box.height);
+    // H = [1 0]，S 和 K 都是标量/二维向量，不需要求逆
+    for (int k = 0; k < 4; k++) {
+        Matx22f& P = P_[k];
+        float s = P(0, 0) + kMeasurementVar;
+        float k0 = P(0, 0) / s;
+        float k1 = P(1, 0) / s;
+        float y = z[k] - x_[k];
+
+        x_[k] += k0 * y;
+        v_[k] += k1 * y;
+
+        Matx22f updated(P(0, 0) - k0 * P(0, 0), P(0, 1) - k0 * P(0, 1),
+                        P(1, 0) - k1 * P(0, 0), P(1, 1) - k1 * P(0, 1));
+        P = updated;
+    }
+}
+
+Rect BoxKalman::box() const {
+    float w = max(x_[2], 1.f), h = max(x_[3], 1.f);
+    return Rect(cvRound(x_[0] - w * 0.5f), cvRound(x_[1] - h * 0.5f), cvRound(w), cvRound(h));
+}
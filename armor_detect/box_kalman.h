@@ -0,0 +1,30 @@
+#ifndef ARMOR_BOX_KALMAN_H
+#define ARMOR_BOX_KALMAN_H
+
+#include <opencv2/opencv.hpp>
+
+// 框中心和尺寸上的匀速卡尔曼滤波
+// 状态是 (cx, cy, w, h) 以及它们的速度。过程噪声和观测噪声都按分量独立，
+// 所以滤波分解成四个互不耦合的 [位置, 速度] 二维滤波，协方差各是 2x2，
+// 全部是定长的值类型，拷贝和更新都不分配内存。
+class BoxKalman {
+public:
+    BoxKalman();
+
+    void init(const cv::Rect& box);
+    // dt 以帧为单位，隔帧检测时传 2
+    void predict(float dt = 1.f);
+    void correct(const cv::Rect& box);
+
+    // 当前估计的框
+    cv::Rect box() const;
+    cv::Point2f center() const { return cv::Point2f(x_[0], x_[1]); }
+    cv::Point2f velocity() const { return cv::Point2f(v_[0], v_[1]); }
+
+private:
+    cv::Vec4f x_;        // cx, cy, w, h
+    cv::Vec4f v_;        // 对应的速度（像素/帧）
+    cv::Matx22f P_[4];   // 每个分量的 [位置, 速度] 协方差
+};
+
+#endif // ARMOR_BOX_KALMAN_H
@@ -0,0 +1,177 @@
+#include "color_mask.h"
+#include "cpu_features.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace cv;
+
+// 与 cvtColor(COLOR_BGR2GRAY) 的 8 位定点系数相同：gray = (B*3735 + G*19235 + R*9798 + 2^14) >> 15
+static const int kGrayShift = 15;
+static const int kGrayB = 3735, kGrayG = 19235, kGrayR = 9798;
+
+// 每行共用的常量。gray > T 等价于加权和 s > ((T + 1) << 15) - 2^14 - 1，不用真的做移位
+struct MaskConsts {
+    bool blue;
+    int diff;
+    int sum_limit;
+
+    explicit MaskConsts(const ColorMaskParams& params)
+        : blue(params.enemy == EnemyColor::BLUE), diff(params.diff_threshold),
+          sum_limit(((params.brightness_threshold + 1) << kGrayShift) - (1 << (kGrayShift - 1)) - 1) {}
+};
+
+static inline uchar maskPixel(const uchar* p, const MaskConsts& k) {
+    int enemy = k.blue ? p[0] : p[2];
+    int other = k.blue ? p[2] : p[0];
+    int sum = p[0] * kGrayB + p[1] * kGrayG + p[2] * kGrayR;
+    return (uchar)(enemy - other > k.diff && sum > k.sum_limit ? 255 : 0);
+}
+
+#ifdef __SSE2__
+// 6 个向量里连续 32 个 BGR 像素，5 轮交错后变成 B0 B1 G0 G1 R0 R1，每个向量 16 个像素
+static inline void deinterleave3SSE2(__m128i v[6]) {
+    for (int round = 0; round < 5; round++) {
+        __m128i t0 = _mm_unpacklo_epi8(v[0], v[3]), t1 = _mm_unpackhi_epi8(v[0], v[3]);
+        __m128i t2 = _mm_unpacklo_epi8(v[1], v[4]), t3 = _mm_unpackhi_epi8(v[1], v[4]);
+        __m128i t4 = _mm_unpacklo_epi8(v[2], v[5]), t5 = _mm_unpackhi_epi8(v[2], v[5]);
+        v[0] = t0; v[1] = t1; v[2] = t2; v[3] = t3; v[4] = t4; v[5] = t5;
+    }
+}
+
+// 16 个像素的掩码。加权和按 4 组 32 位用 madd 计算，比较结果饱和打包回 8 位
+static inline __m128i maskSSE2(__m128i b, __m128i g, __m128i r, const MaskConsts& k) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i coef_bg = _mm_set1_epi32((kGrayG << 16) | kGrayB);
+    const __m128i coef_r = _mm_set1_epi32(kGrayR);
+    const __m128i limit = _mm_set1_epi32(k.sum_limit);
+
+    __m128i enemy = k.blue ? b : r, other = k.blue ? r : b;
+    __m128i diff_low = _mm_cmpeq_epi8(_mm_subs_epu8(_mm_subs_epu8(enemy, other),
+                                                    _mm_set1_epi8((char)k.diff)), zero);
+
+    __m128i b16 = _mm_unpacklo_epi8(b, zero), g16 = _mm_unpacklo_epi8(g, zero), r16 = _mm_unpacklo_epi8(r, zero);
+    __m128i s0 = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(b16, g16), coef_bg),
+                               _mm_madd_epi16(_mm_unpacklo_epi16(r16, zero), coef_r));
+    __m128i s1 = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(b16, g16), coef_bg),
+                               _mm_madd_epi16(_mm_unpackhi_epi16(r16, zero), coef_r));
+    b16 = _mm_unpackhi_epi8(b, zero); g16 = _mm_unpackhi_epi8(g, zero); r16 = _mm_unpackhi_epi8(r, zero);
+    __m128i s2 = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(b16, g16), coef_bg),
+                               _mm_madd_epi16(_mm_unpacklo_epi16(r16, zero), coef_r));
+    __m128i s3 = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(b16, g16), coef_bg),
+                               _mm_madd_epi16(_mm_unpackhi_epi16(r16, zero), coef_r));
+    __m128i bright = _mm_packs_epi16(_mm_packs_epi32(_mm_cmpgt_epi32(s0, limit), _mm_cmpgt_epi32(s1, limit)),
+                                     _mm_packs_epi32(_mm_cmpgt_epi32(s2, limit), _mm_cmpgt_epi32(s3, limit)));
+    return _mm_andnot_si128(diff_low, bright);
+}
+
+// 返回处理到的位置，剩下的交给标量循环
+static int maskRowSSE2(const uchar* bgr, uchar* mask, int x, int width, const MaskConsts& k) {
+    for (; x + 32 <= width; x += 32) {
+        const uchar* p = bgr + 3 * x;
+        __m128i v[6];
+        for (int i = 0; i < 6; i++) {
+            v[i] = _mm_loadu_si128((const __m128i*)(p + 16 * i));
+        }
+        deinterleave3SSE2(v);
+        _mm_storeu_si128((__m128i*)(mask + x), maskSSE2(v[0], v[2], v[4], k));
+        _mm_storeu_si128((__m128i*)(mask + x + 16), maskSSE2(v[1], v[3], v[5], k));
+    }
+    return x;
+}
+#endif
+
+#ifdef CPU_AVX2_DISPATCH
+// AVX2 的 unpack / pack 都在 128 位的半边内进行：低半边装前 32 个像素、高半边装后 32 个，
+// 两半各自按 SSE2 的方式交错和计算，最后再把两半拼回像素顺序
+__attribute__((target("avx2")))
+static inline __m256i maskAVX2(__m256i b, __m256i g, __m256i r, const MaskConsts& k) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i coef_bg = _mm256_set1_epi32((kGrayG << 16) | kGrayB);
+    const __m256i coef_r = _mm256_set1_epi32(kGrayR);
+    const __m256i limit = _mm256_set1_epi32(k.sum_limit);
+
+    __m256i enemy = k.blue ? b : r, other = k.blue ? r : b;
+    __m256i diff_low = _mm256_cmpeq_epi8(_mm256_subs_epu8(_mm256_subs_epu8(enemy, other),
+                                                          _mm256_set1_epi8((char)k.diff)), zero);
+
+    __m256i b16 = _mm256_unpacklo_epi8(b, zero), g16 = _mm256_unpacklo_epi8(g, zero);
+    __m256i r16 = _mm256_unpacklo_epi8(r, zero);
+    __m256i s0 = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(b16, g16), coef_bg),
+                                  _mm256_madd_epi16(_mm256_unpacklo_epi16(r16, zero), coef_r));
+    __m256i s1 = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(b16, g16), coef_bg),
+                                  _mm256_madd_epi16(_mm256_unpackhi_epi16(r16, zero), coef_r));
+    b16 = _mm256_unpackhi_epi8(b, zero); g16 = _mm256_unpackhi_epi8(g, zero); r16 = _mm256_unpackhi_epi8(r, zero);
+    __m256i s2 = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(b16, g16), coef_bg),
+                                  _mm256_madd_epi16(_mm256_unpacklo_epi16(r16, zero), coef_r));
+    __m256i s3 = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(b16, g16), coef_bg),
+                                  _mm256_madd_epi16(_mm256_unpackhi_epi16(r16, zero), coef_r));
+    __m256i bright = _mm256_packs_epi16(
+        _mm256_packs_epi32(_mm256_cmpgt_epi32(s0, limit), _mm256_cmpgt_epi32(s1, limit)),
+        _mm256_packs_epi32(_mm256_cmpgt_epi32(s2, limit), _mm256_cmpgt_epi32(s3, limit)));
+    return _mm256_andnot_si256(diff_low, bright);
+}
+
+__attribute__((target("avx2")))
+static int maskRowAVX2(const uchar* bgr, uchar* mask, int x, int width, const MaskConsts& k) {
+    for (; x + 64 <= width; x += 64) {
+        const uchar* p = bgr + 3 * x;
+        __m256i v[6];
+        for (int i = 0; i < 6; i++) {
+            v[i] = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(p + 16 * i))),
+                _mm_loadu_si128((const __m128i*)(p + 96 + 16 * i)), 1);
+        }
+        for (int round = 0; round < 5; round++) {
+            __m256i t0 = _mm256_unpacklo_epi8(v[0], v[3]), t1 = _mm256_unpackhi_epi8(v[0], v[3]);
+            __m256i t2 = _mm256_unpacklo_epi8(v[1], v[4]), t3 = _mm256_unpackhi_epi8(v[1], v[4]);
+            __m256i t4 = _mm256_unpacklo_epi8(v[2], v[5]), t5 = _mm256_unpackhi_epi8(v[2], v[5]);
+            v[0] = t0; v[1] = t1; v[2] = t2; v[3] = t3; v[4] = t4; v[5] = t5;
+        }
+        // m0: 像素 0-15 | 32-47，m1: 像素 16-31 | 48-63
+        __m256i m0 = maskAVX2(v[0], v[2], v[4], k);
+        __m256i m1 = maskAVX2(v[1], v[3], v[5], k);
+        _mm256_storeu_si256((__m256i*)(mask + x), _mm256_permute2x128_si256(m0, m1, 0x20));
+        _mm256_storeu_si256((__m256i*)(mask + x + 32), _mm256_permute2x128_si256(m0, m1, 0x31));
+    }
+    return x;
+}
+#endif
+
+static void maskRow(const uchar* bgr, uchar* mask, int width, const MaskConsts& k) {
+    int x = 0;
+#ifdef CPU_AVX2_DISPATCH
+    if (cpuHasAVX2()) {
+        x = maskRowAVX2(bgr, mask, x, width, k);
+    }
+#endif
+#ifdef __SSE2__
+    x = maskRowSSE2(bgr, mask, x, width, k);
+#endif
+    for (; x < width; x++) {
+        mask[x] = maskPixel(bgr + 3 * x, k);
+    }
+}
+
+void colorDifferenceMaskRow(const uchar* bgr, uchar* mask, int width, const ColorMaskParams& params) {
+    maskRow(bgr, mask, width, MaskConsts(params));
+}
+
+void colorDifferenceMask(const Mat& bgr, Mat& mask, const ColorMaskParams& params) {
+    CV_Assert(bgr.type() == CV_8UC3);
+    CV_Assert(0 <= params.diff_threshold && params.diff_threshold <= 255);
+    CV_Assert(0 <= params.brightness_threshold && params.brightness_threshold <= 255);
+
+    mask.create(bgr.rows, bgr.cols, CV_8UC1);
+    const MaskConsts k(params);
+    int rows = bgr.rows, cols = bgr.cols;
+    // 输入输出都连续时整幅图当作一行，行尾不足一个向量的像素也走向量路径
+    if (bgr.isContinuous() && mask.isContinuous()) {
+        cols *= rows;
+        rows = 1;
+    }
+    for (int y = 0; y < rows; y++) {
+        maskRow(bgr.ptr<uchar>(y), mask.ptr<uchar>(y), cols, k);
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef ARMOR_COLOR_MASK_H
+#define ARMOR_COLOR_MASK_H
+
+#include <opencv2/opencv.hpp>
+
+// 敌方灯条颜色
+enum class EnemyColor { RED, BLUE };
+
+// 颜色差分二值化的参数，阈值都在 [0, 255] 内
+struct ColorMaskParams {
+    EnemyColor enemy;
+    int diff_threshold;           // 敌方通道减去另一通道（红 R-B，蓝 B-R，饱和减法）要大于它
+    int brightness_threshold;     // 灰度（与 COLOR_BGR2GRAY 相同）要大于它
+
+    ColorMaskParams(EnemyColor _enemy = EnemyColor::RED, int diff = 40, int brightness = 150)
+        : enemy(_enemy), diff_threshold(diff), brightness_threshold(brightness) {}
+};
+
+// 一次读入交错的 BGR，直接写出二值图：颜色差和亮度都超过阈值的像素为 255，其余为 0。
+// 结果与 split -> subtract -> threshold，cvtColor(BGR2GRAY) -> threshold，再 bitwise_and
+// 逐像素一致，但不产生任何中间图像。每行用 SSE2 / AVX2（运行时检测）一次处理 32 / 64 个像素。
+// bgr: CV_8UC3，可以是不连续的子区域；mask: 输出的 CV_8UC1（尺寸不变时复用内存）
+void colorDifferenceMask(const cv::Mat& bgr, cv::Mat& mask, const ColorMaskParams& params);
+
+// 单行版本，bgr 有 3 * width 个字节
+void colorDifferenceMaskRow(const uchar* bgr, uchar* mask, int width, const ColorMaskParams& params);
+
+#endif // ARMOR_COLOR_MASK_H
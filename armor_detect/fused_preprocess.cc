@@ -0,0 +1,121 @@
+#include "fused_preprocess.h"
+#include "mat_buffer.h"
+#include <algorithm>
+#include <unistd.h>
+
+using namespace cv;
+using namespace std;
+
+// 每块至少处理的行数，避免 halo 的重复计算占比过高
+static const int kMinTileRows = 32;
+
+// 块内每个像素需要的字节数：BGR 输入 3 + 灰度 1 + 浮点灰度 4 + 浮点均值 4
+// + 均值 1 + 二值 1 + 形态学临时 1 + 形态学竖直方向 1 + 输出 1
+static const int kBytesPerPixel = 17;
+
+FusedPreprocessor::FusedPreprocessor(size_t l2_bytes)
+    : l2_bytes_(l2_bytes ? l2_bytes : detectL2CacheSize()), tile_rows_(0) {
+    // 与 adaptiveThreshold 的 THRESH_BINARY 查找表相同: dst = src - mean > -ceil(C) ? 255 : 0
+    int idelta = kThresholdC;
+    for (int i = 0; i < 768; i++) {
+        tab_[i] = (uchar)(i - 255 > -idelta ? 255 : 0);
+    }
+}
+
+int FusedPreprocessor::haloRows() {
+    // 高斯窗口半径 + 膨胀、腐蚀、腐蚀、膨胀各自的半径
+    return kBlockSize / 2 + 4 * kMorphRadius;
+}
+
+size_t FusedPreprocessor::detectL2CacheSize() {
+    size_t l2 = 0;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    long v = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (v > 0) l2 = (size_t)v;
+#endif
+    return l2 ? l2 : 256 * 1024;
+}
+
+int FusedPreprocessor::computeTileRows(int cols) const {
+    int rows_fit = (int)(l2_bytes_ / ((size_t)cols * kBytesPerPixel));
+    return max(rows_fit - 2 * haloRows(), kMinTileRows);
+}
+
+void FusedPreprocessor::process(const Mat& frame, Mat& binary) {
+    CV_Assert(frame.type() == CV_8UC3);
+
+    const int rows = frame.rows;
+    const int cols = frame.cols;
+    const int halo = haloRows();
+
+    tile_rows_ = min(computeTileRows(cols), rows);
+    int buf_rows = min(tile_rows_ + 2 * halo, rows);
+
+    binary.create(rows, cols, CV_8UC1);
+    Mat gray_all = reserveBuffer(gray_buf_, buf_rows, cols, CV_8UC1);
+    Mat grayf_all = reserveBuffer(grayf_buf_, buf_rows, cols, CV_32FC1);
+    Mat meanf_all = reserveBuffer(meanf_buf_, buf_rows, cols, CV_32FC1);
+    Mat mean_all = reserveBuffer(mean_buf_, buf_rows, cols, CV_8UC1);
+    Mat bin_all = reserveBuffer(bin_buf_, buf_rows, cols, CV_8UC1);
+    Mat tmp_all = reserveBuffer(tmp_buf_, buf_rows, cols, CV_8UC1);
+
+    // 块缓冲区的视图与整帧不相连，所有滤波都用 BORDER_ISOLATED（morph:: 总是把输入当作独立图像），
+    // 图像上下边界处块从第 0 行/最后一行开始，边界处理与整帧调用一致；
+    // 块与块之间的边界误差最多传播 halo 行，被裁掉不输出。
+
+    for (int y0 = 0; y0 < rows; y0 += tile_rows_) {
+        int y1 = min(rows, y0 + tile_rows_);
+        int a = max(0, y0 - halo);
+        int b = min(rows, y1 + halo);
+        int n = b - a;
+
+        Mat gray = gray_all.rowRange(0, n);
+        Mat grayf = grayf_all.rowRange(0, n);
+        Mat meanf = meanf_all.rowRange(0, n);
+        Mat mean = mean_all.rowRange(0, n);
+        Mat bin = bin_all.rowRange(0, n);
+        Mat tmp = tmp_all.rowRange(0, n);
+
+        // adaptiveThreshold 对 8U 输入的高斯均值是在浮点上算的，这里保持同样的路径
+        cvtColor(frame.rowRange(a, b), gray, COLOR_BGR2GRAY);
+        gray.convertTo(grayf, CV_32F);
+        GaussianBlur(grayf, meanf, Size(kBlockSize, kBlockSize), 0, 0,
+                     BORDER_REPLICATE | BORDER_ISOLATED);
+        meanf.convertTo(mean, CV_8U);
+
+        for (int y = 0; y < n; y++) {
+            const uchar* s = gray.ptr<uchar>(y);
+            const uchar* m = mean.ptr<uchar>(y);
+            uchar* d = bin.ptr<uchar>(y);
+            for (int x = 0; x < cols; x++) {
+                d[x] = tab_[s[x] - m[x] + 255];
+            }
+        }
+
+        // 闭运算(膨胀+腐蚀) 接 开运算(腐蚀+膨胀)，中间两次 3x3 腐蚀合并为一次 5x5
+        morph_.dilate(bin, tmp, Size(3, 3));
+        morph_.erode(tmp, bin, Size(5, 5));
+        morph_.dilate(bin, tmp, Size(3, 3));
+
+        tmp.rowRange(y0 - a, y1 - a).copyTo(binary.rowRange(y0, y1));
+    }
+}
+
+void MeanPreprocessor::process(const Mat& frame, Mat& binary) {
+    CV_Assert(frame.type() == CV_8UC3);
+
+    const int rows = frame.rows;
+    const int cols = frame.cols;
+    gray_ = reserveBuffer(gray_buf_, rows, cols, CV_8UC1);
+    Mat tmp = reserveBuffer(tmp_buf_, rows, cols, CV_8UC1);
+    binary.create(rows, cols, CV_8UC1);
+
+    cvtColor(frame, gray_, COLOR_BGR2GRAY);
+    integral_.build(gray_, block_size_ / 2);
+    integral::adaptiveMeanThreshold(integral_, gray_, tmp, block_size_, FusedPreprocessor::kThresholdC);
+
+    // 和融合预处理一样：闭运算接开运算，中间两次 3x3 腐蚀合并为一次 5x5
+    morph_.dilate(tmp, binary, Size(3, 3));
+    morph_.erode(binary, tmp, Size(5, 5));
+    morph_.dilate(tmp, binary, Size(3, 3));
+}
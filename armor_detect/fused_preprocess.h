@@ -0,0 +1,82 @@
+#ifndef ARMOR_FUSED_PREPROCESS_H
+#define ARMOR_FUSED_PREPROCESS_H
+
+#include "morphology.h"
+#include "integral.h"
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+
+// 分块融合的预处理器
+// 与 cvtColor -> adaptiveThreshold(GAUSSIAN, 11, 2) -> MORPH_CLOSE -> MORPH_OPEN (3x3)
+// 的结果逐像素一致，但按 L2 大小的行块处理整帧：每块带上下 halo 行，
+// 块内的中间结果始终留在缓存里，整帧只读一次彩色图、写一次二值图。
+class FusedPreprocessor {
+public:
+    static const int kBlockSize = 11;      // 自适应阈值的窗口大小
+    static const int kThresholdC = 2;      // 自适应阈值的常数 C
+    static const int kMorphRadius = 1;     // 3x3 结构元素的半径
+
+    // l2_bytes 为 0 时自动探测 L2 缓存大小
+    explicit FusedPreprocessor(size_t l2_bytes = 0);
+
+    // frame: BGR 彩色图，binary: 输出的 CV_8UC1 二值图（尺寸不变时复用内存）
+    void process(const cv::Mat& frame, cv::Mat& binary);
+
+    // 最近一次处理所用的块行数（不含 halo）
+    int tileRows() const { return tile_rows_; }
+
+    // 每块上下各需要的 halo 行数
+    static int haloRows();
+
+    static size_t detectL2CacheSize();
+
+private:
+    int computeTileRows(int cols) const;
+
+    size_t l2_bytes_;
+    int tile_rows_;
+
+    // 块缓冲区，按 (tile_rows_ + 2 * halo) 行分配，只增不减，跨帧复用
+    cv::Mat gray_buf_;
+    cv::Mat grayf_buf_;
+    cv::Mat meanf_buf_;
+    cv::Mat mean_buf_;
+    cv::Mat bin_buf_;
+    cv::Mat tmp_buf_;
+
+    // 闭运算、开运算用的 van Herk / Gil-Werman 形态学，竖直方向的缓冲区同样跨帧复用
+    morph::Morphology morph_;
+    uchar tab_[768];
+};
+
+// 均值自适应阈值的预处理
+// 与 cvtColor -> adaptiveThreshold(MEAN_C, block_size, 2) -> MORPH_CLOSE -> MORPH_OPEN (3x3)
+// 的结果逐像素一致。整帧建一次积分图，阈值的耗时和窗口大小无关；建好的和表、平方和表
+// 留给后续环节查询任意框的亮度均值和方差，不用再各自统计。
+class MeanPreprocessor {
+public:
+    explicit MeanPreprocessor(int block_size = FusedPreprocessor::kBlockSize) : block_size_(block_size) {}
+
+    // 奇数，3 到 1023
+    void setBlockSize(int block_size) { block_size_ = block_size; }
+    int blockSize() const { return block_size_; }
+
+    // frame: BGR 彩色图，binary: 输出的 CV_8UC1 二值图（尺寸不变时复用内存）
+    void process(const cv::Mat& frame, cv::Mat& binary);
+
+    // 最近一次 process 的灰度图和积分图（扩边 blockSize() / 2，含平方和表）
+    const cv::Mat& gray() const { return gray_; }
+    const integral::IntegralImage& integralImage() const { return integral_; }
+
+private:
+    int block_size_;
+
+    // 缓冲区只增不减，ROI 窗口取左上角子区域
+    cv::Mat gray_buf_;
+    cv::Mat tmp_buf_;
+    cv::Mat gray_;
+    integral::IntegralImage integral_;
+    morph::Morphology morph_;
+};
+
+#endif // ARMOR_FUSED_PREPROCESS_H
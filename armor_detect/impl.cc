@@ -1,5 +1,7 @@
 #include "armor_detect.h"
-#include "../../include/utils.h"
+#include "utils.h"
+#include "trace.h"
+#include "iou_batch.h"
 #include <opencv2/opencv.hpp>
 #include <vector>
 #include <memory>
@@ -7,60 +9,63 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <cmath>
 
 using namespace cv;
 using namespace std;
 
+static inline double elapsedMs(int64 from, int64 to) {
+    return (to - from) * 1000.0 / getTickFrequency();
+}
+
 // 装甲板跟踪器类实现
 ArmorTracker::ArmorTracker(double iou_thresh, int max_miss) 
     : next_id_(0), iou_threshold_(iou_thresh), max_misses_(max_miss) {}
 
 double ArmorTracker::calculateIOU(const Rect& rect1, const Rect& rect2) {
-    int x_left = max(rect1.x, rect2.x);
-    int y_top = max(rect1.y, rect2.y);
-    int x_right = min(rect1.x + rect1.width, rect2.x + rect2.width);
-    int y_bottom = min(rect1.y + rect1.height, rect2.y + rect2.height);
-    
-    if (x_right < x_left || y_bottom < y_top) {
-        return 0.0;
-    }
-    
-    int intersection_area = (x_right - x_left) * (y_bottom - y_top);
-    int union_area = rect1.area() + rect2.area() - intersection_area;
-    
-    return static_cast<double>(intersection_area) / union_area;
+    // 和关联时批量计算的 IoU 逐位一致
+    return iou_batch::iou(rect1, rect2);
 }
 
-vector<TrackedArmor> ArmorTracker::update(const vector<pair<Rect, vector<Point2f>>>& detections) {
-    vector<bool> detection_matched(detections.size(), false);
-    vector<bool> tracker_matched(tracked_armors_.size(), false);
+const vector<TrackedArmor>& ArmorTracker::update(const vector<ArmorDetection>& detections, float dt) {
+    TRACE_SCOPE("ArmorTracker::update");
+    // 用预测框做关联，快速运动的目标在相邻帧之间 IoU 很低，但和预测框仍然重合
+    track_boxes_.clear();
+    for (auto& armor : tracked_armors_) {
+        armor.motion.predict(dt);
+        armor.predicted = armor.motion.box();
+        track_boxes_.push_back(armor.predicted);
+    }
+    detection_boxes_.clear();
+    for (const auto& detection : detections) {
+        detection_boxes_.push_back(detection.bbox);
+    }
+    
+    // 空间网格门控 + 匈牙利算法，求总 IoU 最大的一一匹配
+    associator_.associate(track_boxes_, detection_boxes_, iou_threshold_,
+                          track_to_detection_, detection_to_track_);
     
     for (size_t i = 0; i < tracked_armors_.size(); i++) {
-        double best_iou = iou_threshold_;
-        int best_detection_idx = -1;
-        
-        for (size_t j = 0; j < detections.size(); j++) {
-            if (detection_matched[j]) continue;
-            
-            double iou = calculateIOU(tracked_armors_[i].bbox, detections[j].first);
-            if (iou > best_iou) {
-                best_iou = iou;
-                best_detection_idx = j;
-            }
-        }
-        
-        if (best_detection_idx != -1) {
-            tracked_armors_[i].bbox = detections[best_detection_idx].first;
-            tracked_armors_[i].corners = detections[best_detection_idx].second;
-            tracked_armors_[i].hits++;
-            tracked_armors_[i].misses = 0;
-            tracked_armors_[i].age++;
-            
-            detection_matched[best_detection_idx] = true;
-            tracker_matched[i] = true;
+        int j = track_to_detection_[i];
+        TrackedArmor& armor = tracked_armors_[i];
+        if (j != -1) {
+            armor.motion.correct(detections[j].bbox);
+            armor.bbox = detections[j].bbox;
+            armor.corners.assign(detections[j].corners, detections[j].corners + 4);
+            armor.hits++;
+            armor.misses = 0;
+            armor.age++;
         } else {
-            tracked_armors_[i].misses++;
-            tracked_armors_[i].age++;
+            // 丢失期间沿预测滑行，角点跟着框中心一起平移
+            Point2f shift = (Point2f)(armor.predicted.tl() - armor.bbox.tl()) +
+                            Point2f((armor.predicted.width - armor.bbox.width) * 0.5f,
+                                    (armor.predicted.height - armor.bbox.height) * 0.5f);
+            for (auto& corner : armor.corners) {
+                corner += shift;
+            }
+            armor.bbox = armor.predicted;
+            armor.misses++;
+            armor.age++;
         }
     }
     
@@ -73,8 +78,9 @@ vector<TrackedArmor> ArmorTracker::update(const vector<pair<Rect, vector<Point2f
     );
     
     for (size_t i = 0; i < detections.size(); i++) {
-        if (!detection_matched[i]) {
-            tracked_armors_.emplace_back(next_id_++, detections[i].first, detections[i].second);
+        if (detection_to_track_[i] == -1) {
+            const ArmorDetection& d = detections[i];
+            tracked_armors_.emplace_back(next_id_++, d.bbox, vector<Point2f>(d.corners, d.corners + 4));
         }
     }
     
@@ -87,7 +93,10 @@ void ArmorTracker::clear() {
 }
 
 // 装甲板检测器类实现
-ArmorDetector::ArmorDetector() {
+ArmorDetector::ArmorDetector()
+    : pose_enabled_(true), pose_tolerance_(0.25), pose_solves_(0), pose_reuses_(0), roi_enabled_(false), full_scan_interval_(10), roi_expand_ratio_(1.0f),
+      frames_since_full_scan_(0), need_full_scan_(true), last_search_coverage_(1.0),
+      color_mode_(false), mean_mode_(false), label_mode_(false), frame_step_(1.f) {
     // 初始化相机参数
     camera_matrix_ = (Mat_<double>(3, 3) <<
         9.28130989e+02, 0, 3.77572945e+02,
@@ -109,26 +118,43 @@ ArmorDetector::ArmorDetector() {
     };
 }
 
-Mat ArmorDetector::preprocessFrame(const Mat& frame) {
-    Mat gray, binary;
-    cvtColor(frame, gray, COLOR_BGR2GRAY);
-    adaptiveThreshold(gray, binary, 255, ADAPTIVE_THRESH_GAUSSIAN_C, 
-                     THRESH_BINARY, 11, 2);
-    
-    Mat kernel = getStructuringElement(MORPH_RECT, Size(3, 3));
-    morphologyEx(binary, binary, MORPH_CLOSE, kernel);
-    morphologyEx(binary, binary, MORPH_OPEN, kernel);
-    
-    return binary;
+void ArmorDetector::preprocessFrame(const Mat& frame, Mat& binary) {
+    TRACE_SCOPE("ArmorDetector::preprocessFrame");
+    if (color_mode_) {
+        // 逐行读一次彩色图直接写出二值图，灯条本身是实心的，不再做形态学
+        colorDifferenceMask(frame, binary, color_params_);
+        return;
+    }
+    if (mean_mode_) {
+        // 整帧建一次积分图，均值阈值的耗时与窗口大小无关，积分图留给后续环节查询
+        mean_preprocessor_.process(frame, binary);
+        return;
+    }
+    // 灰度化、自适应阈值、闭运算、开运算在 L2 大小的行块内一次完成
+    preprocessor_.process(frame, binary);
 }
 
-vector<RotatedRect> ArmorDetector::findLightBars(const Mat& binary) {
-    vector<vector<Point>> contours;
-    vector<RotatedRect> light_bars;
-    
-    findContours(binary, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+void ArmorDetector::findLightBars(const Mat& binary, vector<RotatedRect>& light_bars, Point offset) {
+    TRACE_SCOPE("ArmorDetector::findLightBars");
+    if (label_mode_) {
+        // 一次扫描得到面积和二阶矩：小块、接近圆的块直接丢掉，剩下的用等效矩形。
+        // 和 RETR_EXTERNAL 一致，洞里的块不要
+        labeller_.label(binary, ctx_.components);
+        outer_filter_.compute(labeller_, ctx_.components, binary.size(), ctx_.outer);
+        for (size_t i = 0; i < ctx_.components.size(); i++) {
+            const ccl::Component& component = ctx_.components[i];
+            if (!ctx_.outer[i] || component.area < 100 || component.elongation() <= 2.0) continue;
+            RotatedRect rect = component.equivalentRect();
+            rect.center.x += offset.x;
+            rect.center.y += offset.y;
+            light_bars.push_back(rect);
+        }
+        return;
+    }
+    // contours 跨帧复用，findContours 只 resize 内外层 vector，容量够时不重新分配
+    findContours(binary, ctx_.contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
     
-    for (const auto& contour : contours) {
+    for (const auto& contour : ctx_.contours) {
         if (contourArea(contour) < 100) continue;
         
         RotatedRect rect = minAreaRect(contour);
@@ -136,92 +162,239 @@ vector<RotatedRect> ArmorDetector::findLightBars(const Mat& binary) {
         float aspect_ratio = max(size.width, size.height) / min(size.width, size.height);
         
         if (aspect_ratio > 2.0) {
+            rect.center.x += offset.x;
+            rect.center.y += offset.y;
             light_bars.push_back(rect);
         }
     }
-    
-    return light_bars;
 }
 
-vector<pair<RotatedRect, RotatedRect>> ArmorDetector::pairLightBars(const vector<RotatedRect>& light_bars) {
-    vector<pair<RotatedRect, RotatedRect>> pairs;
-    
-    for (size_t i = 0; i < light_bars.size(); i++) {
-        for (size_t j = i + 1; j < light_bars.size(); j++) {
-            const RotatedRect& bar1 = light_bars[i];
-            const RotatedRect& bar2 = light_bars[j];
-            
-            double distance = norm(bar1.center - bar2.center);
-            double angle_diff = abs(bar1.angle - bar2.angle);
-            
-            if (angle_diff < 15 && distance > 20 && distance < 200) {
-                pairs.push_back(make_pair(bar1, bar2));
-            }
+// 取灯条靠内一侧的两个顶点（左灯条取 x 最大的两个，右灯条取 x 最小的两个），按 y 升序输出
+static void innerEdge(const RotatedRect& bar, bool is_left, Point2f& top, Point2f& bottom) {
+    Point2f p[4];
+    bar.points(p);
+    for (int i = 1; i < 4; i++) {
+        for (int j = i; j > 0 && (is_left ? p[j].x > p[j - 1].x : p[j].x < p[j - 1].x); j--) {
+            swap(p[j], p[j - 1]);
         }
     }
-    
-    return pairs;
+    bool ordered = p[0].y <= p[1].y;
+    top = ordered ? p[0] : p[1];
+    bottom = ordered ? p[1] : p[0];
 }
 
-vector<Point2f> ArmorDetector::calculateArmorCorners(const RotatedRect& left_bar, const RotatedRect& right_bar) {
-    Point2f left_points[4], right_points[4];
-    left_bar.points(left_points);
-    right_bar.points(right_points);
-    
-    vector<Point2f> left_right_points;
-    for (int i = 0; i < 4; i++) {
-        if (left_points[i].x > left_bar.center.x) {
-            left_right_points.push_back(left_points[i]);
-        }
+void ArmorDetector::calculateArmorCorners(const RotatedRect& left_bar, const RotatedRect& right_bar,
+                                          Point2f corners[4]) {
+    innerEdge(left_bar, true, corners[0], corners[3]);
+    innerEdge(right_bar, false, corners[1], corners[2]);
+}
+
+bool ArmorDetector::estimatePose(const vector<Point2f>& corners, Vec3d& rvec, Vec3d& tvec,
+                                 bool use_guess) const {
+    // 事先排除会让 solvePnP 抛异常或发散的输入，热路径上不需要 try/catch
+    if (corners.size() != obj_points_.size()) return false;
+    double area2 = 0;
+    for (size_t i = 0; i < corners.size(); i++) {
+        const Point2f& a = corners[i];
+        const Point2f& b = corners[(i + 1) % corners.size()];
+        if (!std::isfinite(a.x) || !std::isfinite(a.y)) return false;
+        area2 += (double)a.x * b.y - (double)b.x * a.y;
     }
+    if (std::fabs(area2) < 2.0) return false;
     
-    vector<Point2f> right_left_points;
-    for (int i = 0; i < 4; i++) {
-        if (right_points[i].x < right_bar.center.x) {
-            right_left_points.push_back(right_points[i]);
+    if (!solvePnP(obj_points_, corners, camera_matrix_, dist_coeffs_, rvec, tvec, use_guess, SOLVEPNP_ITERATIVE)) {
+        return false;
+    }
+    // 装甲板必须在相机前方
+    return std::isfinite(tvec[2]) && tvec[2] > 0;
+}
+
+void ArmorDetector::updatePose(TrackedArmor& armor) {
+    if (armor.pose_valid && armor.pose_corners.size() == armor.corners.size()) {
+        float max_shift = 0.f;
+        for (size_t i = 0; i < armor.corners.size(); i++) {
+            Point2f d = armor.corners[i] - armor.pose_corners[i];
+            max_shift = max(max_shift, max(std::fabs(d.x), std::fabs(d.y)));
+        }
+        if (max_shift < pose_tolerance_) {
+            pose_reuses_++;
+            return;
         }
     }
     
-    sort(left_right_points.begin(), left_right_points.end(), 
-         [](const Point2f& a, const Point2f& b) { return a.y < b.y; });
-    sort(right_left_points.begin(), right_left_points.end(), 
-         [](const Point2f& a, const Point2f& b) { return a.y < b.y; });
-    
-    vector<Point2f> corners = {
-        left_right_points[0],
-        right_left_points[0],
-        right_left_points[1],
-        left_right_points[1]
-    };
+    // 同一个目标相邻帧的位姿很接近，上一帧的解作为迭代初值；热启动失败再冷启动一次
+    Vec3d rvec = armor.rvec, tvec = armor.tvec;
+    bool ok = armor.pose_valid && estimatePose(armor.corners, rvec, tvec, true);
+    if (!ok) {
+        ok = estimatePose(armor.corners, rvec, tvec, false);
+    }
+    pose_solves_++;
     
-    return corners;
+    armor.pose_valid = ok;
+    if (ok) {
+        armor.rvec = rvec;
+        armor.tvec = tvec;
+        armor.pose_corners = armor.corners;
+    }
 }
 
-bool ArmorDetector::estimatePose(const vector<Point2f>& corners, Vec3d& rvec, Vec3d& tvec) {
-    try {
-        return solvePnP(obj_points_, corners, camera_matrix_, dist_coeffs_, rvec, tvec);
-    } catch (const Exception& e) {
-        cerr << "Pose estimation error: " << e.what() << endl;
-        return false;
+void ArmorDetector::updatePoses() {
+    TRACE_SCOPE("ArmorDetector::updatePoses");
+    for (auto& armor : tracker_.tracks()) {
+        if (pose_enabled_) {
+            updatePose(armor);
+        } else {
+            armor.pose_valid = false;
+        }
+    }
+}
+
+void ArmorDetector::buildDetections(const vector<RotatedRect>& light_bars, vector<ArmorDetection>& detections) {
+    TRACE_SCOPE("ArmorDetector::buildDetections");
+    // 按网格和角度区间查找候选，只比较可能配对的灯条
+    pairer_.findPairs(light_bars, ctx_.pairs);
+    
+    detections.resize(ctx_.pairs.size());
+    for (size_t k = 0; k < ctx_.pairs.size(); k++) {
+        ArmorDetection& d = detections[k];
+        calculateArmorCorners(light_bars[ctx_.pairs[k].first], light_bars[ctx_.pairs[k].second], d.corners);
+        // 以角点数组为数据的 Mat 头不拥有内存，不会分配
+        d.bbox = boundingRect(Mat(4, 1, CV_32FC2, d.corners));
+    }
+}
+
+void ArmorDetector::setRoiMode(bool enabled, int full_scan_interval, float expand_ratio) {
+    roi_enabled_ = enabled;
+    full_scan_interval_ = max(1, full_scan_interval);
+    roi_expand_ratio_ = expand_ratio;
+    need_full_scan_ = true;
+}
+
+void ArmorDetector::setColorMode(bool enabled, const ColorMaskParams& params) {
+    color_mode_ = enabled;
+    color_params_ = params;
+}
+
+void ArmorDetector::setMeanThresholdMode(bool enabled, int block_size) {
+    CV_Assert(block_size % 2 == 1 && block_size > 1 && block_size <= 1023);
+    mean_mode_ = enabled;
+    mean_preprocessor_.setBlockSize(block_size);
+}
+
+void ArmorDetector::mergeSearchWindows(vector<Rect>& windows) {
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < windows.size() && !merged; i++) {
+            for (size_t j = i + 1; j < windows.size(); j++) {
+                if ((windows[i] & windows[j]).area() > 0) {
+                    windows[i] |= windows[j];
+                    windows.erase(windows.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void ArmorDetector::computeSearchWindows(const Size& frame_size) {
+    const Rect frame_rect(0, 0, frame_size.width, frame_size.height);
+    // 灯条在装甲板 bbox 外侧，窗口至少要多留出这么多像素
+    const int min_margin = 32;
+    
+    search_windows_.clear();
+    for (const auto& armor : tracker_.tracks()) {
+        int dx = max(min_margin, cvRound(armor.bbox.width * roi_expand_ratio_));
+        int dy = max(min_margin, cvRound(armor.bbox.height * roi_expand_ratio_));
+        Rect window(armor.bbox.x - dx, armor.bbox.y - dy,
+                    armor.bbox.width + 2 * dx, armor.bbox.height + 2 * dy);
+        window &= frame_rect;
+        if (window.area() > 0) {
+            search_windows_.push_back(window);
+        }
+    }
+    mergeSearchWindows(search_windows_);
+}
+
+void ArmorDetector::findLightBarsInWindows(const Mat& frame, vector<RotatedRect>& light_bars) {
+    light_bars.clear();
+    if (ctx_.window_binary.rows < frame.rows || ctx_.window_binary.cols < frame.cols) {
+        ctx_.window_binary.create(frame.rows, frame.cols, CV_8UC1);
+    }
+    for (const auto& window : search_windows_) {
+        // 窗口二值图是同一块缓冲区的左上角子区域，尺寸相同时 process 不会重新分配
+        Mat binary = ctx_.window_binary(Rect(0, 0, window.width, window.height));
+        int64 t0 = getTickCount();
+        preprocessFrame(frame(window), binary);
+        int64 t1 = getTickCount();
+        findLightBars(binary, light_bars, window.tl());
+        int64 t2 = getTickCount();
+        stage_times_.preprocess += elapsedMs(t0, t1);
+        stage_times_.find_light_bars += elapsedMs(t1, t2);
     }
 }
 
-vector<TrackedArmor> ArmorDetector::processFrame(const Mat& frame) {
-    Mat binary = preprocessFrame(frame);
-    vector<RotatedRect> light_bars = findLightBars(binary);
-    vector<pair<RotatedRect, RotatedRect>> light_pairs = pairLightBars(light_bars);
+const vector<TrackedArmor>& ArmorDetector::processFrame(const Mat& frame) {
+    TRACE_SCOPE("ArmorDetector::processFrame");
+    vector<RotatedRect>& light_bars = ctx_.light_bars;
+    stage_times_ = ArmorStageTimes();
+    
+    bool full_scan = !roi_enabled_ || need_full_scan_ || tracker_.tracks().empty() ||
+                     frames_since_full_scan_ + 1 >= full_scan_interval_;
+    if (!full_scan) {
+        computeSearchWindows(frame.size());
+        full_scan = search_windows_.empty();
+    }
     
-    vector<pair<Rect, vector<Point2f>>> detections;
-    for (const auto& pair : light_pairs) {
-        vector<Point2f> corners = calculateArmorCorners(pair.first, pair.second);
-        Rect bbox = boundingRect(corners);
-        detections.push_back(make_pair(bbox, corners));
+    if (full_scan) {
+        int64 t0 = getTickCount();
+        preprocessFrame(frame, ctx_.binary);
+        int64 t1 = getTickCount();
+        light_bars.clear();
+        findLightBars(ctx_.binary, light_bars);
+        int64 t2 = getTickCount();
+        stage_times_.preprocess = elapsedMs(t0, t1);
+        stage_times_.find_light_bars = elapsedMs(t1, t2);
+        search_windows_.assign(1, Rect(0, 0, frame.cols, frame.rows));
+        frames_since_full_scan_ = 0;
+        last_search_coverage_ = 1.0;
+    } else {
+        findLightBarsInWindows(frame, light_bars);
+        frames_since_full_scan_++;
+        
+        double area = 0;
+        for (const auto& window : search_windows_) {
+            area += window.area();
+        }
+        last_search_coverage_ = area / ((double)frame.rows * frame.cols);
     }
     
-    return tracker_.update(detections);
+    int64 t0 = getTickCount();
+    buildDetections(light_bars, ctx_.detections);
+    int64 t1 = getTickCount();
+    const vector<TrackedArmor>& armors = tracker_.update(ctx_.detections, frame_step_);
+    int64 t2 = getTickCount();
+    updatePoses();
+    int64 t3 = getTickCount();
+    stage_times_.pair_light_bars = elapsedMs(t0, t1);
+    stage_times_.tracker = elapsedMs(t1, t2);
+    stage_times_.pose = elapsedMs(t2, t3);
+    
+    // 有目标没匹配上，说明它可能已经离开了窗口，下一帧全图重新捕获
+    need_full_scan_ = false;
+    for (const auto& armor : armors) {
+        if (armor.misses > 0) {
+            need_full_scan_ = true;
+            break;
+        }
+    }
+    
+    return armors;
 }
 
-void ArmorDetector::drawResults(Mat& frame, const vector<TrackedArmor>& armors) {
+#ifndef ARMOR_HEADLESS
+void ArmorDetector::drawResults(Mat& frame, const vector<TrackedArmor>& armors) const {
     // 首先绘制装甲板轮廓
     drawArmorContours(frame, armors);
     
@@ -244,27 +417,23 @@ void ArmorDetector::drawResults(Mat& frame, const vector<TrackedArmor>& armors)
         putText(frame, status, Point(armor.bbox.x, armor.bbox.y + armor.bbox.height + 20),
                FONT_HERSHEY_SIMPLEX, 0.5, Scalar(255, 255, 255), 1);
         
-        // 计算并绘制3D姿态
-        Vec3d rvec, tvec;
-        if (estimatePose(armor.corners, rvec, tvec)) {
+        // 绘制 processFrame 中求出的3D姿态
+        if (armor.pose_valid) {
             // 绘制坐标轴
-            drawCoordinateAxes(frame, rvec, tvec);
+            drawCoordinateAxes(frame, armor.rvec, armor.tvec);
             
             // 获取姿态信息字符串
-            string pose_info = getPoseInfo(tvec, rvec);
+            string pose_info = getPoseInfo(armor.tvec, armor.rvec);
             
             // 在图像上显示姿态信息
             putText(frame, pose_info, Point(armor.bbox.x, armor.bbox.y + armor.bbox.height + 40),
                    FONT_HERSHEY_SIMPLEX, 0.5, Scalar(255, 255, 255), 1);
-            
-            // 在控制台输出姿态信息（可选）
-            cout << "装甲板 " << armor.id << " 姿态信息: " << pose_info << endl;
         }
     }
 }
 
 // 新增：绘制装甲板轮廓
-void ArmorDetector::drawArmorContours(Mat& frame, const vector<TrackedArmor>& armors) {
+void ArmorDetector::drawArmorContours(Mat& frame, const vector<TrackedArmor>& armors) const {
     for (const auto& armor : armors) {
         // 将角点转换为整数类型，用于绘制轮廓
         vector<Point> int_corners;
@@ -290,7 +459,7 @@ void ArmorDetector::drawArmorContours(Mat& frame, const vector<TrackedArmor>& ar
 }
 
 // 新增：获取姿态信息的字符串
-string ArmorDetector::getPoseInfo(const Vec3d& tvec, const Vec3d& rvec) {
+string ArmorDetector::getPoseInfo(const Vec3d& tvec, const Vec3d& rvec) const {
     stringstream ss;
     
     // 设置输出精度
@@ -305,7 +474,7 @@ string ArmorDetector::getPoseInfo(const Vec3d& tvec, const Vec3d& rvec) {
     return ss.str();
 }
 
-void ArmorDetector::drawCoordinateAxes(Mat& frame, const Vec3d& rvec, const Vec3d& tvec) {
+void ArmorDetector::drawCoordinateAxes(Mat& frame, const Vec3d& rvec, const Vec3d& tvec) const {
     vector<Point3f> axis_points = {
         Point3f(0, 0, 0),
         Point3f(0.1, 0, 0),
@@ -325,4 +494,5 @@ void ArmorDetector::drawCoordinateAxes(Mat& frame, const Vec3d& rvec, const Vec3
     putText(frame, "X", image_points[1], FONT_HERSHEY_SIMPLEX, 0.6, Scalar(0, 0, 255), 2);
     putText(frame, "Y", image_points[2], FONT_HERSHEY_SIMPLEX, 0.6, Scalar(0, 255, 0), 2);
     putText(frame, "Z", image_points[3], FONT_HERSHEY_SIMPLEX, 0.6, Scalar(255, 0, 0), 2);
-}
\ No newline at end of file
+}
+#endif // ARMOR_HEADLESS
@@ -0,0 +1,96 @@
+#include "light_bar_pairing.h"
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+// 格子边长略大于最大配对距离，保证距离小于 kMaxDistance 的两根灯条
+// 在浮点误差下也一定落在相邻格子里
+static const float kCellSize = LightBarPairer::kMaxDistance + 1.0f;
+
+// 角度区间两端的余量，候选最后仍用 match() 精确判断
+static const float kAngleSlack = 1e-3f;
+
+void LightBarPairer::findPairsBruteForce(const vector<RotatedRect>& bars, vector<pair<int, int>>& out) {
+    out.clear();
+    for (size_t i = 0; i < bars.size(); i++) {
+        for (size_t j = i + 1; j < bars.size(); j++) {
+            if (match(bars[i], bars[j])) {
+                out.push_back(make_pair((int)i, (int)j));
+            }
+        }
+    }
+}
+
+void LightBarPairer::findPairs(const vector<RotatedRect>& bars, vector<pair<int, int>>& out) {
+    out.clear();
+    const int n = (int)bars.size();
+    if (n < 2) return;
+
+    float min_x = bars[0].center.x, min_y = bars[0].center.y;
+    float max_x = min_x, max_y = min_y;
+    for (int i = 1; i < n; i++) {
+        min_x = min(min_x, bars[i].center.x);
+        min_y = min(min_y, bars[i].center.y);
+        max_x = max(max_x, bars[i].center.x);
+        max_y = max(max_y, bars[i].center.y);
+    }
+    const int grid_w = (int)((max_x - min_x) / kCellSize) + 1;
+    const int grid_h = (int)((max_y - min_y) / kCellSize) + 1;
+
+    // 计数 -> 前缀和 -> 填充
+    cell_of_.resize(n);
+    cell_start_.assign(grid_w * grid_h + 1, 0);
+    for (int i = 0; i < n; i++) {
+        int gx = (int)((bars[i].center.x - min_x) / kCellSize);
+        int gy = (int)((bars[i].center.y - min_y) / kCellSize);
+        cell_of_[i] = gy * grid_w + gx;
+        cell_start_[cell_of_[i] + 1]++;
+    }
+    for (int c = 0; c < grid_w * grid_h; c++) {
+        cell_start_[c + 1] += cell_start_[c];
+    }
+    order_.resize(n);
+    candidates_.assign(cell_start_.begin(), cell_start_.end() - 1);
+    for (int i = 0; i < n; i++) {
+        order_[candidates_[cell_of_[i]]++] = i;
+    }
+
+    // 每个格子内按角度排序，便于按角度区间二分
+    for (int c = 0; c < grid_w * grid_h; c++) {
+        sort(order_.begin() + cell_start_[c], order_.begin() + cell_start_[c + 1],
+             [&bars](int a, int b) { return bars[a].angle < bars[b].angle; });
+    }
+    sorted_angle_.resize(n);
+    for (int k = 0; k < n; k++) {
+        sorted_angle_[k] = bars[order_[k]].angle;
+    }
+
+    for (int i = 0; i < n; i++) {
+        const int gx = cell_of_[i] % grid_w;
+        const int gy = cell_of_[i] / grid_w;
+        const float lo = bars[i].angle - kMaxAngleDiff - kAngleSlack;
+        const float hi = bars[i].angle + kMaxAngleDiff + kAngleSlack;
+
+        candidates_.clear();
+        for (int y = max(gy - 1, 0); y <= min(gy + 1, grid_h - 1); y++) {
+            for (int x = max(gx - 1, 0); x <= min(gx + 1, grid_w - 1); x++) {
+                int c = y * grid_w + x;
+                auto first = sorted_angle_.begin() + cell_start_[c];
+                auto last = sorted_angle_.begin() + cell_start_[c + 1];
+                for (auto it = lower_bound(first, last, lo); it != last && *it <= hi; ++it) {
+                    int j = order_[it - sorted_angle_.begin()];
+                    if (j > i && match(bars[i], bars[j])) {
+                        candidates_.push_back(j);
+                    }
+                }
+            }
+        }
+
+        // 同一个 i 的配对按 j 升序输出，与两重循环的顺序一致
+        sort(candidates_.begin(), candidates_.end());
+        for (int j : candidates_) {
+            out.push_back(make_pair(i, j));
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef ARMOR_LIGHT_BAR_PAIRING_H
+#define ARMOR_LIGHT_BAR_PAIRING_H
+
+#include <opencv2/opencv.hpp>
+#include <utility>
+#include <vector>
+
+// 灯条配对
+// 灯条按中心点放进边长为最大配对距离的网格，每个格子里按角度排序；
+// 对每根灯条只在相邻 3x3 个格子里、按角度区间二分出来的候选中判断，
+// 避免所有灯条两两比较。输出与两重循环完全一致。
+class LightBarPairer {
+public:
+    static const int kMinDistance = 20;
+    static const int kMaxDistance = 200;
+    static const int kMaxAngleDiff = 15;
+
+    // 两根灯条能否配成一对，判据与原来的两重循环相同
+    static bool match(const cv::RotatedRect& bar1, const cv::RotatedRect& bar2) {
+        double distance = cv::norm(bar1.center - bar2.center);
+        double angle_diff = std::abs(bar1.angle - bar2.angle);
+        return angle_diff < kMaxAngleDiff && distance > kMinDistance && distance < kMaxDistance;
+    }
+
+    // 输出下标对 (i, j)，i < j，按 (i, j) 字典序排列
+    void findPairs(const std::vector<cv::RotatedRect>& bars, std::vector<std::pair<int, int>>& out);
+
+    // 两重循环的参考实现
+    static void findPairsBruteForce(const std::vector<cv::RotatedRect>& bars,
+                                    std::vector<std::pair<int, int>>& out);
+
+private:
+    // 网格用 CSR 形式存放：cell_start_[c] .. cell_start_[c + 1] 是格子 c 在 order_ 中的区间
+    std::vector<int> cell_of_;
+    std::vector<int> cell_start_;
+    std::vector<int> order_;
+    std::vector<float> sorted_angle_;
+    std::vector<int> candidates_;
+};
+
+#endif // ARMOR_LIGHT_BAR_PAIRING_H
@@ -0,0 +1,228 @@
+#include "pipeline.h"
+#include "trace.h"
+
+using namespace cv;
+using namespace std;
+
+static const char* kStageNames[ArmorPipeline::kStages] = {
+    "preprocess", "findLightBars", "pairLightBars", "tracker"
+};
+
+// 等队列时先 yield 这么多次再睡眠，帧间隔很短时不用进出内核
+static const int kSpinRounds = 64;
+
+// trace 里显示的线程名
+static const char* kStageThreadNames[ArmorPipeline::kStages] = {
+    "pipeline/preprocess", "pipeline/findLightBars", "pipeline/pairLightBars", "pipeline/tracker"
+};
+
+ArmorPipeline::ArmorPipeline(ArmorDetector& detector, size_t queue_capacity)
+    : detector_(detector), output_done_(false),
+      next_seq_(0), expected_track_seq_(0), start_ticks_(0), stop_ticks_(0),
+      running_(false) {
+    for (int i = 0; i <= kStages; i++) {
+        queues_.emplace_back(new SpscQueue<PipelineFrame>(queue_capacity));
+    }
+}
+
+ArmorPipeline::~ArmorPipeline() {
+    stop();
+}
+
+template <typename Ready>
+void ArmorPipeline::waitOn(int queue, Ready ready) {
+    for (int i = 0; i < kSpinRounds; i++) {
+        if (ready()) return;
+        this_thread::yield();
+    }
+    unique_lock<mutex> lock(signals_[queue].mutex);
+    signals_[queue].cv.wait(lock, ready);
+}
+
+void ArmorPipeline::notify(int queue) {
+    // 先拿一下锁：等待方检查条件和睡下之间不会漏掉这次通知
+    { lock_guard<mutex> lock(signals_[queue].mutex); }
+    signals_[queue].cv.notify_all();
+}
+
+void ArmorPipeline::start() {
+    if (running_) return;
+
+    for (int i = 0; i < kStages; i++) {
+        counters_[i].busy_ticks = 0;
+        counters_[i].processed = 0;
+        counters_[i].depth_sum = 0;
+        counters_[i].upstream_done = false;
+    }
+    output_done_ = false;
+    start_ticks_ = getTickCount();
+    running_ = true;
+
+    for (int i = 0; i < kStages; i++) {
+        workers_.emplace_back(&ArmorPipeline::runStage, this, i);
+    }
+}
+
+void ArmorPipeline::stop() {
+    if (!running_) return;
+
+    // 第 0 级的上游就是 submit，标记结束后各级处理完剩余的帧依次退出。
+    // 跟踪级在输出队列满时会等，这里一直把结果挪走直到它退出
+    counters_[0].upstream_done.store(true, memory_order_release);
+    notify(0);
+    SpscQueue<PipelineFrame>& output = *queues_[kStages];
+    while (!output_done_.load(memory_order_acquire)) {
+        drainOutput();
+        waitOn(kStages, [&] { return output_done_.load(memory_order_acquire) || output.size() > 0; });
+    }
+    drainOutput();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+
+    stop_ticks_ = getTickCount();
+    running_ = false;
+}
+
+int64_t ArmorPipeline::submit(const Mat& frame, bool block) {
+    PipelineFrame item;
+    item.seq = next_seq_;
+    item.frame = frame;
+
+    SpscQueue<PipelineFrame>& input = *queues_[0];
+    SpscQueue<PipelineFrame>& output = *queues_[kStages];
+    while (!input.tryPush(std::move(item))) {
+        if (!block) return -1;
+        // 调用方可能就是 poll 所在的线程，不挪走结果的话跟踪级会卡在满的输出队列上。
+        // 跟踪级输出结果时也会叫醒这里
+        drainOutput();
+        waitOn(0, [&] { return input.size() < input.capacity() || output.size() > 0; });
+    }
+    notify(0);
+    return (int64_t)next_seq_++;
+}
+
+void ArmorPipeline::drainOutput() {
+    {
+        lock_guard<mutex> lock(output_mutex_);
+        PipelineFrame item;
+        while (queues_[kStages]->tryPop(item)) {
+            pending_.push_back(std::move(item));
+        }
+    }
+    notify(kStages);
+}
+
+bool ArmorPipeline::poll(PipelineResult& result) {
+    PipelineFrame item;
+    {
+        // pending_ 里的结果都比输出队列里的早
+        lock_guard<mutex> lock(output_mutex_);
+        if (!pending_.empty()) {
+            item = std::move(pending_.front());
+            pending_.pop_front();
+        } else if (!queues_[kStages]->tryPop(item)) {
+            return false;
+        }
+    }
+    notify(kStages);
+    result.seq = item.seq;
+    result.armors.swap(item.armors);
+    return true;
+}
+
+void ArmorPipeline::processStage(int stage, PipelineFrame& item) {
+    switch (stage) {
+    case 0:
+        detector_.preprocessFrame(item.frame, item.binary);
+        break;
+    case 1:
+        item.light_bars.clear();
+        detector_.findLightBars(item.binary, item.light_bars);
+        break;
+    case 2:
+        detector_.buildDetections(item.light_bars, item.detections);
+        break;
+    case 3:
+        // 队列是 FIFO 的，跟踪一定按帧序进行，乱序说明流水线本身坏了
+        CV_Assert(item.seq == expected_track_seq_);
+        expected_track_seq_ = item.seq + 1;
+        detector_.tracker_.update(item.detections, detector_.frame_step_);
+        detector_.updatePoses();
+        item.armors = detector_.tracker_.tracks();
+        item.frame.release();
+        item.binary.release();
+        break;
+    default:
+        break;
+    }
+}
+
+void ArmorPipeline::runStage(int stage) {
+    SpscQueue<PipelineFrame>& in = *queues_[stage];
+    SpscQueue<PipelineFrame>& out = *queues_[stage + 1];
+    StageCounters& counters = counters_[stage];
+    const bool last = stage == kStages - 1;
+    PipelineFrame item;
+    TRACE_THREAD_NAME(kStageThreadNames[stage]);
+
+    auto has_input = [&] { return in.size() > 0 || counters.upstream_done.load(memory_order_acquire); };
+    while (true) {
+        size_t depth = in.size();
+        if (!in.tryPop(item)) {
+            if (!counters.upstream_done.load(memory_order_acquire)) {
+                waitOn(stage, has_input);
+                continue;
+            }
+            // 上游已结束，再确认一次队列确实空了
+            if (!in.tryPop(item)) break;
+            depth = 1;
+        }
+        notify(stage);
+        counters.depth_sum += depth;
+
+        int64_t t0 = getTickCount();
+        processStage(stage, item);
+        counters.busy_ticks += getTickCount() - t0;
+        counters.processed++;
+
+        // 下游（最后一级是调用方）取走之前一直等，不丢帧
+        while (!out.tryPush(std::move(item))) {
+            waitOn(stage + 1, [&] { return out.size() < out.capacity(); });
+        }
+        notify(stage + 1);
+        // 阻塞的 submit 睡在输入队列上，有结果可挪时也要叫醒它
+        if (last) notify(0);
+    }
+
+    if (!last) {
+        counters_[stage + 1].upstream_done.store(true, memory_order_release);
+    } else {
+        output_done_.store(true, memory_order_release);
+    }
+    notify(stage + 1);
+}
+
+vector<PipelineStageStats> ArmorPipeline::stats() const {
+    vector<PipelineStageStats> res;
+    int64_t elapsed = (running_ ? getTickCount() : stop_ticks_) - start_ticks_;
+    double freq = getTickFrequency();
+
+    for (int i = 0; i < kStages; i++) {
+        const StageCounters& c = counters_[i];
+        PipelineStageStats s;
+        uint64_t processed = c.processed.load();
+        int64_t busy = c.busy_ticks.load();
+
+        s.name = kStageNames[i];
+        s.queue_depth = queues_[i]->size();
+        s.queue_capacity = queues_[i]->capacity();
+        s.avg_queue_depth = processed ? (double)c.depth_sum.load() / processed : 0.0;
+        s.occupancy = elapsed > 0 ? (double)busy / elapsed : 0.0;
+        s.avg_ms = processed ? busy * 1000.0 / freq / processed : 0.0;
+        s.processed = processed;
+        res.push_back(s);
+    }
+    return res;
+}
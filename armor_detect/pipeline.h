@@ -0,0 +1,124 @@
+#ifndef ARMOR_PIPELINE_H
+#define ARMOR_PIPELINE_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "armor_detect.h"
+#include "spsc_queue.h"
+
+// 在流水线各级之间传递的帧
+struct PipelineFrame {
+    uint64_t seq;
+    cv::Mat frame;
+    cv::Mat binary;
+    std::vector<cv::RotatedRect> light_bars;
+    std::vector<ArmorDetection> detections;
+    std::vector<TrackedArmor> armors;
+
+    PipelineFrame() : seq(0) {}
+};
+
+// 流水线输出
+struct PipelineResult {
+    uint64_t seq;
+    std::vector<TrackedArmor> armors;
+
+    PipelineResult() : seq(0) {}
+};
+
+// 每一级的运行统计
+struct PipelineStageStats {
+    std::string name;
+    size_t queue_depth;       // 该级输入队列的当前深度
+    size_t queue_capacity;
+    double avg_queue_depth;   // 每次取帧时输入队列深度的平均值
+    double occupancy;         // 忙碌时间占运行时间的比例
+    double avg_ms;            // 每帧平均耗时
+    uint64_t processed;
+};
+
+// 多级线程流水线
+// 预处理、找灯条、灯条配对+角点、跟踪各占一个线程，级间用有界 SPSC 队列连接。
+// 队列是 FIFO 的，跟踪级按 seq 顺序收到帧；submit 和 poll 各自只能在一个线程里调用。
+// 运行期间不要再对同一个 ArmorDetector 调用 processFrame。
+//
+// 已提交的帧都会有结果，不会丢：输出队列满了跟踪级就等着；阻塞的 submit 和 stop 在等待时
+// 把输出队列里的结果挪到内部缓冲区，所以调用方不 poll 也不会卡死。poll 先取缓冲区再取输出队列，
+// 结果始终按 seq 顺序。stop 之后继续 poll 直到返回 false 即可取完所有结果。
+//
+// 等队列（空或满）时先 yield 自旋一小段，还等不到就睡在该队列的条件变量上，
+// 帧源比流水线慢时空闲的级不占 CPU；每次 push / pop 之后叫醒队列另一端。
+class ArmorPipeline {
+public:
+    static const int kStages = 4;
+
+    explicit ArmorPipeline(ArmorDetector& detector, size_t queue_capacity = 4);
+    ~ArmorPipeline();
+
+    void start();
+    // 等已提交的帧全部流过后停止，还没取走的结果留给 poll
+    void stop();
+
+    // 提交一帧，返回该帧的 seq；block 为 false 且输入队列已满时返回 -1。
+    // 阻塞等待期间会把输出队列里的结果挪到内部缓冲区，调用方一直不 poll 时缓冲区会一直变大。
+    // 流水线只持有 frame 的浅拷贝，帧处理完之前调用方不能改写它的像素
+    int64_t submit(const cv::Mat& frame, bool block = true);
+
+    // 取一个结果，没有结果时返回 false
+    bool poll(PipelineResult& result);
+
+    std::vector<PipelineStageStats> stats() const;
+
+private:
+    struct StageCounters {
+        std::atomic<int64_t> busy_ticks;
+        std::atomic<uint64_t> processed;
+        std::atomic<uint64_t> depth_sum;
+        std::atomic<bool> upstream_done;
+
+        StageCounters() : busy_ticks(0), processed(0), depth_sum(0), upstream_done(false) {}
+    };
+
+    // 一个队列两端共用的等待：消费端等非空（或上游结束），生产端等不满
+    struct QueueSignal {
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    // 先自旋再睡眠，直到 ready() 为真；queue 是 ready 依赖的队列
+    template <typename Ready>
+    void waitOn(int queue, Ready ready);
+    // queue 的状态变了（push、pop 或上游结束），叫醒等在它上面的线程
+    void notify(int queue);
+
+    void runStage(int stage);
+    void processStage(int stage, PipelineFrame& item);
+    // 把输出队列里的结果挪到 pending_
+    void drainOutput();
+
+    ArmorDetector& detector_;
+    // queues_[i] 是第 i 级的输入，queues_[kStages] 是输出
+    std::vector<std::unique_ptr<SpscQueue<PipelineFrame>>> queues_;
+    QueueSignal signals_[kStages + 1];
+    StageCounters counters_[kStages];
+    std::vector<std::thread> workers_;
+
+    std::atomic<bool> output_done_;     // 跟踪级已退出，输出队列不会再有新结果
+    std::mutex output_mutex_;           // 输出队列的消费端可能是 submit、stop 或 poll
+    std::deque<PipelineFrame> pending_;
+    uint64_t next_seq_;
+    uint64_t expected_track_seq_;
+    int64_t start_ticks_;
+    int64_t stop_ticks_;
+    bool running_;
+};
+
+#endif // ARMOR_PIPELINE_H
@@ -0,0 +1,75 @@
+#include "renderer.h"
+#include "trace.h"
+
+using namespace cv;
+using namespace std;
+
+ArmorRenderer::ArmorRenderer(const ArmorDetector& detector, Sink sink)
+    : detector_(detector), sink_(sink), running_(false), rendered_(0), dropped_(0) {}
+
+ArmorRenderer::~ArmorRenderer() {
+    stop();
+}
+
+void ArmorRenderer::start() {
+#ifndef ARMOR_HEADLESS
+    if (thread_.joinable()) return;
+    running_ = true;
+    thread_ = thread(&ArmorRenderer::run, this);
+#endif
+}
+
+void ArmorRenderer::stop() {
+    if (!thread_.joinable()) return;
+    {
+        lock_guard<mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+void ArmorRenderer::submit(uint64_t seq, const Mat& frame, const vector<TrackedArmor>& armors) {
+#ifndef ARMOR_HEADLESS
+    if (!thread_.joinable()) return;
+    shared_ptr<RenderSnapshot> snapshot = make_shared<RenderSnapshot>();
+    snapshot->seq = seq;
+    snapshot->frame = frame.clone();
+    snapshot->armors = armors;
+    submit(snapshot);
+#endif
+}
+
+void ArmorRenderer::submit(shared_ptr<const RenderSnapshot> snapshot) {
+#ifndef ARMOR_HEADLESS
+    if (!thread_.joinable()) return;
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (mailbox_) dropped_++;
+        // 旧快照在锁外释放，避免在锁里析构大图
+        mailbox_.swap(snapshot);
+    }
+    cv_.notify_one();
+#endif
+}
+
+void ArmorRenderer::run() {
+#ifndef ARMOR_HEADLESS
+    TRACE_THREAD_NAME("renderer");
+    for (;;) {
+        shared_ptr<const RenderSnapshot> snapshot;
+        {
+            unique_lock<mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return mailbox_ || !running_; });
+            if (!mailbox_) break;
+            snapshot.swap(mailbox_);
+        }
+
+        TRACE_SCOPE("ArmorRenderer::draw");
+        snapshot->frame.copyTo(canvas_);
+        detector_.drawResults(canvas_, snapshot->armors);
+        rendered_++;
+        if (sink_) sink_(canvas_, snapshot->seq);
+    }
+#endif
+}
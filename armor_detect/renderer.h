@@ -0,0 +1,62 @@
+#ifndef ARMOR_RENDERER_H
+#define ARMOR_RENDERER_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "armor_detect.h"
+
+// 一帧检测结果的只读快照，创建后不再修改，可以在线程之间共享
+struct RenderSnapshot {
+    uint64_t seq;
+    cv::Mat frame;
+    std::vector<TrackedArmor> armors;
+
+    RenderSnapshot() : seq(0) {}
+};
+
+// 异步叠加层渲染
+// 检测线程 submit 快照后立即返回，渲染线程只画信箱里最新的一帧，
+// 来不及画的旧帧直接丢弃并计数，渲染再慢也不会拖住检测。
+// ARMOR_HEADLESS 构建下不启动线程，submit 直接返回。
+class ArmorRenderer {
+public:
+    // 在渲染线程中调用，参数是画好的图像（可以 imshow、写视频等）
+    typedef std::function<void(const cv::Mat& canvas, uint64_t seq)> Sink;
+
+    explicit ArmorRenderer(const ArmorDetector& detector, Sink sink = Sink());
+    ~ArmorRenderer();
+
+    void start();
+    // 画完信箱里剩下的一帧后停止
+    void stop();
+
+    // frame 会被克隆进快照，提交后调用方可以继续复用自己的缓冲区
+    void submit(uint64_t seq, const cv::Mat& frame, const std::vector<TrackedArmor>& armors);
+    void submit(std::shared_ptr<const RenderSnapshot> snapshot);
+
+    uint64_t renderedFrames() const { return rendered_.load(); }
+    uint64_t droppedFrames() const { return dropped_.load(); }
+
+private:
+    void run();
+
+    const ArmorDetector& detector_;
+    Sink sink_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::shared_ptr<const RenderSnapshot> mailbox_;   // 单槽信箱，新帧覆盖旧帧
+    bool running_;
+    std::atomic<uint64_t> rendered_;
+    std::atomic<uint64_t> dropped_;
+    cv::Mat canvas_;
+};
+
+#endif // ARMOR_RENDERER_H
@@ -0,0 +1,229 @@
+#include "scene_gen.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace cv;
+using namespace std;
+
+// 装甲板尺寸（米），角点是两根灯条内侧的端点
+static const float kArmorWidth = 0.2f;
+static const float kArmorHeight = 0.1f;
+static const float kBarWidth = 0.015f;
+static const float kPanelHeight = 0.13f;
+// 有拖影时每帧在曝光期间采样的次数
+static const int kExposureSamples = 5;
+
+ArmorSceneGenerator::ArmorSceneGenerator(const SceneConfig& config)
+    : config_(config), rng_(config.seed), frame_index_(0) {
+    const double f = 1.2 * config_.resolution.width;
+    camera_matrix_ = (Mat_<double>(3, 3) <<
+        f, 0, config_.resolution.width * 0.5,
+        0, f, config_.resolution.height * 0.5,
+        0, 0, 1);
+
+    renderBackground();
+    bodies_.resize(max(0, config_.armor_count));
+    for (size_t i = 0; i < bodies_.size(); i++) {
+        bodies_[i].id = (int)i;
+        initBody(bodies_[i]);
+    }
+}
+
+const vector<Point3f>& ArmorSceneGenerator::objectPoints() {
+    static const vector<Point3f> points = {
+        Point3f(-kArmorWidth / 2, -kArmorHeight / 2, 0),
+        Point3f(kArmorWidth / 2, -kArmorHeight / 2, 0),
+        Point3f(kArmorWidth / 2, kArmorHeight / 2, 0),
+        Point3f(-kArmorWidth / 2, kArmorHeight / 2, 0)
+    };
+    return points;
+}
+
+// 深度 z 处装甲板中心能到达的横向、纵向范围，保证整块装甲板留在画面里
+static Vec2d lateralLimit(const Mat& camera_matrix, double z) {
+    const double f = camera_matrix.at<double>(0, 0);
+    const double cx = camera_matrix.at<double>(0, 2);
+    const double cy = camera_matrix.at<double>(1, 2);
+    const double margin_px = 4;
+    double x = z * (cx - margin_px) / f - (kArmorWidth / 2 + kBarWidth);
+    double y = z * (cy - margin_px) / f - kPanelHeight / 2;
+    return Vec2d(max(0.0, x), max(0.0, y));
+}
+
+void ArmorSceneGenerator::initBody(Body& body) {
+    double z = rng_.uniform(config_.min_distance, config_.max_distance);
+    Vec2d limit = lateralLimit(camera_matrix_, z);
+    body.position = Vec3d(rng_.uniform(-limit[0], limit[0] + 1e-9),
+                          rng_.uniform(-limit[1], limit[1] + 1e-9), z);
+
+    double heading = rng_.uniform(0.0, 2 * CV_PI);
+    double speed = rng_.uniform(0.0, config_.max_speed);
+    // 纵深方向的运动慢一些，画面里的尺寸变化更接近实际
+    body.velocity = Vec3d(speed * cos(heading), speed * sin(heading) * 0.5,
+                          rng_.uniform(-0.3, 0.3) * speed);
+    body.yaw_phase = rng_.uniform(0.0, 2 * CV_PI);
+    body.yaw_rate = rng_.uniform(0.5, 2.0);
+}
+
+void ArmorSceneGenerator::step(Body& body, double dt) {
+    body.position += body.velocity * dt;
+
+    double& z = body.position[2];
+    if (z < config_.min_distance || z > config_.max_distance) {
+        z = min(max(z, config_.min_distance), config_.max_distance);
+        body.velocity[2] = -body.velocity[2];
+    }
+    Vec2d limit = lateralLimit(camera_matrix_, z);
+    for (int k = 0; k < 2; k++) {
+        if (abs(body.position[k]) > limit[k]) {
+            body.position[k] = body.position[k] > 0 ? limit[k] : -limit[k];
+            body.velocity[k] = -body.velocity[k];
+        }
+    }
+}
+
+double ArmorSceneGenerator::yawOf(const Body& body, double t) const {
+    return config_.max_yaw * sin(body.yaw_phase + body.yaw_rate * t);
+}
+
+void ArmorSceneGenerator::project(const vector<Point3f>& points, const Vec3d& rvec, const Vec3d& tvec,
+                                  vector<Point2f>& out) const {
+    projectPoints(points, rvec, tvec, camera_matrix_, noArray(), out);
+}
+
+void ArmorSceneGenerator::renderBackground() {
+    const Size size = config_.resolution;
+    background_.create(size, CV_8UC3);
+
+    // 上亮下暗的渐变，再铺几块明暗不同的墙面
+    for (int y = 0; y < size.height; y++) {
+        uchar v = saturate_cast<uchar>(45 - 25.0 * y / size.height);
+        background_.row(y).setTo(Scalar(v, v, v + 2));
+    }
+    int walls = 3 + size.area() / 200000;
+    for (int i = 0; i < walls; i++) {
+        Point p(rng_.uniform(0, size.width), rng_.uniform(0, size.height));
+        Size s(rng_.uniform(size.width / 10, size.width / 3), rng_.uniform(size.height / 10, size.height / 3));
+        int v = rng_.uniform(15, 70);
+        rectangle(background_, Rect(p, s), Scalar(v, v, v), -1);
+    }
+
+    // 干扰光源：灯、横向的反光条、和装甲板同色但没有配对的单根灯条
+    const Scalar bar_color = config_.blue ? Scalar(255, 190, 60) : Scalar(90, 110, 255);
+    for (int i = 0; i < config_.distractor_count; i++) {
+        Point2f c((float)rng_.uniform(0, size.width), (float)rng_.uniform(0, size.height));
+        float scale = size.width / 1280.f;
+        if (i % 3 == 0) {
+            int r = max(2, (int)(rng_.uniform(3, 14) * scale));
+            circle(background_, c, r * 2, Scalar(120, 130, 140), -1, LINE_AA);
+            circle(background_, c, r, Scalar(235, 240, 245), -1, LINE_AA);
+        } else {
+            float len = rng_.uniform(20.f, 70.f) * scale;
+            float width = rng_.uniform(3.f, 8.f) * scale;
+            bool reflection = i % 3 == 1;
+            float angle = reflection ? rng_.uniform(-20.f, 20.f) : 90 + rng_.uniform(-15.f, 15.f);
+            RotatedRect bar(c, Size2f(len, width), angle);
+            Point2f p[4];
+            bar.points(p);
+            vector<Point> poly(p, p + 4);
+            fillConvexPoly(background_, poly, reflection ? Scalar(200, 200, 200) : bar_color, LINE_AA);
+        }
+    }
+    GaussianBlur(background_, background_, Size(3, 3), 0);
+}
+
+void ArmorSceneGenerator::renderArmor(const Body& body, double t, Mat& layer) {
+    static const vector<Point3f> left_bar = {
+        Point3f(-kArmorWidth / 2 - kBarWidth, -kArmorHeight / 2, 0),
+        Point3f(-kArmorWidth / 2, -kArmorHeight / 2, 0),
+        Point3f(-kArmorWidth / 2, kArmorHeight / 2, 0),
+        Point3f(-kArmorWidth / 2 - kBarWidth, kArmorHeight / 2, 0)
+    };
+    static const vector<Point3f> right_bar = {
+        Point3f(kArmorWidth / 2, -kArmorHeight / 2, 0),
+        Point3f(kArmorWidth / 2 + kBarWidth, -kArmorHeight / 2, 0),
+        Point3f(kArmorWidth / 2 + kBarWidth, kArmorHeight / 2, 0),
+        Point3f(kArmorWidth / 2, kArmorHeight / 2, 0)
+    };
+    const Scalar color = config_.blue ? Scalar(255, 190, 60) : Scalar(90, 110, 255);
+
+    // 曝光期间按匀速外推，不考虑期间的反弹
+    const double dt = t - frame_index_ / config_.fps;
+    Vec3d rvec(0, yawOf(body, t), 0);
+    Vec3d tvec = body.position + body.velocity * dt;
+    for (const auto* bar : {&left_bar, &right_bar}) {
+        project(*bar, rvec, tvec, projected_);
+        polygon_.assign(projected_.begin(), projected_.end());
+        fillConvexPoly(layer, polygon_, color, LINE_AA);
+    }
+}
+
+void ArmorSceneGenerator::next(SceneFrame& frame) {
+    const Size size = config_.resolution;
+    const double t = frame_index_ / config_.fps;
+    background_.copyTo(frame.image);
+
+    // 真值和装甲板底板按帧时刻（曝光中点）计算
+    frame.armors.resize(bodies_.size());
+    for (size_t i = 0; i < bodies_.size(); i++) {
+        const Body& body = bodies_[i];
+        SceneArmor& armor = frame.armors[i];
+        armor.id = body.id;
+        armor.rvec = Vec3d(0, yawOf(body, t), 0);
+        armor.tvec = body.position;
+
+        project(objectPoints(), armor.rvec, armor.tvec, projected_);
+        armor.visible = cos(armor.rvec[1]) > 0.3;
+        for (int k = 0; k < 4; k++) {
+            armor.corners[k] = projected_[k];
+            armor.visible = armor.visible && projected_[k].x >= 0 && projected_[k].y >= 0 &&
+                            projected_[k].x < size.width && projected_[k].y < size.height;
+        }
+        armor.bbox = boundingRect(Mat(4, 1, CV_32FC2, armor.corners));
+
+        static const vector<Point3f> panel = {
+            Point3f(-kArmorWidth / 2, -kPanelHeight / 2, 0),
+            Point3f(kArmorWidth / 2, -kPanelHeight / 2, 0),
+            Point3f(kArmorWidth / 2, kPanelHeight / 2, 0),
+            Point3f(-kArmorWidth / 2, kPanelHeight / 2, 0)
+        };
+        project(panel, armor.rvec, armor.tvec, projected_);
+        polygon_.assign(projected_.begin(), projected_.end());
+        fillConvexPoly(frame.image, polygon_, Scalar(55, 55, 55), LINE_AA);
+    }
+
+    // 灯条在曝光期间多次采样取平均，运动快的灯条自然产生拖影
+    const int samples = config_.exposure > 0 ? kExposureSamples : 1;
+    lights_.create(size, CV_32FC3);
+    lights_.setTo(Scalar::all(0));
+    for (int s = 0; s < samples; s++) {
+        double ts = t;
+        if (samples > 1) {
+            ts += config_.exposure / config_.fps * ((double)s / (samples - 1) - 0.5);
+        }
+        sample_.create(size, CV_8UC3);
+        sample_.setTo(Scalar::all(0));
+        for (const auto& body : bodies_) {
+            renderArmor(body, ts, sample_);
+        }
+        accumulate(sample_, lights_);
+    }
+    lights_.convertTo(lights_, CV_32F, 1.0 / samples);
+
+    // 灯条周围的光晕
+    GaussianBlur(lights_, glow_, Size(0, 0), max(1.0, size.width / 640.0));
+    scaleAdd(glow_, 0.8, lights_, lights_);
+    add(frame.image, lights_, frame.image, noArray(), CV_8U);
+
+    if (config_.noise_sigma > 0) {
+        noise_.create(size, CV_16SC3);
+        rng_.fill(noise_, RNG::NORMAL, Scalar::all(0), Scalar::all(config_.noise_sigma));
+        add(frame.image, noise_, frame.image, noArray(), CV_8U);
+    }
+
+    const double dt = 1.0 / config_.fps;
+    for (auto& body : bodies_) {
+        step(body, dt);
+    }
+    frame_index_++;
+}
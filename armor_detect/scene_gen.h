@@ -0,0 +1,93 @@
+#ifndef ARMOR_SCENE_GEN_H
+#define ARMOR_SCENE_GEN_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// 合成场景的参数，距离单位为米，角度为弧度
+struct SceneConfig {
+    cv::Size resolution;
+    int armor_count;
+    int distractor_count;     // 干扰光源个数：灯、反光，以及没有配对的单根灯条
+    double min_distance;      // 装甲板到相机的距离范围
+    double max_distance;
+    double max_yaw;           // 装甲板绕竖直轴转动的最大角度
+    double max_speed;         // 平移速度上限（米/秒）
+    double fps;
+    double exposure;          // 曝光时间占帧间隔的比例，大于 0 时按运动方向产生拖影
+    double noise_sigma;       // 高斯噪声的标准差（灰度级）
+    bool blue;                // 灯条颜色，false 为红色
+    uint64 seed;
+
+    SceneConfig()
+        : resolution(1280, 1024), armor_count(2), distractor_count(4),
+          min_distance(1.5), max_distance(5.0), max_yaw(0.8), max_speed(1.5), fps(100),
+          exposure(0.5), noise_sigma(3), blue(false), seed(1) {}
+};
+
+// 一块装甲板的真值
+struct SceneArmor {
+    int id;                       // 整段序列里不变，用来检查跟踪 id 是否切换
+    cv::Point2f corners[4];       // 灯条内侧端点，左上、右上、右下、左下，与 ArmorDetection 一致
+    cv::Rect bbox;
+    cv::Vec3d rvec;               // 相机坐标系下的位姿，对应 objectPoints()
+    cv::Vec3d tvec;
+    bool visible;                 // 四个角点都在画面内，且正面朝向相机
+};
+
+struct SceneFrame {
+    cv::Mat image;
+    std::vector<SceneArmor> armors;
+};
+
+// 按给定参数逐帧生成带真值的装甲板场景。
+// 装甲板在视锥里匀速运动、碰到边界反弹，同时绕竖直轴摆动；
+// 同一个 seed 生成的序列逐像素一致。
+class ArmorSceneGenerator {
+public:
+    explicit ArmorSceneGenerator(const SceneConfig& config);
+
+    // 生成下一帧，frame.image 尺寸不变时复用内存
+    void next(SceneFrame& frame);
+
+    int frameIndex() const { return frame_index_; }
+    const SceneConfig& config() const { return config_; }
+    // 针孔相机，无畸变，焦距与画面宽度成正比
+    const cv::Mat& cameraMatrix() const { return camera_matrix_; }
+    // 角点对应的装甲板坐标系中的点，与 ArmorDetector::objectPoints() 相同
+    static const std::vector<cv::Point3f>& objectPoints();
+
+private:
+    struct Body {
+        int id;
+        cv::Vec3d position;
+        cv::Vec3d velocity;
+        double yaw_phase;
+        double yaw_rate;
+    };
+
+    void initBody(Body& body);
+    void step(Body& body, double dt);
+    double yawOf(const Body& body, double t) const;
+    void project(const std::vector<cv::Point3f>& points, const cv::Vec3d& rvec, const cv::Vec3d& tvec,
+                 std::vector<cv::Point2f>& out) const;
+    void renderBackground();
+    void renderArmor(const Body& body, double t, cv::Mat& layer);
+
+    SceneConfig config_;
+    cv::RNG rng_;
+    cv::Mat camera_matrix_;
+    std::vector<Body> bodies_;
+    int frame_index_;
+
+    // 跨帧复用的缓冲区
+    cv::Mat background_;
+    cv::Mat lights_;          // 灯条层（CV_32FC3），曝光期间的多次采样累加
+    cv::Mat sample_;
+    cv::Mat glow_;
+    cv::Mat noise_;
+    std::vector<cv::Point2f> projected_;
+    std::vector<cv::Point> polygon_;
+};
+
+#endif // ARMOR_SCENE_GEN_H
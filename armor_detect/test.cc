@@ -1,7 +1,16 @@
 #include "armor_detect.h"
-#include "../../include/utils.h"
+#include "pipeline.h"
+#include "renderer.h"
+#include "scene_gen.h"
+#include "alloc_counter.h"
+#include "utils.h"
+#include "log.h"
 #include <opencv2/opencv.hpp>
+#include <atomic>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <thread>
 
 using namespace cv;
 using namespace std;
@@ -22,8 +31,10 @@ bool test_armor_detect() {
     // 处理图像
     auto armors = detector.processFrame(test_frame);
     
+#ifndef ARMOR_HEADLESS
     // 绘制结果（包括轮廓和姿态）
     detector.drawResults(test_frame, armors);
+#endif
     
     // 保存测试结果图像
     imwrite("armor_detect_test_result.jpg", test_frame);
@@ -44,4 +55,1449 @@ bool test_armor_detect() {
         LOG_WARN("未检测到装甲板");
         return false;
     }
-}
\ No newline at end of file
+}
+
+// OpenCV 原始的预处理链路，作为融合实现逐像素对比的基准；method 和 block_size 为自适应阈值的参数
+static Mat preprocessReference(const Mat& frame, int method = ADAPTIVE_THRESH_GAUSSIAN_C, int block_size = 11) {
+    Mat gray, binary;
+    cvtColor(frame, gray, COLOR_BGR2GRAY);
+    adaptiveThreshold(gray, binary, 255, method,
+                     THRESH_BINARY, block_size, 2);
+
+    Mat kernel = getStructuringElement(MORPH_RECT, Size(3, 3));
+    morphologyEx(binary, binary, MORPH_CLOSE, kernel);
+    morphologyEx(binary, binary, MORPH_OPEN, kernel);
+
+    return binary;
+}
+
+// 生成带噪声背景和若干灯条、光斑的测试帧
+static Mat makeTestFrame(int rows, int cols, RNG& rng) {
+    Mat frame(rows, cols, CV_8UC3);
+    rng.fill(frame, RNG::UNIFORM, Scalar::all(0), Scalar::all(60));
+
+    int n = 10 + rows * cols / 20000;
+    for (int i = 0; i < n; i++) {
+        Point p(rng.uniform(0, cols), rng.uniform(0, rows));
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(128, 256));
+        if (i % 2 == 0) {
+            rectangle(frame, p, p + Point(rng.uniform(4, 20), rng.uniform(20, 80)), color, -1);
+        } else {
+            circle(frame, p, rng.uniform(2, 15), color, -1);
+        }
+    }
+    return frame;
+}
+
+bool test_fused_preprocess() {
+    RNG rng(20241023);
+    vector<Size> sizes = {Size(64, 33), Size(640, 480), Size(1280, 1024), Size(1919, 1081)};
+    // 0 表示自动探测 L2，16KB 用来强制切出很多小块，覆盖块边界
+    vector<size_t> l2_sizes = {0, 16 * 1024};
+
+    for (const auto& l2 : l2_sizes) {
+        FusedPreprocessor preprocessor(l2);
+        for (const auto& size : sizes) {
+            Mat frame = makeTestFrame(size.height, size.width, rng);
+            Mat expected = preprocessReference(frame);
+
+            Mat binary, diff;
+            preprocessor.process(frame, binary);
+            compare(expected, binary, diff, CMP_NE);
+            int wrong = countNonZero(diff);
+
+            cout << size.width << "x" << size.height
+                 << ", tile rows " << preprocessor.tileRows()
+                 << ", 不一致像素 " << wrong << endl;
+            if (wrong != 0) {
+                LOG_ERROR("融合预处理与 OpenCV 链路不一致: %dx%d", size.width, size.height);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool bench_fused_preprocess() {
+    RNG rng(12345);
+    vector<Size> sizes = {Size(640, 480), Size(1280, 1024), Size(1920, 1080), Size(3840, 2160)};
+    FusedPreprocessor preprocessor;
+    LOG_MSG("L2 缓存: %d KB", (int)(FusedPreprocessor::detectL2CacheSize() / 1024));
+
+    for (const auto& size : sizes) {
+        Mat frame = makeTestFrame(size.height, size.width, rng);
+        Mat binary;
+        int iterations = size.area() > 4000000 ? 20 : 100;
+
+        // 预热，让两条路径的缓冲区都分配好
+        preprocessReference(frame);
+        preprocessor.process(frame, binary);
+
+        int64 t0 = getTickCount();
+        for (int i = 0; i < iterations; i++) {
+            binary = preprocessReference(frame);
+        }
+        int64 t1 = getTickCount();
+        for (int i = 0; i < iterations; i++) {
+            preprocessor.process(frame, binary);
+        }
+        int64 t2 = getTickCount();
+
+        double ref_ms = (t1 - t0) * 1000.0 / getTickFrequency() / iterations;
+        double fused_ms = (t2 - t1) * 1000.0 / getTickFrequency() / iterations;
+        cout << size.width << "x" << size.height
+             << ": OpenCV 链路 " << ref_ms << " ms (" << 1000.0 / ref_ms << " FPS)"
+             << ", 融合 " << fused_ms << " ms (" << 1000.0 / fused_ms << " FPS)"
+             << ", 加速 " << ref_ms / fused_ms << "x"
+             << ", tile rows " << preprocessor.tileRows() << endl;
+    }
+    return true;
+}
+
+// 在 (cx, cy) 处画一块由两根灯条组成的模拟装甲板。
+// 黑底上的纯色灯条经灰度自适应阈值会变成背景里的洞，用到它的检测器要开颜色模式：
+// 灯条颜色 R - B = 105、灰度 181，按默认的 ColorMaskParams(RED) 整根都在掩码里
+static void drawArmor(Mat& frame, Point center) {
+    const Scalar color(150, 150, 255);
+    rectangle(frame, center + Point(-40, -40), center + Point(-20, 40), color, -1);
+    rectangle(frame, center + Point(20, -40), center + Point(40, 40), color, -1);
+}
+
+bool test_armor_pipeline() {
+    const int frames = 200;
+    vector<Mat> inputs;
+    for (int i = 0; i < frames; i++) {
+        Mat frame = Mat::zeros(480, 640, CV_8UC3);
+        drawArmor(frame, Point(150 + i % 100, 200));
+        // 两块装甲板的灯条相距超过最大配对距离，不会交叉配对
+        drawArmor(frame, Point(560, 150 + i % 150));
+        inputs.push_back(frame);
+    }
+
+    // 串行结果作为参照，每帧都要有目标，否则下面的逐帧比较没有意义
+    ArmorDetector serial;
+    serial.setColorMode(true);
+    vector<vector<TrackedArmor>> expected;
+    int64 t0 = getTickCount();
+    for (const auto& frame : inputs) {
+        expected.push_back(serial.processFrame(frame));
+    }
+    double serial_ms = (getTickCount() - t0) * 1000.0 / getTickFrequency();
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (expected[i].empty()) {
+            LOG_ERROR("串行检测第 %d 帧没有目标", (int)i);
+            return false;
+        }
+    }
+
+    ArmorDetector detector;
+    detector.setColorMode(true);
+    ArmorPipeline pipeline(detector);
+    vector<PipelineResult> results;
+    PipelineResult result;
+
+    // 提交和取结果在同一个线程里交替进行，stop 之后把剩下的结果取完
+    t0 = getTickCount();
+    pipeline.start();
+    for (const auto& frame : inputs) {
+        pipeline.submit(frame);
+        while (pipeline.poll(result)) {
+            results.push_back(result);
+        }
+    }
+    pipeline.stop();
+    while (pipeline.poll(result)) {
+        results.push_back(result);
+    }
+    double pipeline_ms = (getTickCount() - t0) * 1000.0 / getTickFrequency();
+
+    cout << "串行 " << serial_ms << " ms, 流水线 " << pipeline_ms << " ms" << endl;
+    for (const auto& s : pipeline.stats()) {
+        cout << s.name << ": processed " << s.processed
+             << ", avg " << s.avg_ms << " ms"
+             << ", occupancy " << s.occupancy * 100 << "%"
+             << ", avg queue " << s.avg_queue_depth << "/" << s.queue_capacity << endl;
+    }
+
+    auto check = [&](const vector<PipelineResult>& results, const char* mode) {
+        if (results.size() != expected.size()) {
+            LOG_ERROR("%s: 流水线输出 %d 帧，期望 %d 帧", mode, (int)results.size(), (int)expected.size());
+            return false;
+        }
+        for (size_t i = 0; i < results.size(); i++) {
+            const auto& got = results[i].armors;
+            const auto& want = expected[i];
+            if (results[i].seq != i || got.size() != want.size()) {
+                LOG_ERROR("%s: 第 %d 帧结果不一致", mode, (int)i);
+                return false;
+            }
+            for (size_t j = 0; j < got.size(); j++) {
+                if (got[j].id != want[j].id || got[j].bbox != want[j].bbox) {
+                    LOG_ERROR("%s: 第 %d 帧第 %d 个装甲板不一致", mode, (int)i, (int)j);
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+    if (!check(results, "交替 poll")) return false;
+
+    // 提交期间一直不 poll：阻塞的 submit 要自己把结果挪走，不能卡死
+    {
+        ArmorDetector detector;
+        detector.setColorMode(true);
+        ArmorPipeline pipeline(detector);
+        vector<PipelineResult> results;
+        pipeline.start();
+        for (const auto& frame : inputs) {
+            pipeline.submit(frame);
+        }
+        pipeline.stop();
+        while (pipeline.poll(result)) {
+            results.push_back(result);
+        }
+        if (!check(results, "不 poll")) return false;
+    }
+
+    // 另一个线程一直 poll，直到 stop 返回且结果取完
+    {
+        ArmorDetector detector;
+        detector.setColorMode(true);
+        ArmorPipeline pipeline(detector);
+        vector<PipelineResult> results;
+        atomic<bool> stopped(false);
+        pipeline.start();
+        thread poller([&]() {
+            PipelineResult r;
+            while (true) {
+                bool done = stopped.load();
+                bool got = false;
+                while (pipeline.poll(r)) {
+                    results.push_back(r);
+                    got = true;
+                }
+                if (done && !got) break;
+                this_thread::yield();
+            }
+        });
+        for (const auto& frame : inputs) {
+            pipeline.submit(frame);
+        }
+        pipeline.stop();
+        stopped = true;
+        poller.join();
+        if (!check(results, "另一线程 poll")) return false;
+    }
+    return true;
+}
+
+bool test_armor_roi() {
+    // 窗口合并：前三个窗口依次相交，应合并成一个
+    vector<Rect> windows = {Rect(0, 0, 10, 10), Rect(100, 100, 5, 5),
+                            Rect(5, 5, 10, 10), Rect(12, 12, 10, 10)};
+    ArmorDetector::mergeSearchWindows(windows);
+    if (windows.size() != 2 || windows[0] != Rect(0, 0, 22, 22) || windows[1] != Rect(100, 100, 5, 5)) {
+        LOG_ERROR("窗口合并结果不对");
+        return false;
+    }
+
+    const int frames = 120;
+    vector<Mat> inputs;
+    for (int i = 0; i < frames; i++) {
+        Mat frame = Mat::zeros(1024, 1280, CV_8UC3);
+        drawArmor(frame, Point(300 + i, 400));
+        drawArmor(frame, Point(900, 300 + i / 2));
+        inputs.push_back(frame);
+    }
+
+    ArmorDetector full, roi;
+    full.setColorMode(true);
+    roi.setColorMode(true);
+    roi.setRoiMode(true, 10);
+
+    // 同一个 id 的框最多差 1 像素：窗口里的灯条中心是局部坐标加偏移，浮点舍入可能不同
+    auto sameTracks = [](const vector<TrackedArmor>& a, const vector<TrackedArmor>& b) {
+        if (a.size() != b.size()) return false;
+        for (const auto& x : a) {
+            auto it = find_if(b.begin(), b.end(), [&](const TrackedArmor& y) { return y.id == x.id; });
+            if (it == b.end() || std::abs(it->bbox.x - x.bbox.x) > 1 || std::abs(it->bbox.y - x.bbox.y) > 1 ||
+                std::abs(it->bbox.width - x.bbox.width) > 1 || std::abs(it->bbox.height - x.bbox.height) > 1) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    int matched = 0, tracked = 0, roi_frames = 0;
+    double coverage = 0, full_ms = 0, roi_ms = 0;
+    for (const auto& frame : inputs) {
+        int64 t0 = getTickCount();
+        const vector<TrackedArmor>& full_armors = full.processFrame(frame);
+        int64 t1 = getTickCount();
+        const vector<TrackedArmor>& roi_armors = roi.processFrame(frame);
+        int64 t2 = getTickCount();
+
+        full_ms += (t1 - t0) * 1000.0 / getTickFrequency();
+        roi_ms += (t2 - t1) * 1000.0 / getTickFrequency();
+        coverage += roi.lastSearchCoverage();
+        if (roi.lastSearchCoverage() < 1) roi_frames++;
+        if (full_armors.size() == 2) tracked++;
+        if (sameTracks(full_armors, roi_armors)) matched++;
+    }
+
+    cout << "全图 " << full_ms / frames << " ms/帧, ROI " << roi_ms / frames << " ms/帧"
+         << ", 平均搜索面积 " << coverage / frames * 100 << "%"
+         << ", 只搜窗口的帧 " << roi_frames << "/" << frames
+         << ", 两块都跟上的帧 " << tracked << "/" << frames
+         << ", 结果一致的帧 " << matched << "/" << frames << endl;
+
+    // 每 10 帧全图扫一次，其余帧都只搜跟踪窗口
+    if (tracked != frames) {
+        LOG_ERROR("全图检测没有每帧跟上两块装甲板");
+        return false;
+    }
+    if (roi_frames < frames * 8 / 10) {
+        LOG_ERROR("ROI 模式大部分帧仍在全图扫描");
+        return false;
+    }
+    return matched == frames;
+}
+
+// 在 1280x1024 的画面里随机撒 n 根灯条，角度集中在几个常见值附近
+static vector<RotatedRect> makeRandomBars(int n, RNG& rng) {
+    vector<RotatedRect> bars;
+    for (int i = 0; i < n; i++) {
+        Point2f center(rng.uniform(0.f, 1280.f), rng.uniform(0.f, 1024.f));
+        Size2f size(rng.uniform(4.f, 12.f), rng.uniform(20.f, 80.f));
+        float angle = (float)(rng.uniform(0, 4) * -30) + rng.uniform(-10.f, 10.f);
+        bars.push_back(RotatedRect(center, size, angle));
+    }
+    return bars;
+}
+
+static const int kBarCounts[] = {10, 50, 100, 200, 500, 1000, 2000};
+
+bool test_light_bar_pairing() {
+    RNG rng(4);
+    LightBarPairer pairer;
+    vector<pair<int, int>> expected, got;
+
+    for (int n : kBarCounts) {
+        for (int round = 0; round < 5; round++) {
+            vector<RotatedRect> bars = makeRandomBars(n, rng);
+            LightBarPairer::findPairsBruteForce(bars, expected);
+            pairer.findPairs(bars, got);
+            if (got != expected) {
+                LOG_ERROR("%d 根灯条时配对结果不一致: %d 对, 期望 %d 对",
+                          n, (int)got.size(), (int)expected.size());
+                return false;
+            }
+        }
+        cout << n << " 根灯条: " << expected.size() << " 对, 与两重循环一致" << endl;
+    }
+    return true;
+}
+
+bool bench_light_bar_pairing() {
+    RNG rng(5);
+    LightBarPairer pairer;
+    vector<pair<int, int>> out;
+
+    for (int n : kBarCounts) {
+        vector<RotatedRect> bars = makeRandomBars(n, rng);
+        int iterations = max(10, 200000 / n);
+
+        int64 t0 = getTickCount();
+        for (int i = 0; i < iterations; i++) {
+            LightBarPairer::findPairsBruteForce(bars, out);
+        }
+        int64 t1 = getTickCount();
+        for (int i = 0; i < iterations; i++) {
+            pairer.findPairs(bars, out);
+        }
+        int64 t2 = getTickCount();
+
+        double brute_us = (t1 - t0) * 1e6 / getTickFrequency() / iterations;
+        double grid_us = (t2 - t1) * 1e6 / getTickFrequency() / iterations;
+        cout << n << " 根灯条: 两重循环 " << brute_us << " us, 网格 " << grid_us
+             << " us, 加速 " << brute_us / grid_us << "x" << endl;
+    }
+    return true;
+}
+
+// 穷举所有匹配，求 IoU 超过阈值的边上总 IoU 的最大值
+static double bestTotalIou(const vector<Rect>& tracks, const vector<Rect>& dets,
+                           double thresh, size_t i, vector<bool>& used) {
+    if (i == tracks.size()) return 0.0;
+    double best = bestTotalIou(tracks, dets, thresh, i + 1, used);
+    for (size_t j = 0; j < dets.size(); j++) {
+        double iou = ArmorTracker::calculateIOU(tracks[i], dets[j]);
+        if (used[j] || iou <= thresh) continue;
+        used[j] = true;
+        best = max(best, iou + bestTotalIou(tracks, dets, thresh, i + 1, used));
+        used[j] = false;
+    }
+    return best;
+}
+
+static vector<Rect> makeRandomBoxes(int n, int area_w, int area_h, int min_side, int max_side, RNG& rng) {
+    vector<Rect> boxes;
+    for (int i = 0; i < n; i++) {
+        boxes.push_back(Rect(rng.uniform(0, area_w), rng.uniform(0, area_h),
+                             rng.uniform(min_side, max_side), rng.uniform(min_side, max_side)));
+    }
+    return boxes;
+}
+
+bool test_armor_association() {
+    RNG rng(6);
+    GatedAssociator associator;
+    vector<int> track_to_det, det_to_track;
+    const double thresh = 0.3;
+
+    for (int round = 0; round < 500; round++) {
+        // 框挤在一小块区域里，制造大量相互竞争的候选
+        vector<Rect> tracks = makeRandomBoxes(rng.uniform(0, 7), 60, 60, 20, 40, rng);
+        vector<Rect> dets = makeRandomBoxes(rng.uniform(0, 7), 60, 60, 20, 40, rng);
+        associator.associate(tracks, dets, thresh, track_to_det, det_to_track);
+
+        double total = 0;
+        for (size_t i = 0; i < tracks.size(); i++) {
+            int j = track_to_det[i];
+            if (j == -1) continue;
+            double iou = ArmorTracker::calculateIOU(tracks[i], dets[j]);
+            if (det_to_track[j] != (int)i || iou <= thresh) {
+                LOG_ERROR("第 %d 组: 匹配不合法", round);
+                return false;
+            }
+            total += iou;
+        }
+
+        vector<bool> used(dets.size(), false);
+        double best = bestTotalIou(tracks, dets, thresh, 0, used);
+        if (std::abs(total - best) > 1e-9) {
+            LOG_ERROR("第 %d 组: 总 IoU %f, 最优 %f", round, total, best);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool bench_armor_association() {
+    RNG rng(7);
+    const int counts[] = {10, 50, 100, 200, 500, 1000};
+
+    for (int n : counts) {
+        // 回放整场比赛时的规模：n 个目标散布在 4K 画面里，检测框在跟踪框附近抖动
+        vector<Rect> tracks = makeRandomBoxes(n, 3840, 2160, 30, 80, rng);
+        vector<Rect> dets;
+        for (const auto& t : tracks) {
+            dets.push_back(t + Point(rng.uniform(-5, 6), rng.uniform(-5, 6)));
+        }
+
+        GatedAssociator associator;
+        vector<int> track_to_det, det_to_track;
+        int iterations = max(5, 20000 / n);
+
+        int64 t0 = getTickCount();
+        for (int it = 0; it < iterations; it++) {
+            associator.associate(tracks, dets, 0.3, track_to_det, det_to_track);
+        }
+        int64 t1 = getTickCount();
+        // 对照：原来的贪心双重循环
+        for (int it = 0; it < iterations; it++) {
+            vector<bool> matched(dets.size(), false);
+            for (size_t i = 0; i < tracks.size(); i++) {
+                double best = 0.3;
+                int best_j = -1;
+                for (size_t j = 0; j < dets.size(); j++) {
+                    if (matched[j]) continue;
+                    double iou = ArmorTracker::calculateIOU(tracks[i], dets[j]);
+                    if (iou > best) {
+                        best = iou;
+                        best_j = (int)j;
+                    }
+                }
+                if (best_j != -1) matched[best_j] = true;
+            }
+        }
+        int64 t2 = getTickCount();
+
+        double gated_us = (t1 - t0) * 1e6 / getTickFrequency() / iterations;
+        double greedy_us = (t2 - t1) * 1e6 / getTickFrequency() / iterations;
+        cout << n << " 个目标: 门控+匈牙利 " << gated_us << " us (" << associator.candidateCount()
+             << " 条候选边), 贪心 " << greedy_us << " us" << endl;
+    }
+    return true;
+}
+
+static ArmorDetection makeDetection(const Rect& box) {
+    ArmorDetection d;
+    d.bbox = box;
+    d.corners[0] = Point2f(box.x, box.y);
+    d.corners[1] = Point2f(box.x + box.width, box.y);
+    d.corners[2] = Point2f(box.x + box.width, box.y + box.height);
+    d.corners[3] = Point2f(box.x, box.y + box.height);
+    return d;
+}
+
+// 单个目标按给定速度序列运动，返回整个过程中出现过的 id 个数
+static int countTrackIds(const vector<float>& speeds, float dt, int hide_from, int hide_to,
+                         Point2f* coast_error) {
+    ArmorTracker tracker;
+    vector<int> ids;
+    float x = 100;
+    for (int frame = 0; frame < (int)speeds.size(); frame++) {
+        x += speeds[frame] * dt;
+        Rect truth(cvRound(x), 300, 60, 40);
+
+        vector<ArmorDetection> detections;
+        bool hidden = frame >= hide_from && frame < hide_to;
+        if (!hidden) {
+            detections.push_back(makeDetection(truth));
+        }
+        const vector<TrackedArmor>& armors = tracker.update(detections, dt);
+
+        for (const auto& armor : armors) {
+            if (find(ids.begin(), ids.end(), armor.id) == ids.end()) {
+                ids.push_back(armor.id);
+            }
+            if (hidden && coast_error) {
+                *coast_error = Point2f(armor.bbox.x - truth.x, armor.bbox.y - truth.y);
+            }
+        }
+    }
+    return (int)ids.size();
+}
+
+bool test_armor_motion() {
+    // 1. 速度从 5 加到 40 像素/帧，后期相邻两帧的 IoU 只有 0.2，低于阈值 0.3
+    vector<float> ramp;
+    for (int i = 0; i < 60; i++) ramp.push_back(min(40.f, 5.f + 2.f * i));
+    int ids = countTrackIds(ramp, 1.f, -1, -1, NULL);
+    cout << "加速目标: " << ids << " 个 id" << endl;
+    if (ids != 1) return false;
+
+    // 2. 隔帧检测，每次更新之间目标移动 2 倍距离
+    vector<float> half;
+    for (int i = 0; i < 60; i++) half.push_back(min(20.f, 2.f + i));
+    ids = countTrackIds(half, 2.f, -1, -1, NULL);
+    cout << "隔帧检测: " << ids << " 个 id" << endl;
+    if (ids != 1) return false;
+
+    // 3. 匀速目标被遮挡 3 帧，期间沿预测滑行，重新出现后保持 id
+    vector<float> constant(60, 15.f);
+    Point2f coast_error;
+    ids = countTrackIds(constant, 1.f, 30, 33, &coast_error);
+    cout << "遮挡 3 帧: " << ids << " 个 id, 滑行误差 (" << coast_error.x << ", " << coast_error.y << ")" << endl;
+    if (ids != 1 || std::abs(coast_error.x) > 10 || std::abs(coast_error.y) > 10) return false;
+
+    // 4. 检测器先逐帧处理，目标匀速后改为隔帧处理。改为隔帧后的第一次检测让目标消失，
+    //    滑行的框应落在目标两帧后的位置。帧步长通过 setFrameStep 传给跟踪器；
+    //    不传的话跟踪器仍按 1 帧预测，框只走了一半，落在目标后面
+    struct DetectorRun {
+        size_t ids;
+        int visible, detected;
+        Point2f coast_error;
+    };
+    auto runDetector = [](bool pass_step) -> DetectorRun {
+        ArmorDetector detector;
+        detector.setColorMode(true);
+        vector<int> ids;
+        DetectorRun run = {0, 0, 0, Point2f(1e6f, 1e6f)};
+        const int switch_frame = 40, hide_frame = 42;
+        float x = 100;
+        Rect last_bbox;
+        float last_x = 0;
+        for (int frame = 0; frame < 60; frame++) {
+            x += min(16.f, 2.f + frame);
+            bool skip = frame > switch_frame && frame % 2 == 1;
+            if (skip) continue;
+            if (pass_step) detector.setFrameStep(frame > switch_frame ? 2.f : 1.f);
+
+            Mat image = Mat::zeros(480, 1280, CV_8UC3);
+            bool hidden = frame == hide_frame;
+            if (!hidden) {
+                drawArmor(image, Point(cvRound(x), 240));
+                run.visible++;
+            }
+            const vector<TrackedArmor>& armors = detector.processFrame(image);
+            for (const auto& armor : armors) {
+                if (find(ids.begin(), ids.end(), armor.id) == ids.end()) {
+                    ids.push_back(armor.id);
+                }
+                if (hidden) {
+                    run.coast_error = Point2f(armor.bbox.x - (last_bbox.x + x - last_x), armor.bbox.y - last_bbox.y);
+                } else if (armor.misses == 0) {
+                    run.detected++;
+                    last_bbox = armor.bbox;
+                    last_x = x;
+                }
+            }
+        }
+        run.ids = ids.size();
+        return run;
+    };
+    DetectorRun with_step = runDetector(true), without_step = runDetector(false);
+    cout << "检测器隔帧: 检出 " << with_step.detected << "/" << with_step.visible << " 帧, " << with_step.ids
+         << " 个 id, 滑行误差 (" << with_step.coast_error.x << ", " << with_step.coast_error.y << ")"
+         << "; 不传帧步长时滑行误差 (" << without_step.coast_error.x << ", " << without_step.coast_error.y << ")"
+         << endl;
+    if (with_step.detected != with_step.visible || without_step.detected != without_step.visible) {
+        LOG_ERROR("检测器没有在每个可见帧检出目标");
+        return false;
+    }
+    if (with_step.ids != 1 || std::abs(with_step.coast_error.x) > 8 || std::abs(with_step.coast_error.y) > 8) {
+        return false;
+    }
+    // 帧步长确实起了作用：不传时滞后一帧的位移（16 像素）
+    return std::abs(without_step.coast_error.x) > 8;
+}
+
+bool bench_armor_pose() {
+    ArmorDetector detector;
+    RNG rng(11);
+    const int frames = 600;
+
+    // 一块装甲板在 1.5~3 m 处平移并绕竖直轴转动，角点带 0.2 像素的噪声
+    vector<vector<Point2f>> sequence(frames);
+    for (int f = 0; f < frames; f++) {
+        double t = f / 60.0;
+        Vec3d rvec(0, 0.4 * sin(t * 2), 0);
+        Vec3d tvec(0.3 * sin(t), 0.1 * cos(t * 1.5), 2.2 + 0.7 * sin(t * 0.7));
+        projectPoints(detector.objectPoints(), rvec, tvec, detector.cameraMatrix(),
+                      detector.distCoeffs(), sequence[f]);
+        for (auto& p : sequence[f]) {
+            p += Point2f((float)rng.gaussian(0.2), (float)rng.gaussian(0.2));
+        }
+    }
+
+    vector<Vec3d> cold_tvecs(frames);
+    int64 t0 = getTickCount();
+    for (int f = 0; f < frames; f++) {
+        Vec3d rvec, tvec;
+        if (!detector.estimatePose(sequence[f], rvec, tvec)) {
+            LOG_ERROR("第 %d 帧冷启动求解失败", f);
+            return false;
+        }
+        cold_tvecs[f] = tvec;
+    }
+    int64 t1 = getTickCount();
+    Vec3d rvec, tvec;
+    detector.estimatePose(sequence[0], rvec, tvec);
+    double max_diff = 0;
+    for (int f = 0; f < frames; f++) {
+        if (!detector.estimatePose(sequence[f], rvec, tvec, true)) {
+            LOG_ERROR("第 %d 帧热启动求解失败", f);
+            return false;
+        }
+        max_diff = max(max_diff, norm(tvec - cold_tvecs[f]));
+    }
+    int64 t2 = getTickCount();
+
+    double cold_us = (t1 - t0) * 1e6 / getTickFrequency() / frames;
+    double warm_us = (t2 - t1) * 1e6 / getTickFrequency() / frames;
+    cout << "solvePnP 冷启动 " << cold_us << " us/次, 热启动 " << warm_us
+         << " us/次, 平移最大差异 " << max_diff * 1000 << " mm" << endl;
+
+    // 静止目标只有 0.05 像素的抖动，几乎每帧都应该复用缓存
+    TrackedArmor armor(0, boundingRect(sequence[0]), sequence[0]);
+    const int still_frames = 300;
+    for (int f = 0; f < still_frames; f++) {
+        for (size_t k = 0; k < armor.corners.size(); k++) {
+            armor.corners[k] = sequence[0][k] + Point2f((float)rng.gaussian(0.05), (float)rng.gaussian(0.05));
+        }
+        detector.updatePose(armor);
+    }
+    cout << "静止目标 " << still_frames << " 帧: 求解 " << detector.poseSolveCount()
+         << " 次, 复用 " << detector.poseReuseCount() << " 次" << endl;
+
+    return max_diff < 0.02 && armor.pose_valid && detector.poseReuseCount() > still_frames * 9 / 10;
+}
+
+// 对延迟序列排序后取分位数
+static double latencyPercentile(vector<double> samples, double p) {
+    if (samples.empty()) return 0;
+    sort(samples.begin(), samples.end());
+    size_t k = min(samples.size() - 1, (size_t)(p * samples.size()));
+    return samples[k];
+}
+
+bool bench_armor_render() {
+    ArmorDetector detector;
+    RNG rng(99);
+    const int frames = 200;
+
+    vector<Mat> inputs;
+    for (int i = 0; i < 8; i++) {
+        inputs.push_back(makeTestFrame(720, 1280, rng));
+    }
+
+    // 合成帧上不一定能检测到装甲板，准备一组带位姿的目标作为绘制负载
+    vector<TrackedArmor> load;
+    for (int k = 0; k < 8; k++) {
+        Vec3d rvec(0, 0.3 * (k - 4) / 4.0, 0);
+        Vec3d tvec(-0.6 + 0.15 * k, 0.1 * (k % 3 - 1), 2.0 + 0.2 * k);
+        vector<Point2f> corners;
+        projectPoints(detector.objectPoints(), rvec, tvec, detector.cameraMatrix(),
+                      detector.distCoeffs(), corners);
+        TrackedArmor armor(k, boundingRect(corners), corners);
+        detector.updatePose(armor);
+        load.push_back(armor);
+    }
+
+    // mode 0: 只检测；1: 检测后在同一线程里画（原来的做法）；2: 检测后提交给渲染线程
+    const char* names[] = {"不渲染", "同步渲染", "异步渲染"};
+    bool ok = true;
+    for (int mode = 0; mode < 3; mode++) {
+#ifdef ARMOR_HEADLESS
+        if (mode > 0) {
+            cout << names[mode] << ": ARMOR_HEADLESS 构建中不可用" << endl;
+            continue;
+        }
+#endif
+        ArmorRenderer renderer(detector);
+        if (mode == 2) renderer.start();
+        vector<double> latencies;
+        Mat canvas;
+
+        for (int f = 0; f < frames; f++) {
+            const Mat& frame = inputs[f % inputs.size()];
+            int64 t0 = getTickCount();
+            const vector<TrackedArmor>& armors = detector.processFrame(frame);
+            const vector<TrackedArmor>& shown = armors.empty() ? load : armors;
+#ifndef ARMOR_HEADLESS
+            if (mode == 1) {
+                frame.copyTo(canvas);
+                detector.drawResults(canvas, shown);
+            } else if (mode == 2) {
+                renderer.submit(f, frame, shown);
+            }
+#endif
+            latencies.push_back((getTickCount() - t0) * 1000.0 / getTickFrequency());
+        }
+        renderer.stop();
+
+        double sum = 0;
+        for (double v : latencies) sum += v;
+        cout << names[mode] << ": 检测路径平均 " << sum / frames << " ms, p99 "
+             << latencyPercentile(latencies, 0.99) << " ms";
+        if (mode == 2) {
+            cout << ", 渲染 " << renderer.renderedFrames() << " 帧, 丢弃 " << renderer.droppedFrames() << " 帧";
+            ok = ok && renderer.renderedFrames() > 0 &&
+                 renderer.renderedFrames() + renderer.droppedFrames() == (uint64_t)frames;
+        }
+        cout << endl;
+    }
+    return ok;
+}
+
+bool test_armor_zero_alloc() {
+    RNG rng(2024);
+    // 颜色模式下预处理是自己的逐行代码，三块装甲板让配对、跟踪都有活干
+    Mat frame = Mat::zeros(720, 1280, CV_8UC3);
+    for (int k = 0; k < 3; k++) {
+        drawArmor(frame, Point(250 + 380 * k, 360));
+    }
+    const int warmup = 3, frames = 20;
+
+    // 基准：检测路径调用的 OpenCV 算子自身（findContours 的临时存储等）每次调用都会申请内存，
+    // 这部分不归检测器管。输出同样复用，统计稳态下的分配次数。
+    ColorMaskParams params;
+    Mat binary;
+    vector<vector<Point>> contours;
+    for (int f = 0; f < warmup + frames; f++) {
+        if (f == warmup) AllocCounter::arm();
+        colorDifferenceMask(frame, binary, params);
+        findContours(binary, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+        for (const auto& contour : contours) {
+            if (contourArea(contour) >= 100) minAreaRect(contour);
+        }
+    }
+    size_t kernel_allocs = AllocCounter::count();
+    AllocCounter::disarm();
+
+    // 关掉位姿阶段，检测器在算子之外一次都不能分配
+    ArmorDetector detector;
+    detector.setColorMode(true, params);
+    detector.setPoseEnabled(false);
+    size_t tracked = 0;
+    for (int f = 0; f < warmup + frames; f++) {
+        if (f == warmup) AllocCounter::arm();
+        tracked = detector.processFrame(frame).size();
+    }
+    size_t detector_allocs = AllocCounter::count();
+    AllocCounter::disarm();
+
+    cout << frames << " 帧: OpenCV 算子分配 " << kernel_allocs << " 次, processFrame（不求位姿）分配 "
+         << detector_allocs << " 次" << endl;
+    if (tracked != 3 || detector.poseSolveCount() != 0) {
+        LOG_ERROR("测试帧里应跟踪到 3 块装甲板且不求位姿，实际 %zu 块、求解 %zu 次",
+                  tracked, detector.poseSolveCount());
+        return false;
+    }
+    if (detector_allocs != kernel_allocs) {
+        LOG_ERROR("检测器自身每帧仍有 %.1f 次堆分配",
+                  ((double)detector_allocs - (double)kernel_allocs) / frames);
+        return false;
+    }
+
+    // solvePnP 内部的分配不归检测器管，单独报告，不计入上面的断言
+    vector<Point2f> quad;
+    projectPoints(detector.objectPoints(), Vec3d(0, 0.3, 0), Vec3d(0.1, 0, 2.5), detector.cameraMatrix(),
+                  detector.distCoeffs(), quad);
+    Vec3d rvec, tvec;
+    detector.estimatePose(quad, rvec, tvec);
+    AllocCounter::arm();
+    detector.estimatePose(quad, rvec, tvec);
+    size_t solve_allocs = AllocCounter::count();
+    AllocCounter::disarm();
+
+    detector.setPoseEnabled(true);
+    size_t solves = detector.poseSolveCount();
+    AllocCounter::arm();
+    for (int f = 0; f < frames; f++) {
+        detector.processFrame(frame);
+    }
+    size_t pose_allocs = AllocCounter::count();
+    AllocCounter::disarm();
+    solves = detector.poseSolveCount() - solves;
+    cout << "开启位姿 " << frames << " 帧: solvePnP " << solves << " 次（单次约 " << solve_allocs
+         << " 次分配）, processFrame 分配 " << pose_allocs << " 次, 比不求位姿多 "
+         << (double)pose_allocs - (double)kernel_allocs << " 次" << endl;
+
+    // 配对和跟踪完全是自己的代码，稳态下一次都不能分配
+    vector<RotatedRect> bars = makeRandomBars(200, rng);
+    vector<ArmorDetection> detections;
+    for (int k = 0; k < 20; k++) {
+        detections.push_back(makeDetection(Rect(60 * k, 40 * (k % 5), 50, 30)));
+    }
+    LightBarPairer pairer;
+    vector<pair<int, int>> pairs;
+    ArmorTracker tracker;
+    for (int f = 0; f < warmup + frames; f++) {
+        if (f == warmup) AllocCounter::arm();
+        pairer.findPairs(bars, pairs);
+        tracker.update(detections);
+    }
+    size_t tracking_allocs = AllocCounter::count();
+    AllocCounter::disarm();
+
+    cout << "配对 + 跟踪 " << frames << " 帧: 分配 " << tracking_allocs << " 次" << endl;
+    return tracking_allocs == 0 && tracker.tracks().size() == detections.size();
+}
+
+bool test_armor_scene() {
+    SceneConfig config;
+    config.resolution = Size(960, 720);
+    config.armor_count = 5;
+    config.distractor_count = 6;
+    ArmorSceneGenerator a(config), b(config);
+    SceneFrame fa, fb;
+    const Mat& camera = a.cameraMatrix();
+
+    int visible = 0;
+    double max_pose_error = 0;
+    for (int f = 0; f < 50; f++) {
+        a.next(fa);
+        b.next(fb);
+        // 同一个 seed 的序列逐像素一致
+        if (fa.image.size() != config.resolution || norm(fa.image, fb.image, NORM_INF) != 0) {
+            LOG_ERROR("第 %d 帧两次生成的图像不一致", f);
+            return false;
+        }
+        if ((int)fa.armors.size() != config.armor_count) {
+            LOG_ERROR("第 %d 帧真值个数不对", f);
+            return false;
+        }
+        for (size_t i = 0; i < fa.armors.size(); i++) {
+            const SceneArmor& armor = fa.armors[i];
+            if (armor.id != (int)i || armor.bbox != fb.armors[i].bbox) {
+                LOG_ERROR("第 %d 帧装甲板 %d 的 id 或真值不稳定", f, (int)i);
+                return false;
+            }
+            if (!armor.visible) continue;
+            visible++;
+
+            // 真值角点和位姿一致：用生成器的内参反解应回到同一个平移
+            vector<Point2f> corners(armor.corners, armor.corners + 4);
+            Vec3d rvec, tvec;
+            solvePnP(ArmorSceneGenerator::objectPoints(), corners, camera, noArray(), rvec, tvec);
+            max_pose_error = max(max_pose_error, norm(tvec - armor.tvec));
+
+            // 灯条确实画出来了：左右灯条内侧附近应该是亮的
+            Point2f left = (armor.corners[0] + armor.corners[3]) * 0.5f;
+            Point2f right = (armor.corners[1] + armor.corners[2]) * 0.5f;
+            Point2f out = (left - right) * (1.f / max(1.f, (float)norm(left - right)));
+            Point pl = left + out, pr = right - out;
+            if (!Rect(Point(), config.resolution).contains(pl) || !Rect(Point(), config.resolution).contains(pr)) continue;
+            Vec3b cl = fa.image.at<Vec3b>(pl), cr = fa.image.at<Vec3b>(pr);
+            if (cl[2] < 150 || cr[2] < 150) {
+                LOG_ERROR("第 %d 帧装甲板 %d 的灯条不够亮", f, (int)i);
+                return false;
+            }
+        }
+    }
+
+    cout << "可见装甲板 " << visible << " 个, 真值位姿最大误差 " << max_pose_error * 1000 << " mm" << endl;
+    return visible > 0 && max_pose_error < 0.01;
+}
+
+// 检测结果与真值按 bbox IoU 贪心匹配后的累计统计
+struct SceneScore {
+    int tp;
+    int fp;
+    int fn;
+    int id_switches;
+    double corner_error;     // 匹配上的装甲板角点平均误差之和（像素）
+
+    SceneScore() : tp(0), fp(0), fn(0), id_switches(0), corner_error(0) {}
+
+    double precision() const { return tp + fp ? (double)tp / (tp + fp) : 0; }
+    double recall() const { return tp + fn ? (double)tp / (tp + fn) : 0; }
+};
+
+// track_of 记录每个真值 id 上一次匹配到的跟踪 id，用来统计 id 切换
+static void scoreFrame(const SceneFrame& scene, const vector<TrackedArmor>& armors,
+                       map<int, int>& track_of, SceneScore& score) {
+    const double min_iou = 0.5;
+    vector<pair<double, pair<int, int>>> candidates;
+    vector<bool> detection_used(armors.size(), false), truth_used(scene.armors.size(), false);
+    for (size_t i = 0; i < armors.size(); i++) {
+        // 丢失后沿预测滑行的目标不算本帧的检测
+        if (armors[i].misses > 0) {
+            detection_used[i] = true;
+            continue;
+        }
+        for (size_t j = 0; j < scene.armors.size(); j++) {
+            double iou = ArmorTracker::calculateIOU(armors[i].bbox, scene.armors[j].bbox);
+            if (iou >= min_iou) candidates.push_back(make_pair(iou, make_pair((int)i, (int)j)));
+        }
+    }
+    sort(candidates.begin(), candidates.end(),
+         [](const pair<double, pair<int, int>>& a, const pair<double, pair<int, int>>& b) { return a.first > b.first; });
+
+    for (const auto& c : candidates) {
+        int i = c.second.first, j = c.second.second;
+        if (detection_used[i] || truth_used[j]) continue;
+        detection_used[i] = truth_used[j] = true;
+        const SceneArmor& truth = scene.armors[j];
+        // 出画面的装甲板被检测到不算错，也不计入召回
+        if (!truth.visible) continue;
+
+        score.tp++;
+        double error = 0;
+        for (int k = 0; k < 4 && k < (int)armors[i].corners.size(); k++) {
+            error += norm(armors[i].corners[k] - truth.corners[k]) / 4;
+        }
+        score.corner_error += error;
+        auto last = track_of.find(truth.id);
+        if (last != track_of.end() && last->second != armors[i].id) score.id_switches++;
+        track_of[truth.id] = armors[i].id;
+    }
+    for (size_t i = 0; i < armors.size(); i++) {
+        if (!detection_used[i]) score.fp++;
+    }
+    for (size_t j = 0; j < scene.armors.size(); j++) {
+        if (!truth_used[j] && scene.armors[j].visible) score.fn++;
+    }
+}
+
+// 用 config 生成场景，setup 配置好的检测器逐帧处理并打分，前 warmup 帧不计。
+// latencies 不为空时追加每帧 processFrame 的耗时，stage_ms 不为空时累加各阶段耗时（都是毫秒）
+static SceneScore runScene(const SceneConfig& config, const function<void(ArmorDetector&)>& setup, int warmup,
+                           int frames, vector<double>* latencies = nullptr, ArmorStageTimes* stage_ms = nullptr) {
+    ArmorSceneGenerator generator(config);
+    ArmorDetector detector;
+    if (setup) setup(detector);
+    SceneFrame scene;
+    SceneScore score;
+    map<int, int> track_of;
+
+    for (int f = 0; f < warmup + frames; f++) {
+        generator.next(scene);
+        int64 t0 = getTickCount();
+        const vector<TrackedArmor>& armors = detector.processFrame(scene.image);
+        int64 t1 = getTickCount();
+        if (f < warmup) continue;
+        if (latencies) latencies->push_back((t1 - t0) * 1000.0 / getTickFrequency());
+        if (stage_ms) {
+            const ArmorStageTimes& t = detector.lastStageTimes();
+            stage_ms->preprocess += t.preprocess;
+            stage_ms->find_light_bars += t.find_light_bars;
+            stage_ms->pair_light_bars += t.pair_light_bars;
+            stage_ms->tracker += t.tracker;
+            stage_ms->pose += t.pose;
+        }
+        scoreFrame(scene, armors, track_of, score);
+    }
+    return score;
+}
+
+bool bench_armor_scene() {
+    const int armor_counts[] = {1, 2, 4, 8};
+    const Size resolutions[] = {Size(640, 480), Size(1280, 1024), Size(1920, 1080)};
+    const int warmup = 10, frames = 200;
+    // 单个配置的召回低于它时警告，全部配置合计低于 kMinTotalRecall 时基准失败，
+    // 免得检测器退化成什么都找不到时还在报帧率
+    const double kMinRecall = 0.2, kMinTotalRecall = 0.5;
+    SceneScore total;
+
+    // 场景是暗背景上的亮灯条。灰度自适应阈值（THRESH_BINARY, C = 2）会把平坦的背景也判为前景，
+    // 灯条成了背景里的洞，RETR_EXTERNAL 找不到它们，所以这里按敌方颜色用颜色差分预处理
+    for (const Size& resolution : resolutions) {
+        for (int count : armor_counts) {
+            SceneConfig config;
+            config.resolution = resolution;
+            config.armor_count = count;
+            config.distractor_count = 2 * count;
+            config.seed = 1000 + count;
+            vector<double> latencies;
+            SceneScore score = runScene(config, [&](ArmorDetector& detector) {
+                detector.setColorMode(true, ColorMaskParams(config.blue ? EnemyColor::BLUE : EnemyColor::RED));
+            }, warmup, frames, &latencies);
+            total.tp += score.tp;
+            total.fp += score.fp;
+            total.fn += score.fn;
+
+            double total_ms = 0;
+            for (double v : latencies) total_ms += v;
+            cout << resolution.width << "x" << resolution.height << ", " << count << " 块装甲板: "
+                 << total_ms / frames << " ms/帧 (p99 " << latencyPercentile(latencies, 0.99) << "), "
+                 << frames * 1000.0 / total_ms << " FPS, precision " << score.precision()
+                 << ", recall " << score.recall();
+            if (score.tp) {
+                cout << ", 角点误差 " << score.corner_error / score.tp << " px, id 切换 " << score.id_switches;
+            }
+            cout << endl;
+            if (score.recall() < kMinRecall) {
+                LOG_WARN("%dx%d, %d 块装甲板: recall %.3f 低于 %.2f", resolution.width, resolution.height, count,
+                         score.recall(), kMinRecall);
+                LOG_FLUSH();
+            }
+        }
+    }
+
+    cout << "合计 precision " << total.precision() << ", recall " << total.recall() << endl;
+    if (total.recall() < kMinTotalRecall) {
+        LOG_ERROR("合计 recall %.3f 低于 %.2f，帧率没有参考意义", total.recall(), kMinTotalRecall);
+        return false;
+    }
+    return true;
+}
+
+// 颜色差分二值化原来的 OpenCV 链路：通道分离后相减再阈值，灰度另做一次阈值，两者相与。
+// 中间图像由调用方传入，基准测试里跨帧复用
+struct ColorMaskBuffers {
+    vector<Mat> planes;
+    Mat diff, diff_binary, gray, bright_binary;
+};
+
+static void colorMaskReference(const Mat& frame, const ColorMaskParams& params, ColorMaskBuffers& buf,
+                               Mat& mask) {
+    split(frame, buf.planes);
+    bool blue = params.enemy == EnemyColor::BLUE;
+    subtract(buf.planes[blue ? 0 : 2], buf.planes[blue ? 2 : 0], buf.diff);
+    threshold(buf.diff, buf.diff_binary, params.diff_threshold, 255, THRESH_BINARY);
+    cvtColor(frame, buf.gray, COLOR_BGR2GRAY);
+    threshold(buf.gray, buf.bright_binary, params.brightness_threshold, 255, THRESH_BINARY);
+    bitwise_and(buf.diff_binary, buf.bright_binary, mask);
+}
+
+bool test_color_mask() {
+    RNG rng(20241118);
+    // 宽度覆盖不足一个向量、向量尾部和整幅图当作一行的情况
+    vector<Size> sizes = {Size(1, 1), Size(31, 7), Size(65, 33), Size(640, 480), Size(1919, 1081)};
+    vector<ColorMaskParams> params = {
+        ColorMaskParams(EnemyColor::RED), ColorMaskParams(EnemyColor::BLUE),
+        ColorMaskParams(EnemyColor::RED, 0, 0), ColorMaskParams(EnemyColor::BLUE, 255, 255),
+        ColorMaskParams(EnemyColor::RED, 1, 254), ColorMaskParams(EnemyColor::BLUE, 100, 60)
+    };
+    ColorMaskBuffers buf;
+
+    for (const auto& size : sizes) {
+        // 随机彩色像素，让颜色差和亮度都落在阈值两侧
+        Mat frame(size, CV_8UC3);
+        rng.fill(frame, RNG::UNIFORM, 0, 256);
+        // 不连续的子区域：每行单独处理
+        Mat window = frame(Rect(size.width / 4, size.height / 4, max(1, size.width / 2), max(1, size.height / 2)));
+
+        for (const auto& p : params) {
+            for (const Mat* input : {&frame, &window}) {
+                Mat expected, mask, diff;
+                colorMaskReference(*input, p, buf, expected);
+                colorDifferenceMask(*input, mask, p);
+                compare(expected, mask, diff, CMP_NE);
+                int wrong = countNonZero(diff);
+                if (wrong != 0) {
+                    LOG_ERROR("颜色差分二值化与 OpenCV 链路不一致: %dx%d, %s, 阈值 %d/%d, 不一致像素 %d",
+                              input->cols, input->rows, p.enemy == EnemyColor::BLUE ? "蓝" : "红",
+                              p.diff_threshold, p.brightness_threshold, wrong);
+                    return false;
+                }
+            }
+        }
+        cout << size.width << "x" << size.height << ": " << params.size() << " 组参数一致" << endl;
+    }
+
+    // 合成场景：敌方灯条应该出现在掩码里，白色灯光和反光不应该。
+    // 和装甲板同色的单根干扰灯条本来就会进掩码，要靠后面的配对去掉，这里不检查
+    for (bool blue : {false, true}) {
+        SceneConfig config;
+        config.blue = blue;
+        ArmorSceneGenerator generator(config);
+        SceneFrame scene;
+        ColorMaskParams p(blue ? EnemyColor::BLUE : EnemyColor::RED);
+        const int frames = 10;
+        int visible = 0, white_pixels = 0, leaked_pixels = 0, mismatched = 0;
+        for (int f = 0; f < frames; f++) {
+            generator.next(scene);
+            Mat expected, mask, diff;
+            colorMaskReference(scene.image, p, buf, expected);
+            colorDifferenceMask(scene.image, mask, p);
+            compare(expected, mask, diff, CMP_NE);
+            mismatched += countNonZero(diff);
+
+            // 每块可见装甲板的两根灯条：灯条内侧边中点附近（有一半落在灯条上）要有掩码像素
+            const Rect frame_rect(Point(0, 0), scene.image.size());
+            for (const auto& armor : scene.armors) {
+                if (!armor.visible) continue;
+                visible++;
+                const float height = (float)norm(armor.corners[3] - armor.corners[0]);
+                const int r = max(2, cvRound(height * 0.15f));
+                for (int side = 0; side < 2; side++) {
+                    const Point2f mid = side == 0 ? (armor.corners[0] + armor.corners[3]) * 0.5f
+                                                  : (armor.corners[1] + armor.corners[2]) * 0.5f;
+                    const Rect window = Rect(cvRound(mid.x) - r, cvRound(mid.y) - r, 2 * r + 1, 2 * r + 1) &
+                                        frame_rect;
+                    if (countNonZero(mask(window)) == 0) {
+                        LOG_ERROR("%s场景第 %d 帧: 装甲板 %d 的%s灯条不在掩码里", blue ? "蓝方" : "红方", f,
+                                  armor.id, side == 0 ? "左" : "右");
+                        return false;
+                    }
+                }
+            }
+
+            // 白色灯光和反光：三个通道都大于 180，颜色差很小，不应该进掩码。
+            // 装甲板灯条中心叠上光晕后也可能三个通道都很亮，所以去掉各装甲板附近
+            Mat white, leaked;
+            inRange(scene.image, Scalar::all(181), Scalar::all(255), white);
+            for (const auto& armor : scene.armors) {
+                const int margin = armor.bbox.height + 4;
+                Rect around(armor.bbox.x - margin, armor.bbox.y - margin, armor.bbox.width + 2 * margin,
+                            armor.bbox.height + 2 * margin);
+                white(around & frame_rect).setTo(0);
+            }
+            bitwise_and(white, mask, leaked);
+            white_pixels += countNonZero(white);
+            leaked_pixels += countNonZero(leaked);
+        }
+        cout << (blue ? "蓝方" : "红方") << "场景 " << frames << " 帧: 不一致像素 " << mismatched
+             << ", 可见装甲板 " << visible << ", 白色像素 " << white_pixels << ", 其中进掩码的 " << leaked_pixels
+             << endl;
+        if (mismatched != 0 || leaked_pixels != 0) return false;
+        if (visible == 0 || white_pixels == 0) {
+            LOG_ERROR("场景里没有可见装甲板或白色干扰，检查不到");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool bench_color_mask() {
+    RNG rng(12345);
+    vector<Size> sizes = {Size(640, 480), Size(1280, 1024), Size(1920, 1080), Size(3840, 2160)};
+    ColorMaskParams params(EnemyColor::RED);
+    ColorMaskBuffers buf;
+
+    for (const auto& size : sizes) {
+        Mat frame = makeTestFrame(size.height, size.width, rng);
+        Mat mask;
+        int iterations = size.area() > 4000000 ? 20 : 100;
+
+        // 预热，让两条路径的缓冲区都分配好
+        colorMaskReference(frame, params, buf, mask);
+        colorDifferenceMask(frame, mask, params);
+
+        int64 t0 = getTickCount();
+        for (int i = 0; i < iterations; i++) {
+            colorMaskReference(frame, params, buf, mask);
+        }
+        int64 t1 = getTickCount();
+        for (int i = 0; i < iterations; i++) {
+            colorDifferenceMask(frame, mask, params);
+        }
+        int64 t2 = getTickCount();
+
+        double ref_ms = (t1 - t0) * 1000.0 / getTickFrequency() / iterations;
+        double fused_ms = (t2 - t1) * 1000.0 / getTickFrequency() / iterations;
+        double mpix = size.area() / 1e6;
+        cout << size.width << "x" << size.height
+             << ": split + cvtColor + threshold " << ref_ms << " ms (" << mpix * 1000 / ref_ms << " MP/s)"
+             << ", 单趟 " << fused_ms << " ms (" << mpix * 1000 / fused_ms << " MP/s)"
+             << ", 加速 " << ref_ms / fused_ms << "x" << endl;
+    }
+
+    // 检测器整体：灰度自适应阈值和颜色差分两种预处理在合成场景上的耗时和检出率
+    const int warmup = 10, frames = 200;
+    for (bool blue : {false, true}) {
+        for (bool color_mode : {false, true}) {
+            SceneConfig config;
+            config.blue = blue;
+            config.armor_count = 4;
+            config.distractor_count = 8;
+            vector<double> latencies;
+            ArmorStageTimes stage_ms;
+            SceneScore score = runScene(config, [&](ArmorDetector& detector) {
+                detector.setColorMode(color_mode, ColorMaskParams(blue ? EnemyColor::BLUE : EnemyColor::RED));
+            }, warmup, frames, &latencies, &stage_ms);
+
+            double total_ms = 0;
+            for (double v : latencies) total_ms += v;
+            cout << (blue ? "蓝方" : "红方") << (color_mode ? ", 颜色差分" : ", 灰度自适应阈值")
+                 << ": 预处理 " << stage_ms.preprocess / frames << " ms/帧, 总计 " << total_ms / frames
+                 << " ms/帧, precision " << score.precision() << ", recall " << score.recall() << endl;
+        }
+    }
+    return true;
+}
+
+// 长边方向的角度，取 [0, 180)，两种矩形角度约定都换算到同一个量
+static float majorAxisAngle(const RotatedRect& r) {
+    float a = r.size.width >= r.size.height ? r.angle : r.angle + 90;
+    a = fmodf(a, 180.f);
+    return a < 0 ? a + 180 : a;
+}
+
+bool test_label_light_bars() {
+    // 画出倾斜的灯条、圆斑和小噪点，连通域统计和轮廓两条路径筛出的灯条应一一对应
+    RNG rng(20241214);
+    Mat binary(480, 640, CV_8UC1, Scalar(0));
+    for (int i = 0; i < 12; i++) {
+        RotatedRect bar(Point2f(50 + (i % 6) * 100, 120 + (i / 6) * 240),
+                        Size2f(rng.uniform(6.f, 14.f), rng.uniform(40.f, 90.f)), rng.uniform(-30.f, 30.f));
+        Point2f p[4];
+        bar.points(p);
+        vector<Point> poly;
+        for (const auto& v : p) poly.push_back(Point(cvRound(v.x), cvRound(v.y)));
+        fillConvexPoly(binary, poly, Scalar(255));
+    }
+    for (int i = 0; i < 5; i++) {
+        circle(binary, Point(80 + i * 120, 240), rng.uniform(6, 16), Scalar(255), -1);
+        circle(binary, Point(80 + i * 120, 450), 3, Scalar(255), -1);
+    }
+
+    ccl::Labeller labeller;
+    vector<ccl::Component> components;
+    labeller.label(binary, components);
+    vector<vector<Point>> contours;
+    findContours(binary, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+    if (components.size() != contours.size()) {
+        LOG_ERROR("连通域 %d 个，外轮廓 %d 个", (int)components.size(), (int)contours.size());
+        return false;
+    }
+
+    int contour_bars = 0, label_bars = 0;
+    for (const auto& c : components) {
+        if (c.area >= 100 && c.elongation() > 2.0) label_bars++;
+    }
+    for (const auto& contour : contours) {
+        if (contourArea(contour) < 100) continue;
+        RotatedRect rect = minAreaRect(contour);
+        if (max(rect.size.width, rect.size.height) / min(rect.size.width, rect.size.height) <= 2.0) continue;
+        contour_bars++;
+
+        Rect box = boundingRect(contour);
+        const ccl::Component* match = nullptr;
+        for (const auto& c : components) {
+            if (c.bbox == box) match = &c;
+        }
+        if (!match || match->area < 100 || match->elongation() <= 2.0) {
+            LOG_ERROR("(%d, %d) 处的灯条没有被连通域统计选中", box.x, box.y);
+            return false;
+        }
+        // 等效矩形和最小外接矩形：中心、长短边、长边方向都接近
+        RotatedRect eq = match->equivalentRect();
+        float long_eq = max(eq.size.width, eq.size.height), short_eq = min(eq.size.width, eq.size.height);
+        float long_mr = max(rect.size.width, rect.size.height), short_mr = min(rect.size.width, rect.size.height);
+        float angle_diff = fabsf(majorAxisAngle(eq) - majorAxisAngle(rect));
+        angle_diff = min(angle_diff, 180 - angle_diff);
+        if (norm(eq.center - rect.center) > 1.0 || fabsf(long_eq - long_mr) > 2 + 0.05f * long_mr ||
+            fabsf(short_eq - short_mr) > 2.5f || angle_diff > 4) {
+            LOG_ERROR("(%d, %d) 处的等效矩形 %.1fx%.1f@%.1f 与 minAreaRect %.1fx%.1f@%.1f 相差太大", box.x, box.y,
+                      long_eq, short_eq, majorAxisAngle(eq), long_mr, short_mr, majorAxisAngle(rect));
+            return false;
+        }
+    }
+    cout << "灯条: 轮廓路径 " << contour_bars << " 根, 连通域统计 " << label_bars << " 根" << endl;
+    if (contour_bars != 12 || label_bars != contour_bars) return false;
+
+    // 嵌套：空心框里的灯条也是连通域，但不是 RETR_EXTERNAL 的外轮廓，最外层过滤后要去掉
+    Mat nested(240, 320, CV_8UC1, Scalar(0));
+    rectangle(nested, Rect(20, 20, 200, 180), Scalar(255), 6);
+    rectangle(nested, Rect(60, 60, 10, 60), Scalar(255), -1);
+    rectangle(nested, Rect(140, 60, 10, 60), Scalar(255), -1);
+    circle(nested, Point(100, 150), 20, Scalar(255), 4);
+    rectangle(nested, Rect(97, 140, 6, 20), Scalar(255), -1);      // 框里的圆环里再套一根
+    rectangle(nested, Rect(260, 40, 10, 60), Scalar(255), -1);     // 框外的一根
+    labeller.label(nested, components);
+    ccl::OuterFilter outer_filter;
+    vector<uchar> outer;
+    outer_filter.compute(labeller, components, nested.size(), outer);
+    findContours(nested, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+    vector<Rect> outer_boxes, contour_boxes;
+    for (size_t i = 0; i < components.size(); i++) {
+        if (outer[i]) outer_boxes.push_back(components[i].bbox);
+    }
+    for (const auto& contour : contours) contour_boxes.push_back(boundingRect(contour));
+    auto byPosition = [](const Rect& a, const Rect& b) { return a.y != b.y ? a.y < b.y : a.x < b.x; };
+    sort(outer_boxes.begin(), outer_boxes.end(), byPosition);
+    sort(contour_boxes.begin(), contour_boxes.end(), byPosition);
+    cout << "嵌套: 连通域 " << components.size() << " 个, 最外层 " << outer_boxes.size() << " 个, 外轮廓 "
+         << contour_boxes.size() << " 个" << endl;
+    if (components.size() != 6 || outer_boxes != contour_boxes) {
+        LOG_ERROR("最外层连通域和外轮廓不一致");
+        return false;
+    }
+
+    // 检测器：空心框里的装甲板两种找灯条方式都不该检出
+    Mat framed = Mat::zeros(480, 640, CV_8UC3);
+    rectangle(framed, Rect(200, 120, 240, 240), Scalar(150, 150, 255), 8);
+    drawArmor(framed, Point(320, 240));
+    for (bool label_mode : {false, true}) {
+        ArmorDetector detector;
+        detector.setColorMode(true);
+        detector.setLabelMode(label_mode);
+        size_t found = detector.processFrame(framed).size();
+        if (found != 0) {
+            LOG_ERROR("%s: 空心框里的装甲板被检出 %d 块", label_mode ? "连通域统计" : "findContours", (int)found);
+            return false;
+        }
+    }
+
+    // 合成场景上两种找灯条方式的检出率
+    SceneConfig config;
+    config.armor_count = 4;
+    config.distractor_count = 8;
+    const int frames = 60;
+    int label_tp = 0;
+    for (bool label_mode : {false, true}) {
+        ArmorStageTimes stage_ms;
+        // 灰度自适应阈值下场景里的灯条是背景里的洞，两种方式都看不见，用颜色差分
+        SceneScore score = runScene(config, [&](ArmorDetector& detector) {
+            detector.setColorMode(true);
+            detector.setLabelMode(label_mode);
+        }, 0, frames, nullptr, &stage_ms);
+        cout << (label_mode ? "连通域统计" : "findContours + minAreaRect") << ": 找灯条 "
+             << stage_ms.find_light_bars / frames << " ms/帧, precision " << score.precision() << ", recall "
+             << score.recall() << endl;
+        if (label_mode) label_tp = score.tp;
+    }
+    return label_tp > 0;
+}
+
+bool test_mean_preprocess() {
+    RNG rng(20241231);
+    // 尺寸从大到小，覆盖缓冲区只增不减时取子区域的情况
+    vector<Size> sizes = {Size(1280, 1024), Size(640, 480), Size(301, 97), Size(64, 33)};
+    MeanPreprocessor preprocessor;
+
+    for (int block_size : {3, 11, 31, 61}) {
+        preprocessor.setBlockSize(block_size);
+        for (const auto& size : sizes) {
+            Mat frame = makeTestFrame(size.height, size.width, rng);
+            Mat expected = preprocessReference(frame, ADAPTIVE_THRESH_MEAN_C, block_size);
+
+            Mat binary, diff;
+            preprocessor.process(frame, binary);
+            compare(expected, binary, diff, CMP_NE);
+            int wrong = countNonZero(diff);
+            if (wrong != 0) {
+                LOG_ERROR("均值阈值预处理与 OpenCV 链路不一致: %dx%d, 窗口 %d, %d 个像素", size.width, size.height,
+                          block_size, wrong);
+                return false;
+            }
+        }
+    }
+    cout << "均值阈值预处理与 cvtColor + adaptiveThreshold(MEAN_C) + 闭运算 + 开运算逐像素一致" << endl;
+
+    // 检测器开启均值阈值后，积分图可以直接查询框内灰度的均值和方差
+    ArmorDetector detector;
+    detector.setMeanThresholdMode(true, 31);
+    Mat frame = makeTestFrame(480, 640, rng), gray;
+    detector.processFrame(frame);
+    cvtColor(frame, gray, COLOR_BGR2GRAY);
+    for (int i = 0; i < 20; i++) {
+        Rect r(rng.uniform(0, 600), rng.uniform(0, 440), rng.uniform(1, 40), rng.uniform(1, 40));
+        Scalar mean, stddev;
+        meanStdDev(gray(r), mean, stddev);
+        const integral::IntegralImage& table = detector.frameIntegral();
+        if (fabs(table.mean(r) - mean[0]) > 1e-9 || fabs(table.variance(r) - stddev[0] * stddev[0]) > 1e-6) {
+            LOG_ERROR("框 (%d, %d, %d, %d) 的积分图均值 %f 方差 %f，meanStdDev 为 %f %f", r.x, r.y, r.width, r.height,
+                      table.mean(r), table.variance(r), mean[0], stddev[0] * stddev[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool bench_mean_preprocess() {
+    RNG rng(12345);
+    Mat frame = makeTestFrame(1024, 1280, rng);
+    const int iterations = 50;
+    FusedPreprocessor fused;
+    MeanPreprocessor mean_pre;
+    Mat binary;
+
+    // 高斯窗口越大越慢；积分图均值阈值和窗口无关。融合预处理只支持 11
+    for (int block_size : {11, 31, 61}) {
+        mean_pre.setBlockSize(block_size);
+        preprocessReference(frame, ADAPTIVE_THRESH_GAUSSIAN_C, block_size);
+        mean_pre.process(frame, binary);
+
+        int64 t0 = getTickCount();
+        for (int i = 0; i < iterations; i++) {
+            preprocessReference(frame, ADAPTIVE_THRESH_GAUSSIAN_C, block_size);
+        }
+        int64 t1 = getTickCount();
+        for (int i = 0; i < iterations; i++) {
+            mean_pre.process(frame, binary);
+        }
+        int64 t2 = getTickCount();
+        double gauss_ms = (t1 - t0) * 1000.0 / getTickFrequency() / iterations;
+        double mean_ms = (t2 - t1) * 1000.0 / getTickFrequency() / iterations;
+
+        Mat gauss = preprocessReference(frame, ADAPTIVE_THRESH_GAUSSIAN_C, block_size), diff;
+        compare(gauss, binary, diff, CMP_NE);
+        cout << "1280x1024, 窗口 " << block_size << ": 高斯链路 " << gauss_ms << " ms";
+        if (block_size == FusedPreprocessor::kBlockSize) {
+            t0 = getTickCount();
+            for (int i = 0; i < iterations; i++) fused.process(frame, binary);
+            t1 = getTickCount();
+            cout << ", 融合高斯 " << (t1 - t0) * 1000.0 / getTickFrequency() / iterations << " ms";
+        }
+        cout << ", 积分图均值（含平方和表） " << mean_ms << " ms, 与高斯二值图不同的像素 "
+             << 100.0 * countNonZero(diff) / diff.total() << "%" << endl;
+    }
+
+    // 检测器整体：高斯和均值两种阈值在合成场景上的耗时和检出率
+    const int warmup = 10, frames = 200;
+    for (int block_size : {0, 11, 31}) {
+        SceneConfig config;
+        config.armor_count = 4;
+        config.distractor_count = 8;
+        ArmorStageTimes stage_ms;
+        SceneScore score = runScene(config, [&](ArmorDetector& detector) {
+            if (block_size > 0) detector.setMeanThresholdMode(true, block_size);
+        }, warmup, frames, nullptr, &stage_ms);
+
+        if (block_size > 0) {
+            cout << "均值阈值, 窗口 " << block_size;
+        } else {
+            cout << "融合高斯阈值, 窗口 11";
+        }
+        cout << ": 预处理 " << stage_ms.preprocess / frames << " ms/帧, precision " << score.precision()
+             << ", recall " << score.recall() << endl;
+    }
+    return true;
+}
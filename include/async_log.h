@@ -0,0 +1,176 @@
+/*
+ * log.h 的异步后端
+ *
+ * 调用处只把 格式串指针 + 时间戳 + 带类型的参数 编码进当前线程的无锁环形缓冲区
+ * （字符串参数按值拷贝），由后台线程按时间戳合并各线程的记录、格式化并写出。
+ *
+ * - 格式串必须是字符串字面量（LOG_* 宏本身就是这样用的），只保存指针；
+ * - 环形缓冲区满时丢弃新记录并计数，后台线程会输出一条丢弃提示，调用处从不阻塞；
+ * - 进程退出时（atexit）会写完剩下的记录，之后的日志退回同步输出；
+ * - 需要和 std::cout 等同步输出保持先后顺序时先调用 async_log::flush()。
+ */
+
+#ifndef __ASYNC_LOG_H__
+#define __ASYNC_LOG_H__
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+namespace async_log {
+
+/* 每个线程的环形缓冲区大小（字节） */
+static const size_t kRingBytes = 256 * 1024;
+/* 单个字符串参数最多拷贝的字节数，超出部分截断 */
+static const size_t kMaxStringBytes = 1024;
+
+enum ArgType : uint64_t {
+    kArgInt = 1,
+    kArgUInt,
+    kArgDouble,
+    kArgPointer,
+    kArgString
+};
+
+struct RecordHeader {
+    const char* format;     // nullptr 表示环尾的填充
+    uint64_t timestamp_ns;
+    uint32_t size;          // 整条记录的字节数，8 字节对齐
+    uint32_t num_args;
+};
+
+/* 每个参数占一个 16 字节的槽，字符串的内容紧跟在槽后面并补齐到 8 字节 */
+struct ArgSlot {
+    uint64_t type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const void* p;
+        uint64_t length;
+    };
+};
+
+inline size_t align8(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+inline size_t stringLength(const char* s) {
+    if (!s) return 6;   // "(null)"
+    size_t n = 0;
+    while (n < kMaxStringBytes && s[n]) n++;
+    return n;
+}
+
+/* 按参数类型编码，enable_if 选出对应的实现 */
+template <typename T, typename Enable = void>
+struct ArgCodec;
+
+template <typename T>
+struct ArgCodec<T, typename std::enable_if<(std::is_integral<T>::value && std::is_signed<T>::value) ||
+                                           std::is_enum<T>::value>::type> {
+    static size_t size(T) { return sizeof(ArgSlot); }
+    static void put(uint8_t*& p, T v) {
+        ArgSlot* slot = (ArgSlot*)p;
+        slot->type = kArgInt;
+        slot->i = (int64_t)v;
+        p += sizeof(ArgSlot);
+    }
+};
+
+template <typename T>
+struct ArgCodec<T, typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type> {
+    static size_t size(T) { return sizeof(ArgSlot); }
+    static void put(uint8_t*& p, T v) {
+        ArgSlot* slot = (ArgSlot*)p;
+        slot->type = kArgUInt;
+        slot->u = (uint64_t)v;
+        p += sizeof(ArgSlot);
+    }
+};
+
+template <typename T>
+struct ArgCodec<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    static size_t size(T) { return sizeof(ArgSlot); }
+    static void put(uint8_t*& p, T v) {
+        ArgSlot* slot = (ArgSlot*)p;
+        slot->type = kArgDouble;
+        slot->d = (double)v;
+        p += sizeof(ArgSlot);
+    }
+};
+
+template <typename T>
+struct ArgCodec<T*, typename std::enable_if<!std::is_same<typename std::remove_cv<T>::type, char>::value>::type> {
+    static size_t size(T*) { return sizeof(ArgSlot); }
+    static void put(uint8_t*& p, T* v) {
+        ArgSlot* slot = (ArgSlot*)p;
+        slot->type = kArgPointer;
+        slot->p = (const void*)v;
+        p += sizeof(ArgSlot);
+    }
+};
+
+template <typename T>
+struct ArgCodec<T*, typename std::enable_if<std::is_same<typename std::remove_cv<T>::type, char>::value>::type> {
+    static size_t size(const char* s) { return sizeof(ArgSlot) + align8(stringLength(s)); }
+    static void put(uint8_t*& p, const char* s) {
+        size_t n = stringLength(s);
+        ArgSlot* slot = (ArgSlot*)p;
+        slot->type = kArgString;
+        slot->length = n;
+        memcpy(p + sizeof(ArgSlot), s ? s : "(null)", n);
+        p += sizeof(ArgSlot) + align8(n);
+    }
+};
+
+inline size_t argsSize() { return 0; }
+
+template <typename T, typename... Rest>
+inline size_t argsSize(const T& v, const Rest&... rest) {
+    typedef typename std::decay<T>::type D;
+    return ArgCodec<D>::size(v) + argsSize(rest...);
+}
+
+inline void putArgs(uint8_t*&) {}
+
+template <typename T, typename... Rest>
+inline void putArgs(uint8_t*& p, const T& v, const Rest&... rest) {
+    typedef typename std::decay<T>::type D;
+    ArgCodec<D>::put(p, v);
+    putArgs(p, rest...);
+}
+
+/* 在当前线程的环里预留 size 字节，返回写入位置；环满时返回 nullptr 并计入丢弃 */
+uint8_t* begin_record(size_t size);
+/* 发布上一次 begin_record 预留的记录 */
+void commit_record();
+uint64_t now_ns();
+
+template <typename... Args>
+inline void write(const char* format, const Args&... args) {
+    const size_t size = align8(sizeof(RecordHeader) + argsSize(args...));
+    uint8_t* p = begin_record(size);
+    if (!p) return;
+
+    RecordHeader* header = (RecordHeader*)p;
+    header->format = format;
+    header->timestamp_ns = now_ns();
+    header->size = (uint32_t)size;
+    header->num_args = (uint32_t)sizeof...(Args);
+    p += sizeof(RecordHeader);
+    putArgs(p, args...);
+    commit_record();
+}
+
+/* 等到调用之前的所有记录都已写出；从没写过记录时直接返回，不启动后台线程 */
+void flush();
+/* 修改输出目标（默认 stdout），会先 flush */
+void set_output(FILE* file);
+/* 因环满被丢弃的记录总数 */
+uint64_t dropped();
+
+} // namespace async_log
+
+#endif // __ASYNC_LOG_H__
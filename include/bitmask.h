@@ -0,0 +1,83 @@
+/*
+ * 每像素 1 位的二值图
+ *
+ * 每行按 64 位字存放，第 x 个像素是第 x / 64 个字的第 x % 64 位（低位在前），
+ * 行尾不满一个字的位始终为 0。同样的二值图只有 CV_8UC1 的 1/8 大小，
+ * 阈值、形态学和行程提取都按整字处理，一次 64 个像素。
+ *
+ * - fromMat / toMat: 和 CV_8UC1 互相转换，非 0 为 1，1 转回 255
+ * - threshold:       灰度图直接阈值成位图，不产生 8 位的中间结果
+ * - erode / dilate:  矩形结构元素，锚点在中心，和 cv::erode / cv::dilate 的默认边界处理一致
+ * - extractRuns:     每行连续为 1 的区间，供基于行程的连通域和轮廓提取使用
+ */
+
+#ifndef __BITMASK_H__
+#define __BITMASK_H__
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace bitmask {
+
+class BitMask {
+public:
+    BitMask() : rows_(0), cols_(0), stride_(0) {}
+    BitMask(int rows, int cols) : rows_(0), cols_(0), stride_(0) { create(rows, cols); }
+
+    // 内容清零；容量只增不减，尺寸变小或不变时不重新分配
+    void create(int rows, int cols);
+    void setTo(bool value);
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    bool empty() const { return rows_ == 0 || cols_ == 0; }
+    int wordsPerRow() const { return stride_; }
+
+    uint64_t* row(int y) { return data_.data() + (size_t)y * stride_; }
+    const uint64_t* row(int y) const { return data_.data() + (size_t)y * stride_; }
+
+    bool get(int y, int x) const { return (row(y)[x >> 6] >> (x & 63)) & 1; }
+    void set(int y, int x, bool value) {
+        uint64_t bit = (uint64_t)1 << (x & 63);
+        if (value) row(y)[x >> 6] |= bit; else row(y)[x >> 6] &= ~bit;
+    }
+
+    // 为 1 的像素个数
+    int count() const;
+    // 每行最后一个字里有效位的掩码，用于清掉行尾
+    uint64_t tailMask() const { return (cols_ & 63) ? ((uint64_t)1 << (cols_ & 63)) - 1 : ~(uint64_t)0; }
+
+private:
+    int rows_;
+    int cols_;
+    int stride_;                    // 每行的字数
+    std::vector<uint64_t> data_;
+};
+
+// 一行里连续为 1 的像素 [begin, end)
+struct Run {
+    int y;
+    int begin;
+    int end;
+};
+
+// src: CV_8UC1，可以是不连续的子区域
+void fromMat(const cv::Mat& src, BitMask& dst);
+// dst: CV_8UC1，0 / 255（尺寸不变时复用内存）
+void toMat(const BitMask& src, cv::Mat& dst);
+
+// 与 cv::threshold(gray, thresh, 255, THRESH_BINARY) 相同：gray > thresh 为 1；
+// inverse 为 true 时对应 THRESH_BINARY_INV。gray: CV_8UC1
+void threshold(const cv::Mat& gray, int thresh, BitMask& dst, bool inverse = false);
+
+// ksize 的宽高都要是正数；dst 可以就是 src
+void erode(const BitMask& src, BitMask& dst, cv::Size ksize);
+void dilate(const BitMask& src, BitMask& dst, cv::Size ksize);
+
+// 清空 runs 后按行、行内按 x 递增输出所有行程
+void extractRuns(const BitMask& mask, std::vector<Run>& runs);
+
+} // namespace bitmask
+
+#endif // __BITMASK_H__
@@ -0,0 +1,110 @@
+/*
+ * 基于行程的连通域标记，一次扫描同时得到每个连通域的统计量
+ *
+ * 图像按行分成若干条带交给 cv::parallel_for_：条带内逐行提取前景行程，和上一行重叠的
+ * 行程用并查集合并（根总是下标最小的行程）；条带之间只需要合并相邻两行的行程。
+ * 最后按行程顺序编号，顺带累加面积、外接框和零到二阶矩，不访问像素、也不生成轮廓点。
+ *
+ * - 连通域按第一个像素的光栅顺序编号。4 连通时第 i 个就是 connectedComponents 的标签 i + 1；
+ *   8 连通时 OpenCV 按 2x2 块扫描，连通域完全相同，编号顺序可能不同
+ * - 矩是像素坐标的和，和 cv::moments(连通域掩码, true) 的 m10 .. m02 相同
+ * - equivalentRect: 二阶中心矩相同的实心矩形，拿来代替 minAreaRect 过滤灯条
+ *
+ * 行程可以由 8 位二值图提取，也可以直接用 bitmask::extractRuns 的结果。
+ *
+ * 连通域包括嵌在别的连通域洞里的块；OuterFilter 挑出最外层的，和 RETR_EXTERNAL 的外轮廓对应。
+ */
+
+#ifndef __CCL_H__
+#define __CCL_H__
+
+#include "bitmask.h"
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace ccl {
+
+struct Component {
+    int area;
+    cv::Rect bbox;
+    // 像素坐标的和：sum x, sum y, sum x^2, sum xy, sum y^2
+    int64_t m10, m01, m20, m11, m02;
+
+    cv::Point2d centroid() const { return cv::Point2d((double)m10 / area, (double)m01 / area); }
+
+    // 协方差矩阵的两个特征值（每像素），major >= minor
+    void principalVariances(double& major, double& minor) const;
+
+    // 长短轴方差之比开方，也就是等效矩形的长宽比近似；细长的灯条大，圆点接近 1
+    double elongation() const;
+
+    // 中心在质心、长宽 sqrt(12 * 方差 + 1)（n 个像素宽的实心条恰好得到 n）、沿主轴方向的矩形。
+    // 角度和 OpenCV 4.5 的 minAreaRect 一样取 (0, 90]，width 是沿 angle 方向的边
+    cv::RotatedRect equivalentRect() const;
+};
+
+class Labeller {
+public:
+    // binary 为 CV_8UC1，非 0 是前景；connectivity 取 4 或 8。
+    // 结果覆盖 components，容量和内部缓冲区跨调用复用
+    void label(const cv::Mat& binary, std::vector<Component>& components, int connectivity = 8);
+
+    // runs 按 (y, begin) 升序，比如 bitmask::extractRuns 的输出；rows 是图像行数
+    void label(const std::vector<bitmask::Run>& runs, int rows, std::vector<Component>& components,
+               int connectivity = 8);
+
+    // 以下都针对最近一次 label 的结果
+
+    // CV_32SC1，背景 0，第 i 个连通域为 i + 1
+    void labels(cv::Size size, cv::Mat& dst) const;
+
+    // keep[i] 非 0 的连通域画成 255，其余为 0
+    void paint(const std::vector<uchar>& keep, cv::Size size, cv::Mat& dst) const;
+
+    const std::vector<bitmask::Run>& runs() const { return runs_; }
+    // 每个行程所属的连通域
+    const std::vector<int>& runComponents() const { return run_label_; }
+
+    // 内部缓冲区当前占用的字节数（按容量算）
+    size_t bufferBytes() const;
+
+private:
+    struct Band {
+        int y0, y1;
+        int first, count;           // 在 runs_ 中的区间
+        std::vector<bitmask::Run> runs;
+        std::vector<int> parent;    // 条带内的下标
+    };
+
+    friend class OuterFilter;
+
+    void resolve(std::vector<Component>& components);
+
+    std::vector<Band> bands_;
+    std::vector<bitmask::Run> runs_;
+    std::vector<int> parent_;
+    std::vector<int> run_label_;
+    std::vector<int> row_start_;    // 每行第一个行程的下标，长度 rows + 1
+};
+
+// 找出 Labeller 最近一次 8 连通标记里最外层的连通域，也就是不在别的连通域的洞里的，
+// 和 findContours(RETR_EXTERNAL) 的外轮廓一一对应。
+// 每行前景行程之间的空隙就是背景行程，按 4 连通标记；碰到图像边界的背景在所有连通域外面。
+// 连通域第一个像素正上方的像素一定是它外侧的背景（它自己的洞都在这一行下面），
+// 这块背景碰到边界，连通域就在最外层。只用行程，不访问像素，缓冲区跨调用复用
+class OuterFilter {
+public:
+    // components 和 size 是那次 label 的结果和图像尺寸；outer[i] 非 0 表示第 i 个连通域在最外层
+    void compute(const Labeller& labeller, const std::vector<Component>& components, cv::Size size,
+                 std::vector<uchar>& outer);
+
+private:
+    Labeller background_;
+    std::vector<bitmask::Run> runs_;
+    std::vector<Component> components_;
+};
+
+} // namespace ccl
+
+#endif // __CCL_H__
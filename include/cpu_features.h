@@ -0,0 +1,38 @@
+/*
+ * 运行时检测 CPU 指令集
+ *
+ * 构建时不要求 -mavx2。AVX2 版本的函数单独加 __attribute__((target("avx2")))，
+ * 调用前用 cpuHasAVX2() 检测，CPU 不支持时退回 SSE2 或标量版本：
+ *
+ *   #ifdef CPU_AVX2_DISPATCH
+ *   __attribute__((target("avx2")))
+ *   static int rowAVX2(...) { ... }
+ *   #endif
+ *
+ *   #ifdef CPU_AVX2_DISPATCH
+ *       if (cpuHasAVX2()) x = rowAVX2(...);
+ *   #endif
+ *
+ * 只有 x86 上的 GCC / Clang 定义 CPU_AVX2_DISPATCH。
+ */
+
+#ifndef __CPU_FEATURES_H__
+#define __CPU_FEATURES_H__
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define CPU_AVX2_DISPATCH
+#endif
+
+#ifdef CPU_AVX2_DISPATCH
+// 第一次调用时检测，之后返回缓存的结果
+inline bool cpuHasAVX2() {
+    static const bool avx2 = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return avx2;
+}
+#endif
+
+#endif // __CPU_FEATURES_H__
@@ -0,0 +1,56 @@
+/*
+ * 和参考答案图像比较
+ *
+ * 用整幅图像的 OpenCV 运算（absdiff、norm、countNonZero 等）算出差异指标，
+ * 不逐像素 at<>() 访问。多通道图像按像素取各通道差值的最大值。
+ *
+ * - max_diff / mean_diff: 最大、平均绝对差
+ * - over_fraction:        差值超过 tolerance 的像素比例
+ * - over_count:           差值超过 tolerance 的像素个数，tolerance 为 0 时就是不一致的像素数
+ * - psnr:                 峰值信噪比 (dB)，完全相同时为 +inf
+ * - iou:                  两幅图各自取 > 127 的前景后的交并比，适合二值图和线条图
+ */
+
+#ifndef __GOLDEN_H__
+#define __GOLDEN_H__
+
+#include <opencv2/opencv.hpp>
+
+namespace golden {
+
+struct DiffStats {
+    bool comparable;        // 尺寸和类型一致，否则其余指标无意义
+    double max_diff;
+    double mean_diff;
+    double over_fraction;
+    int over_count;
+    double psnr;
+    double iou;
+};
+
+// 通过条件，各项都要满足；不关心的项保持默认值即可
+struct Tolerance {
+    double pixel;               // 单像素允许的绝对差
+    double max_over_fraction;   // 超过 pixel 的像素最多占多少
+    double min_psnr;
+    double min_iou;
+
+    Tolerance() : pixel(0), max_over_fraction(0), min_psnr(0), min_iou(0) {}
+};
+
+DiffStats compare(const cv::Mat& actual, const cv::Mat& expected, double tolerance = 0);
+
+bool passes(const DiffStats& stats, const Tolerance& tolerance);
+
+// 比较并打印指标；不通过时把差异图写到 golden_diff_<name>.png
+bool check(const char* name, const cv::Mat& actual, const cv::Mat& expected, const Tolerance& tolerance);
+
+// 二值图 / 线条图的前景 IoU，先各自膨胀 dilate 像素，容忍线条粗细和一两个像素的偏移
+double mask_iou(const cv::Mat& a, const cv::Mat& b, int dilate = 0);
+
+double rect_iou(const cv::Rect& a, const cv::Rect& b);
+double rotated_rect_iou(const cv::RotatedRect& a, const cv::RotatedRect& b);
+
+} // namespace golden
+
+#endif // __GOLDEN_H__
@@ -0,0 +1,63 @@
+/*
+ * 每帧一次的灰度直方图和阈值服务
+ *
+ * 灰度转换按 16 行一块做 cvtColor，块还在 L1 里时顺手统计直方图，整帧只扫一遍；
+ * 之后同一帧的各个环节都从这份直方图取阈值，不再各自重建。
+ *
+ * - otsu:       和 cv::threshold(THRESH_OTSU) 选出的阈值逐个相同
+ * - percentile: 累计像素数达到比例 q 的最小灰度，比如 0.99 是最亮的 1% 的下界
+ * - SmoothedThreshold: 视频流里对每帧的阈值做指数平滑，抑制帧间跳变
+ *
+ * 得到的阈值直接交给 cv::threshold（不带 THRESH_OTSU）即可。
+ */
+
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+
+namespace histogram {
+
+class FrameHistogram {
+public:
+    FrameHistogram() { reset(); }
+
+    // bgr 为 CV_8UC3，gray 得到和 cvtColor(COLOR_BGR2GRAY) 相同的结果，尺寸不变时复用内存
+    void update(const cv::Mat& bgr, cv::Mat& gray);
+    // 已经有灰度图时只统计直方图
+    void updateGray(const cv::Mat& gray);
+    void reset();
+
+    const uint32_t* bins() const { return bins_; }
+    int total() const { return total_; }
+
+    // 第一次查询时由直方图算出，同一帧的后续查询直接返回
+    int otsu() const;
+    // q 取 [0, 1]，空图返回 0。只扫一遍 256 个桶，不缓存
+    int percentile(double q) const;
+
+private:
+    uint32_t bins_[256];
+    int total_;
+    mutable int otsu_;      // -1 表示还没算
+};
+
+// 指数平滑：t = alpha * 本帧 + (1 - alpha) * 上一帧，第一帧直接取本帧
+class SmoothedThreshold {
+public:
+    explicit SmoothedThreshold(double alpha = 0.2) : alpha_(alpha), value_(-1) {}
+
+    // 输入本帧的原始阈值，返回平滑后四舍五入的阈值
+    int update(int raw);
+    int value() const { return value_ < 0 ? 0 : cvRound(value_); }
+    void reset() { value_ = -1; }
+
+private:
+    double alpha_;
+    double value_;
+};
+
+} // namespace histogram
+
+#endif // __HISTOGRAM_H__
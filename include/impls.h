@@ -14,7 +14,9 @@ std::vector<cv::Mat> threshold(const cv::Mat& src, int threshold_value);
 std::vector<cv::Mat> erode(const cv::Mat& src_erode, const cv::Mat& src_dilate);
 
 // 练习 (4)
-std::vector<std::vector<cv::Point>> find_contours(const cv::Mat& input);
+// leaf_only 为 false 时按 RETR_TREE 提取全部轮廓再筛选，两种模式结果相同。
+// min_blob_area > 0 时先抹掉面积小于它的前景块再找轮廓，默认不过滤
+std::vector<std::vector<cv::Point>> find_contours(const cv::Mat& input, bool leaf_only = true, int min_blob_area = 0);
 
 // 练习 (5)
 std::pair<cv::Rect, cv::RotatedRect> get_rect_by_contours(const cv::Mat& input);
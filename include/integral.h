@@ -0,0 +1,79 @@
+/*
+ * 每帧一次的积分图（和表、平方和表）服务
+ *
+ * 建表按行分成若干块交给 cv::parallel_for_：块内每行先求前缀和，再整行加上上一行
+ * （连续相加，编译器自动向量化）；各块最后一行的累计依次传下去，再加到后面块的每一行上。
+ * 单线程时只有一块，整张表只写一遍。建好之后任意矩形框的像素和、均值、方差都是 4 次查表，
+ * 与框的大小无关。
+ *
+ * - border > 0 时按 BORDER_REPLICATE 向四周各扩 border 个像素再建表（不生成扩边后的图），
+ *   查询框可以超出图像 border 个像素，和对 copyMakeBorder 后的图查询相同
+ * - border 为 0 时表和 cv::integral(gray, sum, sqsum, CV_32S, CV_64F) 逐个相同
+ * - adaptiveMeanThreshold: 和 adaptiveThreshold(ADAPTIVE_THRESH_MEAN_C, THRESH_BINARY) 逐像素相同，
+ *   每个像素比较一次框内和，耗时与窗口大小无关
+ *
+ * 和表是 32 位整数，图像（含扩边）不超过 8M 像素；平方和表是 double，整数都是精确的。
+ */
+
+#ifndef __INTEGRAL_H__
+#define __INTEGRAL_H__
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace integral {
+
+class IntegralImage {
+public:
+    IntegralImage() : border_(0), squares_(false) {}
+
+    // gray 为 CV_8UC1。squares 为 false 时不建平方和表，sqsum / variance 不可用。
+    // 表的缓冲区只增不减，尺寸变小（比如 ROI 窗口）时不重新分配
+    void build(const cv::Mat& gray, int border = 0, bool squares = true);
+
+    // 以下 r 都是原图坐标，可以超出图像 border() 个像素
+
+    int sum(const cv::Rect& r) const {
+        const int* top = sum_.ptr<int>(r.y + border_) + r.x + border_;
+        const int* bottom = sum_.ptr<int>(r.y + r.height + border_) + r.x + border_;
+        return bottom[r.width] - bottom[0] - top[r.width] + top[0];
+    }
+    double sqsum(const cv::Rect& r) const {
+        const double* top = sqsum_.ptr<double>(r.y + border_) + r.x + border_;
+        const double* bottom = sqsum_.ptr<double>(r.y + r.height + border_) + r.x + border_;
+        return bottom[r.width] - bottom[0] - top[r.width] + top[0];
+    }
+    double mean(const cv::Rect& r) const { return (double)sum(r) / r.area(); }
+    // 总体方差，和 cv::meanStdDev 的标准差平方相同
+    double variance(const cv::Rect& r) const;
+
+    cv::Size size() const { return size_; }
+    int border() const { return border_; }
+    bool hasSquares() const { return squares_; }
+
+    // (rows + 2 * border + 1) x (cols + 2 * border + 1)，第 0 行、第 0 列为 0
+    const cv::Mat& sums() const { return sum_; }
+    const cv::Mat& sqsums() const { return sqsum_; }
+
+private:
+    cv::Mat sum_buf_;
+    cv::Mat sqsum_buf_;
+    cv::Mat sum_;       // sum_buf_ 左上角的视图
+    cv::Mat sqsum_;
+    cv::Size size_;
+    int border_;
+    bool squares_;
+
+    // 按行分块并行建表时，每块要加上的前面各块的累计
+    std::vector<int> band_offsets_;
+    std::vector<double> band_sq_offsets_;
+};
+
+// table 须由同一张 gray 建成，且 border >= block_size / 2；block_size 为 3 到 1023 的奇数。
+// binary 为 CV_8UC1，尺寸不变时复用内存
+void adaptiveMeanThreshold(const IntegralImage& table, const cv::Mat& gray, cv::Mat& binary, int block_size,
+                           double C);
+
+} // namespace integral
+
+#endif // __INTEGRAL_H__
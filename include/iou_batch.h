@@ -0,0 +1,57 @@
+/*
+ * 成批计算轴对齐矩形的 IoU
+ *
+ * 矩形按 SoA 存放（x1、y1、x2、y2、面积各一个数组），一次算一个矩形和另一组里一段
+ * 连续矩形的 IoU，内层循环用 SSE2 / AVX2 一次处理 4 / 8 对，AVX2 在运行时检测。
+ *
+ * - iou:        单对矩形，和批量版本用同样的 float 运算顺序，结果逐位一致
+ * - iou_matrix: a.size() x b.size() 的稠密矩阵，行主序
+ * - iou_pairs:  只输出 IoU 大于阈值的对，适合大部分对不相交的场景
+ *
+ * 没有交集（包括只有边相接、空矩形）时 IoU 为 0。坐标转成 float，绝对值不超过 2^24 时精确。
+ */
+
+#ifndef __IOU_BATCH_H__
+#define __IOU_BATCH_H__
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace iou_batch {
+
+struct RectSoA {
+    std::vector<float> x1, y1, x2, y2, area;
+
+    // 容量跨调用保留，稳态下不分配内存
+    void assign(const std::vector<cv::Rect>& rects);
+    void clear();
+    void push_back(const cv::Rect& rect);
+    int size() const { return (int)x1.size(); }
+};
+
+struct IouPair {
+    int a;      // a 组里的下标
+    int b;      // b 组里的下标
+    float iou;
+};
+
+float iou(const cv::Rect& a, const cv::Rect& b);
+
+// a[i] 和 b[begin, end) 的 IoU，写到 out[0, end - begin)
+void iou_row(const RectSoA& a, int i, const RectSoA& b, int begin, int end, float* out);
+
+// out 至少要有 a.size() * b.size() 个元素
+void iou_matrix(const RectSoA& a, const RectSoA& b, float* out);
+void iou_matrix(const RectSoA& a, const RectSoA& b, cv::Mat& out);  // CV_32F，a.size() 行
+
+// a[i] 和 b[begin, end) 中 IoU > threshold 的对追加到 out，按 b 的下标递增。
+// 阈值按 double 比较：输出的对和 (double)iou > threshold 逐个判断的结果一致
+void iou_row_pairs(const RectSoA& a, int i, const RectSoA& b, int begin, int end,
+                   double threshold, std::vector<IouPair>& out);
+
+// 清空 out 后输出所有 IoU > threshold 的对，按 (a, b) 字典序
+void iou_pairs(const RectSoA& a, const RectSoA& b, double threshold, std::vector<IouPair>& out);
+
+} // namespace iou_batch
+
+#endif // __IOU_BATCH_H__
@@ -0,0 +1,67 @@
+/*
+ * 只提取最内层轮廓
+ *
+ * findContours(RETR_TREE) 会追踪每一条边界、生成全部点列和层次结构，而只要最内层轮廓时
+ * 有子轮廓的那些点列都白算了。这里先用行程标记弄清包含关系，再只追踪叶子：
+ *
+ * - 前景按 8 连通、背景（前景行程之间的空隙）按 4 连通各标记一次，
+ *   不碰图像边界的背景连通域就是孔
+ * - 孔第一个像素左边的前景行程属于它的外层连通域；前景连通域第一个像素左边的孔是它的外层
+ * - 没有孔的前景连通域，其外边界是叶子：这些连通域一起画到一张图上做一次 RETR_EXTERNAL
+ * - 不含前景的孔，其边界是叶子：每个孔单独放进一小块（孔以外全是前景），所有小块拼成一张图
+ *   做一次 RETR_LIST，取出孔边界。外层连通域完整的外边界不会被追踪
+ *
+ * 每条轮廓的点和 findContours(RETR_TREE, CHAIN_APPROX_SIMPLE) 里 hierarchy[i][2] == -1
+ * 的那条逐点相同（起点、方向都一样），只是顺序不同：先是前景的外边界，再是孔边界。
+ */
+
+#ifndef __LEAF_CONTOURS_H__
+#define __LEAF_CONTOURS_H__
+
+#include "ccl.h"
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace ccl {
+
+class LeafContours {
+public:
+    LeafContours() : holes_(0) {}
+
+    // binary 为 CV_8UC1，非 0 是前景。结果覆盖 contours，内部缓冲区跨调用复用
+    void find(const cv::Mat& binary, std::vector<std::vector<cv::Point>>& contours);
+
+    // 最近一次 find 的前景连通域数和孔数，也就是 RETR_TREE 的轮廓总数
+    int borderCount() const { return (int)(fg_components_.size() + holes_); }
+    // 内部缓冲区当前占用的字节数（按容量算），不含输出的点列
+    size_t bufferBytes() const;
+
+private:
+    Labeller fg_;
+    Labeller bg_;
+    std::vector<Component> fg_components_;
+    std::vector<Component> bg_components_;
+    std::vector<bitmask::Run> gaps_;    // 背景行程
+    std::vector<uchar> keep_;           // 前景连通域没有孔
+    std::vector<uchar> hole_leaf_;      // 孔里没有前景
+    int holes_;
+
+    // 拼图里的一块：原图上的 src 对应拼图上以 dst 为左上角的区域
+    struct Tile {
+        cv::Rect src;
+        cv::Point dst;
+        int hole;
+    };
+
+    cv::Mat canvas_;            // 没有孔的前景连通域
+    cv::Mat mosaic_;            // 叶子孔所在的小块
+    std::vector<Tile> tiles_;
+    std::vector<int> hole_tile_;    // 叶子孔所在的小块，其它为 -1
+    std::vector<int> shelf_y_;      // 拼图每一行小块的起始 y
+    std::vector<int> shelf_first_;  // 和第一块的下标
+    std::vector<std::vector<cv::Point>> tile_contours_;
+};
+
+} // namespace ccl
+
+#endif // __LEAF_CONTOURS_H__
@@ -21,12 +21,24 @@
 #define LOG_MSG(format, ...)           __LOG_MSG__(format, ##__VA_ARGS__)
 #define LOG_VAR(var_name, format, ...) __LOG_VAR__(var_name, format, ##__VA_ARGS__)
 
+/* 等待之前的日志全部写出，和 std::cout 混用时用来保证先后顺序 */
+#define LOG_FLUSH()                    __LOG_FLUSH__()
+
 
 /* =========================== Log implementation ========================== */
 
 /* utils */
 #define __LOCATION__            "At " __FILE__ ":" "%d "
-#define __OUTPUT__(format, ...) fprintf(stdout, format, ##__VA_ARGS__)
+
+/* TJURM_ASYNC_LOG: 调用处只把参数写进线程本地的环形缓冲区，由后台线程格式化输出，见 async_log.h */
+#ifdef TJURM_ASYNC_LOG
+    #include "async_log.h"
+    #define __OUTPUT__(format, ...) async_log::write(format, ##__VA_ARGS__)
+    #define __LOG_FLUSH__()         async_log::flush()
+#else
+    #define __OUTPUT__(format, ...) fprintf(stdout, format, ##__VA_ARGS__)
+    #define __LOG_FLUSH__()         fflush(stdout)
+#endif
 
 /* log levels */
 #define __NONE__    0
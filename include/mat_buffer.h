@@ -0,0 +1,22 @@
+/*
+ * 跨帧复用的 Mat 缓冲区
+ *
+ * 类成员里放一块缓冲区，每次调用按需要的尺寸取它左上角的子区域。缓冲区只增不减，
+ * 尺寸变小时（比如 ROI 窗口）不重新分配，稳态下不申请堆内存。
+ */
+
+#ifndef __MAT_BUFFER_H__
+#define __MAT_BUFFER_H__
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+
+// 返回 buf 左上角 rows x cols 的视图；buf 不够大或类型不同时才重新分配
+inline cv::Mat reserveBuffer(cv::Mat& buf, int rows, int cols, int type) {
+    if (buf.rows < rows || buf.cols < cols || buf.type() != type) {
+        buf.create(std::max(rows, buf.rows), std::max(cols, buf.cols), type);
+    }
+    return buf(cv::Rect(0, 0, cols, rows));
+}
+
+#endif // __MAT_BUFFER_H__
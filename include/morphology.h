@@ -0,0 +1,90 @@
+/*
+ * 矩形结构元素的灰度形态学（CV_8UC1）
+ *
+ * 矩形核可分离，先竖直后水平各做一次一维的最小 / 最大值滤波。一维滤波用
+ * van Herk / Gil-Werman 算法：按核长 k 分段，段内做前缀和后缀的最值，
+ * 每个窗口的结果是一个后缀和一个前缀的最值，每个像素 3 次比较，与 k 无关。
+ *
+ * - 竖直方向整行整行地比较，SSE2 一次 16 个像素
+ * - 水平方向每 16 行转置成一串 16 字节的向量，同样整向量地比较，再转置回来；
+ *   核很小时直接比较平移后的行更快，不转置
+ *
+ * 锚点在核的中心，边界与 cv::erode / cv::dilate 的默认值一致（界外不影响结果），
+ * 结果和 OpenCV 逐像素相同。
+ */
+
+#ifndef __MORPHOLOGY_H__
+#define __MORPHOLOGY_H__
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace morph {
+
+enum Op { ERODE, DILATE };
+
+// 单次腐蚀 / 膨胀，中间缓冲区跨调用复用，尺寸不变时不再分配
+class Morphology {
+public:
+    // src、dst 为 CV_8UC1，可以是同一个 Mat，也可以是不连续的子区域。
+    // src 当作一幅独立的图像处理（相当于 BORDER_ISOLATED），ksize 的宽高都要是正数
+    void apply(Op op, const cv::Mat& src, cv::Mat& dst, cv::Size ksize);
+    void erode(const cv::Mat& src, cv::Mat& dst, cv::Size ksize) { apply(ERODE, src, dst, ksize); }
+    void dilate(const cv::Mat& src, cv::Mat& dst, cv::Size ksize) { apply(DILATE, src, dst, ksize); }
+
+private:
+    void vertical(Op op, const cv::Mat& src, cv::Mat& dst, int k);
+    void horizontal(Op op, const cv::Mat& src, cv::Mat& dst, int k);
+
+    cv::Mat vbuf_;                  // 竖直方向的结果
+    std::vector<uchar> strip_;      // 水平方向：16 行转置后的条带和结果
+    std::vector<uchar> strip_out_;
+    std::vector<uchar> suffix_;     // 一段 k 行的后缀最值
+    std::vector<uchar> prefix_;
+    std::vector<uchar> fill_;       // 界外的一行
+    std::vector<uchar> padded_;     // 小核直接比较时补了边界的一行
+};
+
+// 一串腐蚀 / 膨胀在 L2 大小的行块内一次做完：每块带上下 halo 行，中间结果留在缓存里，
+// 整幅图只读一次、写一次。每一步的边界处理与单独调用 OpenCV 相同，
+// 比如 close(3x3) 接 open(3x3) 与 morphologyEx(CLOSE) 再 morphologyEx(OPEN) 逐像素一致
+class MorphSequence {
+public:
+    // l2_bytes 为 0 时按 256KB
+    explicit MorphSequence(size_t l2_bytes = 0);
+
+    MorphSequence& erode(cv::Size ksize);
+    MorphSequence& dilate(cv::Size ksize);
+    MorphSequence& close(cv::Size ksize);     // 膨胀后腐蚀
+    MorphSequence& open(cv::Size ksize);      // 腐蚀后膨胀
+    void clear() { steps_.clear(); }
+
+    // src、dst 为 CV_8UC1，dst 尺寸不变时复用内存，不能和 src 共享数据
+    void apply(const cv::Mat& src, cv::Mat& dst);
+
+    // 每块上下各需要的 halo 行数：各步竖直半径之和
+    int haloRows() const;
+    // 最近一次处理所用的块行数（不含 halo）
+    int tileRows() const { return tile_rows_; }
+
+private:
+    struct Step {
+        Op op;
+        cv::Size ksize;
+    };
+
+    std::vector<Step> steps_;
+    size_t l2_bytes_;
+    int tile_rows_;
+    Morphology engine_;
+    cv::Mat ping_;
+    cv::Mat pong_;
+};
+
+// 临时构造引擎的便捷版本
+void erode(const cv::Mat& src, cv::Mat& dst, cv::Size ksize);
+void dilate(const cv::Mat& src, cv::Mat& dst, cv::Size ksize);
+
+} // namespace morph
+
+#endif // __MORPHOLOGY_H__
@@ -0,0 +1,71 @@
+/*
+ * 按标签统计每个区域的颜色
+ *
+ * 逐个区域取外接框再 cv::mean，框互相重叠时同一批像素要读好几遍，框里的背景也算了进去。
+ * 这里对彩色图和标签（标签图，或者 ccl::Labeller 的行程）只扫一遍，所有区域的统计量一起得到，
+ * 只算真正属于区域的像素：
+ *
+ * - 先把每一段同标签的连续像素（一个行程）累加成小计，各段互不相干，可以并行；
+ *   再按标签把小计加起来。额外内存和段数成正比，和区域数、线程数无关
+ * - 均值、方差和 cv::meanStdDev(bgr, 区域掩码) 相同（方差是总体方差）
+ * - 主色有两种：meanColour 是均值里最大的通道，和 roi_color 原来的判断一样；
+ *   dominant 是逐像素投票，最大通道得票最多的那个，不会被少数很亮的像素带偏
+ *
+ * 颜色编号和 roi_color 一致：Blue 0, Green 1, Red 2，没有严格最大的为 -1。
+ */
+
+#ifndef __REGION_STATS_H__
+#define __REGION_STATS_H__
+
+#include "bitmask.h"
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace region {
+
+struct ColourStats {
+    int area;
+    int64_t sum[3];     // B, G, R 之和
+    int64_t sqsum[3];   // 平方和
+    int votes[3];       // 该通道严格大于另外两个的像素数
+
+    cv::Scalar mean() const;
+    cv::Scalar variance() const;
+
+    // 均值里严格最大的通道
+    int meanColour() const;
+    // 得票严格最多的通道
+    int dominant() const;
+};
+
+class ColourStatistics {
+public:
+    // bgr 为 CV_8UC3；labels 为同尺寸的 CV_32SC1，0 是背景，1 .. count 是区域，
+    // 比如 connectedComponents 或 ccl::Labeller::labels 的结果。stats[i] 对应标签 i + 1，结果覆盖 stats
+    void compute(const cv::Mat& bgr, const cv::Mat& labels, int count, std::vector<ColourStats>& stats);
+
+    // 行程版：runs 和 run_labels 来自 ccl::Labeller（runs() 和 runComponents()），
+    // stats[i] 对应第 i 个连通域。只访问前景像素，也不用生成标签图
+    void compute(const cv::Mat& bgr, const std::vector<bitmask::Run>& runs, const std::vector<int>& run_labels,
+                 int count, std::vector<ColourStats>& stats);
+
+private:
+    // 一段同标签像素的小计。一行最多 65535 个像素时平方和也不会溢出
+    struct Span {
+        int label;      // 从 0 开始
+        uint32_t area;
+        uint32_t sum[3];
+        uint32_t sqsum[3];
+        uint32_t votes[3];
+    };
+
+    void reduce(const std::vector<Span>& spans, std::vector<ColourStats>& stats) const;
+
+    std::vector<std::vector<Span>> chunks_;     // 标签图版每块行的小计
+    std::vector<Span> spans_;                   // 行程版每个行程的小计
+};
+
+} // namespace region
+
+#endif // __REGION_STATS_H__
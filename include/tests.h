@@ -9,18 +9,60 @@ bool test_split();
 
 bool test_threshold();
 
+bool test_histogram();
+
+bool bench_histogram();
+
+bool test_integral();
+
+bool bench_integral();
+
 bool test_erode();
 
 bool test_find_contours();
 
+bool test_ccl();
+
+bool bench_ccl();
+
+bool test_leaf_contours();
+
+bool bench_leaf_contours();
+
 bool test_get_rect_by_contours();
 
 bool test_compute_iou();
 
+bool test_iou_batch();
+
+bool bench_iou_batch();
+
 bool test_compute_area_ratio();
 
 bool test_roi_color();
 
+bool test_region_stats();
+
+bool bench_region_stats();
+
 bool test_my_resize();
 
+bool bench_my_resize();
+
+bool test_resize_types();
+
+bool bench_resize_scaling();
+
+bool test_bitmask();
+
+bool bench_bitmask();
+
+bool test_morphology();
+
+bool bench_morphology();
+
+bool test_async_log();
+
+bool bench_async_log();
+
 #endif
@@ -0,0 +1,63 @@
+/*
+ * 作用域计时，导出为 Chrome trace-event JSON
+ *
+ * 用法:
+ *   TRACE_SCOPE("preprocess");          // 从这里到作用域结束记为一个事件
+ *   TRACE_THREAD_NAME("pipeline/0");    // 给当前线程起名，显示在 trace 查看器里
+ *   TRACE_DUMP("trace.json");           // 写出所有线程的事件
+ *
+ * 事件写进每个线程自己的环形缓冲区（只保留最近 TRACE_RING_SIZE 个），记录时不加锁。
+ * 名字只保存指针，必须在 dump 之前一直有效（通常用字符串字面量）。
+ * dump 应在被跟踪的线程都停下来之后调用。
+ * 生成的文件可以用 chrome://tracing 或 https://ui.perfetto.dev 打开。
+ *
+ * 只有定义了 TJURM_TRACE（cmake -DTJURM_TRACE=ON）时才会编译进来，否则所有宏都是空的。
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#ifdef TJURM_TRACE
+
+#include <cstdint>
+
+#define TRACE_RING_SIZE (1 << 16)
+
+namespace trace {
+
+uint64_t now_ns();
+void record(const char* name, uint64_t begin_ns, uint64_t end_ns);
+void set_thread_name(const char* name);
+bool dump(const char* path);
+
+class Scope {
+public:
+    explicit Scope(const char* name) : name_(name), begin_ns_(now_ns()) {}
+    ~Scope() { record(name_, begin_ns_, now_ns()); }
+
+private:
+    Scope(const Scope&);
+    Scope& operator=(const Scope&);
+
+    const char* name_;
+    uint64_t begin_ns_;
+};
+
+} // namespace trace
+
+#define __TRACE_CONCAT_IMPL__(a, b) a##b
+#define __TRACE_CONCAT__(a, b)      __TRACE_CONCAT_IMPL__(a, b)
+
+#define TRACE_SCOPE(name)       trace::Scope __TRACE_CONCAT__(__trace_scope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) trace::set_thread_name(name)
+#define TRACE_DUMP(path)        trace::dump(path)
+
+#else
+
+#define TRACE_SCOPE(name)       ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+#define TRACE_DUMP(path)        (false)
+
+#endif // TJURM_TRACE
+
+#endif // __TRACE_H__
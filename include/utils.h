@@ -9,6 +9,11 @@
 
 int get_terminal_width();
 
+// 无界面模式（--headless）：测试点不弹窗口、不等待按键，
+// 需要人工判断的检查点改为和 assets 里的答案图像自动比较
+void set_headless(bool headless);
+bool is_headless();
+
 void print_line(int width, char c);
 
 cv::Mat show_contours(const std::vector<std::vector<cv::Point>>& contours,
@@ -19,4 +24,9 @@ cv::Mat show_rectangle(const cv::RotatedRect& rrect, int rows, int cols);
 
 std::vector<cv::Point> make_random_contour(int rows, int cols);
 
+// 测试用的随机单通道图像：每个像素以 density 的概率保留 [0, 255] 的随机值，其余为 0
+// （density 为 1 时就是灰度噪声）；再交替叠加 shapes 个随机大小的实心矩形和倾斜椭圆，
+// 颜色随机取 0 或 255，有的盖住噪声形成平坦区，有的在前景里挖出孔洞
+cv::Mat make_random_mask(int rows, int cols, double density, int shapes, cv::RNG& rng);
+
 #endif
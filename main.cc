@@ -1,12 +1,22 @@
 #include "tests.h"
 #include "utils.h"
 #include "log.h"
+#include "async_log.h"
+#include "trace.h"
+#include "armor_detect.h"
 
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 
 #include <map>
+#include <string>
+#include <thread>
 #include <vector>
 
 using std::cout;
@@ -14,22 +24,73 @@ using std::endl;
 
 static int terminal_cols;
 
+// 测试点的日志是同步输出的，get_rect_by_contours 和检测库的日志可能走异步后端（ARMOR_ASYNC_LOG），
+// 和 cout 交替输出之前两边都要写完。异步后端没写过记录时 async_log::flush 直接返回
+static void flush_logs() {
+    async_log::flush();
+    LOG_FLUSH();
+}
+
 std::vector<std::string> default_tests = {
-    "split", "threshold", "erode", "find_contours", "rect",
-    "compute_iou", "compute_area_ratio", "roi_color",
-    "resize"
+    "split", "threshold", "histogram", "integral", "erode", "find_contours", "ccl", "leaf_contours", "rect",
+    "compute_iou", "iou_batch", "compute_area_ratio", "roi_color", "region_stats",
+    "resize", "resize_types", "bitmask", "morphology", "armor_detect", "armor_preprocess", "armor_pipeline",
+    "armor_roi", "light_bar_pairing", "armor_association",
+    "armor_motion", "armor_zero_alloc", "armor_scene", "armor_color_mask", "armor_label", "armor_mean_threshold",
+    "async_log"
 };
 
 std::map<std::string, TestFunction> name2test = {
     {"split",              test_split},
     {"threshold",          test_threshold},
+    {"histogram",          test_histogram},
+    {"histogram_bench",    bench_histogram},
+    {"integral",           test_integral},
+    {"integral_bench",     bench_integral},
     {"erode",              test_erode},
     {"find_contours",      test_find_contours},
+    {"ccl",                test_ccl},
+    {"ccl_bench",          bench_ccl},
+    {"leaf_contours",      test_leaf_contours},
+    {"leaf_contours_bench", bench_leaf_contours},
     {"rect",               test_get_rect_by_contours},
     {"compute_iou",        test_compute_iou},
+    {"iou_batch",          test_iou_batch},
+    {"iou_batch_bench",    bench_iou_batch},
     {"compute_area_ratio", test_compute_area_ratio},
     {"roi_color",          test_roi_color},
-    {"resize",             test_my_resize}
+    {"region_stats",       test_region_stats},
+    {"region_stats_bench", bench_region_stats},
+    {"resize",             test_my_resize},
+    {"resize_bench",       bench_my_resize},
+    {"resize_types",       test_resize_types},
+    {"resize_scaling_bench", bench_resize_scaling},
+    {"bitmask",            test_bitmask},
+    {"bitmask_bench",      bench_bitmask},
+    {"morphology",         test_morphology},
+    {"morphology_bench",   bench_morphology},
+    {"armor_detect",       test_armor_detect},
+    {"armor_preprocess",   test_fused_preprocess},
+    {"armor_preprocess_bench", bench_fused_preprocess},
+    {"armor_pipeline",     test_armor_pipeline},
+    {"armor_roi",          test_armor_roi},
+    {"light_bar_pairing",  test_light_bar_pairing},
+    {"light_bar_pairing_bench", bench_light_bar_pairing},
+    {"armor_association",  test_armor_association},
+    {"armor_association_bench", bench_armor_association},
+    {"armor_motion",       test_armor_motion},
+    {"armor_pose_bench",   bench_armor_pose},
+    {"armor_render_bench", bench_armor_render},
+    {"armor_zero_alloc",   test_armor_zero_alloc},
+    {"armor_scene",        test_armor_scene},
+    {"armor_scene_bench",  bench_armor_scene},
+    {"armor_color_mask",   test_color_mask},
+    {"armor_color_mask_bench", bench_color_mask},
+    {"armor_label",        test_label_light_bars},
+    {"armor_mean_threshold", test_mean_preprocess},
+    {"armor_mean_threshold_bench", bench_mean_preprocess},
+    {"async_log",          test_async_log},
+    {"async_log_bench",    bench_async_log}
 };
 
 std::vector<std::string> load_tests() {
@@ -56,50 +117,266 @@ std::vector<std::string> load_tests() {
             tests.push_back(s);
         }
     }
+    return tests;
+}
 
+void print_tests(const std::vector<std::string>& tests) {
     LOG_MSG("将进行以下测试: ");
+    flush_logs();
     print_line(terminal_cols, '*');
     for (int i = 0; i < tests.size(); i++) {
         cout << "<" << i + 1 << "> " << tests[i] << endl;
     }
     print_line(terminal_cols, '*');
+}
 
-    return tests;
+struct TestResult {
+    std::string name;
+    bool pass;
+    double wall_ms;
+    std::string note;       // 崩溃、不存在等说明
+};
+
+static std::vector<TestResult> results;
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsed_ms(Clock::time_point from) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - from).count();
+}
+
+static void print_test_begin(const std::string& name) {
+    LOG_MSG("开始运行测试点: %s", name.c_str());
+    flush_logs();
+    print_line(terminal_cols, '*');
 }
 
-void run_tests(std::vector<std::string>& tests) {
+static void print_test_end(const TestResult& result) {
+    flush_logs();
+    print_line(terminal_cols, '*');
+
+    if (result.pass) {
+        LOG_MSG("通过该测试点 (%.1f ms)", result.wall_ms);
+    } else if (!result.note.empty()) {
+        LOG_WARN("未通过该测试点: %s (%.1f ms)", result.note.c_str(), result.wall_ms);
+    } else {
+        LOG_WARN("未通过该测试点 (%.1f ms)", result.wall_ms);
+    }
+    flush_logs();
+    cout << endl << endl;
+}
+
+// 基准测试要独占机器，并行模式下也放到最后串行运行
+static bool is_bench(const std::string& name) {
+    const std::string suffix = "_bench";
+    return name.size() > suffix.size() &&
+           name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static bool check_exists(const std::string& name) {
+    if (name2test.find(name) != name2test.end()) {
+        return true;
+    }
+    LOG_ERROR("不存在的测试点: %s", name.c_str());
+    flush_logs();
+    cout << endl;
+    results.push_back({name, false, 0, "不存在"});
+    return false;
+}
+
+void run_tests(const std::vector<std::string>& tests) {
     cout << endl;
     
     for (const auto& name : tests) {
-        if (name2test.find(name) == name2test.end()) {
-            LOG_ERROR("不存在的测试点: %s", name.c_str());
-            cout << endl;
+        if (!check_exists(name)) {
             continue;
         }
 
-        LOG_MSG("开始运行测试点: %s", name.c_str());
-        print_line(terminal_cols, '*');
-        bool pass = (name2test[name])();
-        print_line(terminal_cols, '*');
+        print_test_begin(name);
+        TestResult result{name, false, 0, ""};
+        Clock::time_point start = Clock::now();
+        {
+            // name 指向 tests 里的字符串，main 结束前一直有效
+            TRACE_SCOPE(name.c_str());
+            result.pass = (name2test[name])();
+        }
+        result.wall_ms = elapsed_ms(start);
+        print_test_end(result);
+        results.push_back(result);
+    }
+}
 
-        if (pass) {
-            LOG_MSG("通过该测试点");
-        } else {
-            LOG_WARN("未通过该测试点");
+// 每个测试点在 fork 出来的子进程里运行，输出先写到临时文件，结束后按原顺序打印。
+// 子进程之间互不影响，某个测试点崩溃也只算它自己失败。子进程里的 trace 不会导出。
+void run_tests_parallel(const std::vector<std::string>& tests, int jobs) {
+    std::vector<std::string> parallel, serial;
+    for (const auto& name : tests) {
+        if (!check_exists(name)) {
+            continue;
         }
-        cout << endl << endl;
+        (is_bench(name) ? serial : parallel).push_back(name);
     }
+
+    struct Child {
+        size_t index;
+        FILE* output;
+        Clock::time_point start;
+    };
+    std::map<pid_t, Child> running;
+    std::vector<TestResult> done(parallel.size());
+    std::vector<std::string> outputs(parallel.size());
+    std::vector<bool> finished(parallel.size(), false);
+    // OpenCV 的线程池按核数分给同时运行的子进程
+    const int threads_per_job = std::max(1, (int)std::thread::hardware_concurrency() / jobs);
+
+    cout << endl;
+    size_t next = 0, printed = 0;
+    while (printed < parallel.size()) {
+        while ((int)running.size() < jobs && next < parallel.size()) {
+            const std::string& name = parallel[next];
+            done[next] = {name, false, 0, ""};
+            FILE* output = tmpfile();
+            // 缓冲区里没写出的内容会被子进程复制一份，fork 之前先清空
+            flush_logs();
+            fflush(stdout);
+            pid_t pid = output ? fork() : -1;
+            if (pid == 0) {
+                dup2(fileno(output), STDOUT_FILENO);
+                dup2(fileno(output), STDERR_FILENO);
+                cv::setNumThreads(threads_per_job);
+                bool pass = (name2test[name])();
+                flush_logs();
+                cout.flush();
+                fflush(stdout);
+                fflush(stderr);
+                _exit(pass ? 0 : 1);
+            }
+            if (pid < 0) {
+                done[next].note = "无法创建子进程";
+                finished[next] = true;
+                if (output) fclose(output);
+            } else {
+                running[pid] = Child{next, output, Clock::now()};
+            }
+            next++;
+        }
+
+        if (!running.empty()) {
+            int status = 0;
+            pid_t pid = waitpid(-1, &status, 0);
+            auto it = running.find(pid);
+            if (it != running.end()) {
+                const Child& child = it->second;
+                TestResult& result = done[child.index];
+                result.wall_ms = elapsed_ms(child.start);
+                if (WIFEXITED(status)) {
+                    result.pass = WEXITSTATUS(status) == 0;
+                } else if (WIFSIGNALED(status)) {
+                    result.note = "崩溃 (信号 " + std::to_string(WTERMSIG(status)) + ")";
+                }
+
+                rewind(child.output);
+                char buf[4096];
+                size_t n;
+                while ((n = fread(buf, 1, sizeof(buf), child.output)) > 0) {
+                    outputs[child.index].append(buf, n);
+                }
+                fclose(child.output);
+                finished[child.index] = true;
+                running.erase(it);
+            }
+        }
+
+        // 按 run.list 的顺序输出已经结束的测试点
+        while (printed < parallel.size() && finished[printed]) {
+            print_test_begin(parallel[printed]);
+            fwrite(outputs[printed].data(), 1, outputs[printed].size(), stdout);
+            fflush(stdout);
+            print_test_end(done[printed]);
+            results.push_back(done[printed]);
+            printed++;
+        }
+    }
+
+    run_tests(serial);
+}
+
+void print_summary(double total_ms) {
+    int passed = 0;
+    double sum_ms = 0;
+    flush_logs();
+    print_line(terminal_cols, '=');
+    for (const auto& r : results) {
+        cout << (r.pass ? "  通过  " : FORMAT_RED("未通过  ")) << r.name;
+        for (size_t i = r.name.size(); i < 28; i++) cout << ' ';
+        cout << r.wall_ms << " ms";
+        if (!r.note.empty()) cout << "  (" << r.note << ")";
+        cout << endl;
+        passed += r.pass;
+        sum_ms += r.wall_ms;
+    }
+    print_line(terminal_cols, '=');
+    cout << "通过 " << passed << "/" << results.size() << ", 总耗时 " << total_ms
+         << " ms, 各测试点耗时之和 " << sum_ms << " ms" << endl;
+}
+
+static void print_usage() {
+    cout << "用法: tjurm_tutorial [--headless] [--jobs N] [测试点 ...]" << endl
+         << "  --headless    不弹窗口、不等待按键，需要人工判断的检查点和答案图像自动比较" << endl
+         << "  --jobs N      同时运行 N 个测试点（隐含 --headless），0 表示按核数" << endl
+         << "  测试点        不给出时读取 run.list" << endl;
 }
 
 
-int main() {
+int main(int argc, char** argv) {
     terminal_cols = get_terminal_width();
+    TRACE_THREAD_NAME("main");
+
+    bool headless = false;
+    int jobs = 1;
+    std::vector<std::string> tests;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            headless = true;
+        } else if ((arg == "--jobs" || arg == "-j") && i + 1 < argc) {
+            jobs = atoi(argv[++i]);
+            if (jobs <= 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+        } else if (!arg.empty() && arg[0] == '-') {
+            print_usage();
+            return 1;
+        } else {
+            tests.push_back(arg);
+        }
+    }
+    if (jobs > 1 && !headless) {
+        LOG_WARN("并行运行时无法等待按键，自动切换到 --headless");
+        headless = true;
+    }
+    set_headless(headless);
 
     // 读取测试点
-    std::vector<std::string> tests = load_tests();
+    if (tests.empty()) {
+        tests = load_tests();
+    }
+    print_tests(tests);
 
     // 运行测试点
-    run_tests(tests);
+    Clock::time_point start = Clock::now();
+    if (jobs > 1) {
+        run_tests_parallel(tests, jobs);
+    } else {
+        run_tests(tests);
+    }
+    print_summary(elapsed_ms(start));
+    
+#ifdef TJURM_TRACE
+    if (TRACE_DUMP("trace.json")) {
+        LOG_MSG("trace 已写入 trace.json，可以用 chrome://tracing 或 ui.perfetto.dev 打开");
+    }
+#endif
     
-    return 0;
+    int failed = 0;
+    for (const auto& r : results) failed += !r.pass;
+    return failed ? 1 : 0;
 }
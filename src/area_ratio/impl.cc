@@ -1,6 +1,8 @@
 #include "impls.h"
+#include "trace.h"
 
 float compute_area_ratio(const std::vector<cv::Point>& contour) {
+    TRACE_SCOPE("compute_area_ratio");
     /**
      * 要求：
      *      计算输入的轮廓的面积与它的最小外接矩形面积的比例。
@@ -11,9 +11,11 @@ bool test_compute_area_ratio() {
         if (std::abs(r - ans) > 1e-6) {
             std::cout << "计算这个轮廓时出错了, 你的答案: " << r
                       << ", 正确答案: " << ans << std::endl;
-            cv::imshow("contour", show_contours({contour}, 320, 480));
-            cv::waitKey(0);
-            cv::destroyAllWindows();
+            if (!is_headless()) {
+                cv::imshow("contour", show_contours({contour}, 320, 480));
+                cv::waitKey(0);
+                cv::destroyAllWindows();
+            }
             return false;
         } else {
             std::cout << "contour size " << contour.size()
@@ -0,0 +1,426 @@
+#include "async_log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace async_log {
+
+static_assert((kRingBytes & (kRingBytes - 1)) == 0, "kRingBytes must be a power of two");
+static_assert(sizeof(RecordHeader) % 8 == 0 && sizeof(ArgSlot) == 16, "unexpected record layout");
+
+/* 单生产者（所属线程）单消费者（后台线程）的字节环。
+ * head/tail 单调递增，记录不跨越环尾：放不下时在环尾写一条填充记录，
+ * 剩余空间连填充头都放不下时双方都直接跳到下一圈。 */
+struct Ring {
+    std::vector<uint8_t> data;
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    uint64_t pending;                   // 生产者: begin_record 预留的记录结束位置
+    std::atomic<bool> closed;           // 所属线程已退出，读空后可以回收
+
+    Ring() : data(kRingBytes), head(0), tail(0), pending(0), closed(false) {}
+};
+
+struct Formatted {
+    uint64_t timestamp_ns;
+    std::string text;
+};
+
+class Logger {
+public:
+    Logger() : output_(stdout), running_(true), passes_(0), dropped_(0), reported_dropped_(0) {
+        instance_ = this;
+        thread_ = std::thread(&Logger::run, this);
+        pthread_atfork(&Logger::prepareFork, &Logger::parentAfterFork, &Logger::childAfterFork);
+    }
+
+    Ring* registerRing() {
+        std::shared_ptr<Ring> ring = std::make_shared<Ring>();
+        std::lock_guard<std::mutex> lock(mutex_);
+        rings_.push_back(ring);
+        return ring.get();
+    }
+
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!running_) return;
+        // 等两轮：第二轮一定是在调用之后开始的，能看到此前发布的全部记录
+        uint64_t target = passes_ + 2;
+        wake_.notify_one();
+        done_.wait(lock, [&] { return passes_ >= target || !running_; });
+    }
+
+    void setOutput(FILE* file) {
+        flush();
+        std::lock_guard<std::mutex> lock(mutex_);
+        output_ = file;
+    }
+
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) return;
+            running_ = false;
+        }
+        wake_.notify_one();
+        thread_.join();
+        fflush(output_);
+    }
+
+    bool running() const { return running_.load(std::memory_order_acquire); }
+    FILE* output() const { return output_; }
+
+    std::atomic<uint64_t>& droppedCounter() { return dropped_; }
+
+private:
+    // fork 时持有 mutex_，保证子进程里的锁状态是干净的；
+    // 子进程里没有后台线程，之后的日志都走同步输出
+    static void prepareFork() { instance_->mutex_.lock(); }
+    static void parentAfterFork() { instance_->mutex_.unlock(); }
+    static void childAfterFork() {
+        instance_->mutex_.unlock();
+        instance_->running_.store(false, std::memory_order_release);
+    }
+
+    void run() {
+        std::vector<std::shared_ptr<Ring>> rings;
+        std::vector<Formatted> lines;
+        while (true) {
+            bool stop;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait_for(lock, std::chrono::milliseconds(1));
+                stop = !running_;
+                // 回收已退出线程的空环
+                rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::shared_ptr<Ring>& r) {
+                    return r->closed.load(std::memory_order_acquire) &&
+                           r->tail.load(std::memory_order_relaxed) == r->head.load(std::memory_order_acquire);
+                }), rings_.end());
+                rings = rings_;
+            }
+
+            lines.clear();
+            for (const auto& ring : rings) {
+                drain(*ring, lines);
+            }
+            // 各线程的记录按时间戳合并
+            std::stable_sort(lines.begin(), lines.end(), [](const Formatted& a, const Formatted& b) {
+                return a.timestamp_ns < b.timestamp_ns;
+            });
+
+            FILE* out;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                out = output_;
+            }
+            for (const auto& line : lines) {
+                fwrite(line.text.data(), 1, line.text.size(), out);
+            }
+            uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+            if (dropped != reported_dropped_) {
+                fprintf(out, "\033[1;33m[Warning]\033[0m: 日志缓冲区已满，丢弃了 %llu 条记录\n",
+                        (unsigned long long)(dropped - reported_dropped_));
+                reported_dropped_ = dropped;
+            }
+            if (!lines.empty()) fflush(out);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                passes_++;
+            }
+            done_.notify_all();
+            if (stop) break;
+        }
+    }
+
+    void drain(Ring& ring, std::vector<Formatted>& lines);
+
+    FILE* output_;
+    std::atomic<bool> running_;
+    uint64_t passes_;
+    std::atomic<uint64_t> dropped_;
+    uint64_t reported_dropped_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+    std::thread thread_;
+
+public:
+    static Logger* instance_;
+};
+
+Logger* Logger::instance_ = nullptr;
+
+/* 按记录里的参数逐个读取 */
+class ArgReader {
+public:
+    ArgReader(const RecordHeader& header)
+        : p_((const uint8_t*)(&header + 1)), remaining_(header.num_args) {}
+
+    const ArgSlot* next() {
+        if (remaining_ == 0) return nullptr;
+        remaining_--;
+        const ArgSlot* slot = (const ArgSlot*)p_;
+        p_ += sizeof(ArgSlot);
+        if (slot->type == kArgString) p_ += align8((size_t)slot->length);
+        return slot;
+    }
+
+    static const char* text(const ArgSlot* slot) {
+        return (const char*)(slot + 1);
+    }
+
+    static long long asInt(const ArgSlot* slot) {
+        if (!slot) return 0;
+        return slot->type == kArgDouble ? (long long)slot->d : (long long)slot->i;
+    }
+
+private:
+    const uint8_t* p_;
+    uint32_t remaining_;
+};
+
+template <typename T>
+static void appendFormatted(std::string& out, const char* spec, T value) {
+    char buf[256];
+    int len = snprintf(buf, sizeof(buf), spec, value);
+    if (len < 0) return;
+    if (len < (int)sizeof(buf)) {
+        out.append(buf, len);
+    } else {
+        std::vector<char> big(len + 1);
+        snprintf(big.data(), big.size(), spec, value);
+        out.append(big.data(), len);
+    }
+}
+
+/* 把一条记录按 printf 的规则格式化。每个转换说明单独交给 snprintf，
+ * 长度修饰符换成与存储类型匹配的 ll 或者去掉；类型对不上时按存储的类型输出，不会读错内存。 */
+static void formatRecord(const RecordHeader& header, std::string& out) {
+    ArgReader args(header);
+    char spec[48];
+
+    for (const char* f = header.format; *f; f++) {
+        if (*f != '%') {
+            out += *f;
+            continue;
+        }
+        if (f[1] == '%') {
+            out += '%';
+            f++;
+            continue;
+        }
+
+        // %[flags][width][.precision][length]conversion
+        const char* start = f++;
+        int n = 0;
+        spec[n++] = '%';
+        while (*f && strchr("-+ #0", *f) && n < 8) spec[n++] = *f++;
+        if (*f == '*') {
+            f++;
+            n += snprintf(spec + n, 12, "%d", (int)ArgReader::asInt(args.next()));
+        } else {
+            while (*f >= '0' && *f <= '9' && n < 20) spec[n++] = *f++;
+        }
+        if (*f == '.') {
+            spec[n++] = *f++;
+            if (*f == '*') {
+                f++;
+                n += snprintf(spec + n, 12, "%d", (int)ArgReader::asInt(args.next()));
+            } else {
+                while (*f >= '0' && *f <= '9' && n < 36) spec[n++] = *f++;
+            }
+        }
+        while (*f && strchr("hlLqjzt", *f)) f++;
+
+        const char conv = *f;
+        if (!conv) {
+            out.append(start);
+            break;
+        }
+        const ArgSlot* slot = strchr("diuoxXfFeEgGaAcsp", conv) ? args.next() : nullptr;
+        if (!slot) {
+            // 不认识的转换或者参数不够，原样输出
+            out.append(start, f + 1);
+            continue;
+        }
+
+        if (slot->type == kArgString) {
+            // 字符串只能按 %s 输出
+            spec[n++] = 's';
+            spec[n] = '\0';
+            std::string s(ArgReader::text(slot), (size_t)slot->length);
+            appendFormatted(out, spec, s.c_str());
+        } else if (conv == 's' || conv == 'p' || slot->type == kArgPointer) {
+            if (slot->type == kArgPointer) {
+                spec[n++] = 'p';
+                spec[n] = '\0';
+                appendFormatted(out, spec, slot->p);
+            } else if (slot->type == kArgDouble) {
+                strcpy(spec + n, "g");
+                appendFormatted(out, spec, slot->d);
+            } else if (slot->type == kArgUInt) {
+                strcpy(spec + n, "llu");
+                appendFormatted(out, spec, (unsigned long long)slot->u);
+            } else {
+                strcpy(spec + n, "lld");
+                appendFormatted(out, spec, (long long)slot->i);
+            }
+        } else if (strchr("di", conv)) {
+            spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conv; spec[n] = '\0';
+            appendFormatted(out, spec, ArgReader::asInt(slot));
+        } else if (strchr("uoxX", conv)) {
+            spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conv; spec[n] = '\0';
+            unsigned long long v = slot->type == kArgDouble ? (unsigned long long)slot->d
+                                                            : (unsigned long long)slot->u;
+            appendFormatted(out, spec, v);
+        } else if (conv == 'c') {
+            spec[n++] = 'c'; spec[n] = '\0';
+            appendFormatted(out, spec, (int)ArgReader::asInt(slot));
+        } else {
+            spec[n++] = conv; spec[n] = '\0';
+            double v = slot->type == kArgDouble ? slot->d
+                     : slot->type == kArgUInt ? (double)slot->u : (double)slot->i;
+            appendFormatted(out, spec, v);
+        }
+    }
+}
+
+void Logger::drain(Ring& ring, std::vector<Formatted>& lines) {
+    uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    const uint64_t head = ring.head.load(std::memory_order_acquire);
+    while (tail < head) {
+        size_t pos = tail & (kRingBytes - 1);
+        size_t contiguous = kRingBytes - pos;
+        if (contiguous < sizeof(RecordHeader)) {
+            tail += contiguous;
+            continue;
+        }
+        const RecordHeader& header = *(const RecordHeader*)&ring.data[pos];
+        if (header.format) {
+            Formatted line;
+            line.timestamp_ns = header.timestamp_ns;
+            formatRecord(header, line.text);
+            lines.push_back(std::move(line));
+        }
+        tail += header.size;
+    }
+    ring.tail.store(tail, std::memory_order_release);
+}
+
+static void shutdownAtExit();
+
+/* 不析构：退出时由 atexit 写完剩余记录并停掉后台线程，之后的日志走同步路径 */
+/* 后台线程已经启动。只用同步日志的程序调用 flush 时不必为此启动后台线程 */
+static std::atomic<bool> g_started(false);
+
+static Logger& logger() {
+    static Logger* instance = [] {
+        Logger* l = new Logger();
+        std::atexit(shutdownAtExit);
+        g_started.store(true, std::memory_order_release);
+        return l;
+    }();
+    return *instance;
+}
+
+static void shutdownAtExit() {
+    logger().shutdown();
+}
+
+/* 线程退出时标记自己的环，后台线程读空后回收 */
+struct RingHolder {
+    Ring* ring;
+    RingHolder() : ring(nullptr) {}
+    ~RingHolder() {
+        if (ring) ring->closed.store(true, std::memory_order_release);
+        ring = nullptr;
+    }
+};
+
+static thread_local RingHolder t_ring;
+/* 后台线程停止后改为同步输出，记录临时放在堆上 */
+static thread_local uint8_t* t_sync_record = nullptr;
+
+uint64_t now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint8_t* begin_record(size_t size) {
+    Logger& log = logger();
+    if (!log.running()) {
+        t_sync_record = (uint8_t*)malloc(size);
+        return t_sync_record;
+    }
+
+    if (!t_ring.ring) t_ring.ring = log.registerRing();
+    Ring& ring = *t_ring.ring;
+    if (size > kRingBytes / 2) {
+        log.droppedCounter()++;
+        return nullptr;
+    }
+
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    const uint64_t tail = ring.tail.load(std::memory_order_acquire);
+    size_t pos = head & (kRingBytes - 1);
+    size_t contiguous = kRingBytes - pos;
+    size_t needed = contiguous < size ? contiguous + size : size;
+    if (kRingBytes - (head - tail) < needed) {
+        log.droppedCounter()++;
+        return nullptr;
+    }
+
+    if (contiguous < size) {
+        // 环尾放不下，写一条填充记录后从头开始
+        if (contiguous >= sizeof(RecordHeader)) {
+            RecordHeader* pad = (RecordHeader*)&ring.data[pos];
+            pad->format = nullptr;
+            pad->size = (uint32_t)contiguous;
+        }
+        head += contiguous;
+        pos = 0;
+    }
+    ring.pending = head + size;
+    return &ring.data[pos];
+}
+
+void commit_record() {
+    if (t_sync_record) {
+        std::string text;
+        formatRecord(*(const RecordHeader*)t_sync_record, text);
+        fwrite(text.data(), 1, text.size(), logger().output());
+        free(t_sync_record);
+        t_sync_record = nullptr;
+        return;
+    }
+    Ring& ring = *t_ring.ring;
+    ring.head.store(ring.pending, std::memory_order_release);
+}
+
+void flush() {
+    // 还没有写过任何记录（写记录会先启动后台线程），没有要等的
+    if (!g_started.load(std::memory_order_acquire)) return;
+    logger().flush();
+}
+
+void set_output(FILE* file) {
+    logger().setOutput(file);
+}
+
+uint64_t dropped() {
+    return logger().droppedCounter().load();
+}
+
+} // namespace async_log
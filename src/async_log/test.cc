@@ -0,0 +1,160 @@
+#include "async_log.h"
+#include "log.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 读出临时文件的全部内容
+static std::string readAll(FILE* file) {
+    std::string text;
+    fflush(file);
+    rewind(file);
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+        text.append(buf, n);
+    }
+    return text;
+}
+
+template <typename... Args>
+static void logAndExpect(std::string& expected, const char* format, Args... args) {
+    char buf[4096];
+    snprintf(buf, sizeof(buf), format, args...);
+    expected += buf;
+    async_log::write(format, args...);
+}
+
+bool test_async_log() {
+    FILE* file = tmpfile();
+    if (!file) {
+        LOG_ERROR("无法创建临时文件");
+        return false;
+    }
+    LOG_FLUSH();
+    async_log::set_output(file);
+
+    // 格式化结果要和 printf 一致
+    std::string expected;
+    std::string long_text(600, 'x');
+    int local = 0;
+    logAndExpect(expected, "plain text\n");
+    logAndExpect(expected, "%d %i %u %ld %lu\n", -42, 7, 3000000000u, -1234567890123L, 18446744073709551615UL);
+    logAndExpect(expected, "%lld %llu %hd %hhu\n", LLONG_MIN, ULLONG_MAX, (short)-5, (unsigned char)200);
+    logAndExpect(expected, "%5.2f|%-8s|%c|%08.3e|%g\n", 3.14159, "left", 'Z', -0.000123, 1e20);
+    logAndExpect(expected, "%x %X %o %#x %+d % d\n", 255u, 48879u, 8u, 255u, 5, 6);
+    logAndExpect(expected, "[%*d] [%-*d] [%.*f]\n", 6, 42, 4, 7, 2, 2.71828);
+    logAndExpect(expected, "%s|%.3s|%10s\n", long_text.c_str(), "abcdef", "right");
+    logAndExpect(expected, "100%% %s\n", std::string("done").c_str());
+    logAndExpect(expected, "%p\n", (void*)&local);
+    logAndExpect(expected, "%zu %f\n", (size_t)123, 0.5f);
+
+    // 多线程：每个线程内的顺序不变，记录不丢
+    const int threads = 4, lines = 2000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([t] {
+            for (int i = 0; i < lines; i++) {
+                async_log::write("T%d %d\n", t, i);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    async_log::flush();
+    async_log::set_output(stdout);
+    std::string text = readAll(file);
+    fclose(file);
+
+    if (text.compare(0, expected.size(), expected) != 0) {
+        size_t k = 0;
+        while (k < expected.size() && k < text.size() && expected[k] == text[k]) k++;
+        LOG_ERROR("格式化结果与 printf 不一致，第 %zu 个字节开始不同", k);
+        return false;
+    }
+
+    std::vector<int> next(threads, 0);
+    size_t pos = expected.size();
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos) break;
+        int t = -1, i = -1;
+        if (sscanf(text.c_str() + pos, "T%d %d", &t, &i) != 2 || t < 0 || t >= threads || i != next[t]) {
+            LOG_ERROR("多线程输出乱序: %s", text.substr(pos, end - pos).c_str());
+            return false;
+        }
+        next[t]++;
+        pos = end + 1;
+    }
+    for (int t = 0; t < threads; t++) {
+        if (next[t] != lines) {
+            LOG_ERROR("线程 %d 只输出了 %d 行", t, next[t]);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool bench_async_log() {
+    FILE* null_file = fopen("/dev/null", "w");
+    if (!null_file) {
+        LOG_ERROR("无法打开 /dev/null");
+        return false;
+    }
+    LOG_FLUSH();
+
+    typedef std::chrono::steady_clock Clock;
+    const int batches = 200, batch_size = 1000;
+    const char* format = "\033[1;34m[Message]\033[0m: frame %d armor %d at (%.1f, %.1f) %s\n";
+
+    // 调用处的开销：每批之间 flush 一次（不计时），保证环里有空间，测的是不丢弃时的路径
+    async_log::set_output(null_file);
+    std::vector<double> async_ns;
+    for (int b = 0; b < batches; b++) {
+        Clock::time_point t0 = Clock::now();
+        for (int i = 0; i < batch_size; i++) {
+            async_log::write(format, b, i, 320.5, 240.25, "blue");
+        }
+        Clock::time_point t1 = Clock::now();
+        async_ns.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() / batch_size);
+        async_log::flush();
+    }
+
+    std::vector<double> sync_ns;
+    for (int b = 0; b < batches; b++) {
+        Clock::time_point t0 = Clock::now();
+        for (int i = 0; i < batch_size; i++) {
+            fprintf(null_file, format, b, i, 320.5, 240.25, "blue");
+        }
+        fflush(null_file);
+        Clock::time_point t1 = Clock::now();
+        sync_ns.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() / batch_size);
+    }
+
+    // 突发：不给后台线程喘息，记录要么写出要么计入丢弃，调用处从不阻塞
+    const int burst = 200000;
+    uint64_t dropped_before = async_log::dropped();
+    Clock::time_point t0 = Clock::now();
+    for (int i = 0; i < burst; i++) {
+        async_log::write(format, 0, i, 1.0, 2.0, "red");
+    }
+    double burst_ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / burst;
+    async_log::flush();
+    uint64_t burst_dropped = async_log::dropped() - dropped_before;
+    async_log::set_output(stdout);
+    fclose(null_file);
+
+    std::sort(async_ns.begin(), async_ns.end());
+    std::sort(sync_ns.begin(), sync_ns.end());
+    std::cout << "异步日志 " << async_ns[batches / 2] << " ns/次 (p99 " << async_ns[batches * 99 / 100]
+              << "), fprintf " << sync_ns[batches / 2] << " ns/次 (p99 " << sync_ns[batches * 99 / 100]
+              << ")" << std::endl;
+    std::cout << "突发 " << burst << " 条: " << burst_ns << " ns/次, 丢弃 " << burst_dropped << " 条" << std::endl;
+
+    return async_ns[batches / 2] < sync_ns[batches / 2];
+}
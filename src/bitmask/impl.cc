@@ -0,0 +1,268 @@
+#include "bitmask.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace bitmask {
+
+void BitMask::create(int rows, int cols) {
+    CV_Assert(rows >= 0 && cols >= 0);
+    rows_ = rows;
+    cols_ = cols;
+    stride_ = (cols + 63) / 64;
+    // vector 的 assign 在容量够时不重新分配
+    data_.assign((size_t)rows * stride_, 0);
+}
+
+void BitMask::setTo(bool value) {
+    std::fill(data_.begin(), data_.end(), value ? ~(uint64_t)0 : 0);
+    if (value && stride_ > 0) {
+        const uint64_t tail = tailMask();
+        for (int y = 0; y < rows_; y++) {
+            row(y)[stride_ - 1] &= tail;
+        }
+    }
+}
+
+int BitMask::count() const {
+    int n = 0;
+    for (uint64_t w : data_) {
+        n += __builtin_popcountll(w);
+    }
+    return n;
+}
+
+// 打包用的谓词：标量版本判断一个像素，SSE2 版本返回 16 个像素的位
+struct NonZero {
+    bool operator()(uchar v) const { return v != 0; }
+#ifdef __SSE2__
+    int bits(__m128i v) const {
+        return ~_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) & 0xFFFF;
+    }
+#endif
+};
+
+// v > thresh；inverse 时 v <= thresh。SSE2 没有无符号比较，用饱和减法是否为 0 来判断
+struct Threshold {
+    uchar thresh;
+    bool inverse;
+    bool operator()(uchar v) const { return (v > thresh) != inverse; }
+#ifdef __SSE2__
+    int bits(__m128i v) const {
+        int le = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(v, _mm_set1_epi8((char)thresh)),
+                                                  _mm_setzero_si128()));
+        return inverse ? le : ~le & 0xFFFF;
+    }
+#endif
+};
+
+template <class Pred>
+static void packRow(const uchar* src, uint64_t* dst, int cols, const Pred& pred) {
+    int x = 0;
+#ifdef __SSE2__
+    for (; x + 64 <= cols; x += 64) {
+        const __m128i* p = (const __m128i*)(src + x);
+        dst[x >> 6] = (uint64_t)pred.bits(_mm_loadu_si128(p)) |
+                      (uint64_t)pred.bits(_mm_loadu_si128(p + 1)) << 16 |
+                      (uint64_t)pred.bits(_mm_loadu_si128(p + 2)) << 32 |
+                      (uint64_t)pred.bits(_mm_loadu_si128(p + 3)) << 48;
+    }
+#endif
+    for (; x < cols; x += 64) {
+        const int n = std::min(64, cols - x);
+        uint64_t w = 0;
+        for (int i = 0; i < n; i++) {
+            w |= (uint64_t)pred(src[x + i]) << i;
+        }
+        dst[x >> 6] = w;
+    }
+}
+
+template <class Pred>
+static void pack(const cv::Mat& src, BitMask& dst, const Pred& pred) {
+    CV_Assert(src.type() == CV_8UC1);
+    dst.create(src.rows, src.cols);
+    for (int y = 0; y < src.rows; y++) {
+        packRow(src.ptr<uchar>(y), dst.row(y), src.cols, pred);
+    }
+}
+
+void fromMat(const cv::Mat& src, BitMask& dst) {
+    pack(src, dst, NonZero());
+}
+
+void threshold(const cv::Mat& gray, int thresh, BitMask& dst, bool inverse) {
+    // 阈值超出 [0, 255] 时结果全 0 或全 1，和 cv::threshold 一致
+    if (thresh < 0 || thresh >= 255) {
+        dst.create(gray.rows, gray.cols);
+        dst.setTo((thresh < 0) != inverse);
+        return;
+    }
+    pack(gray, dst, Threshold{(uchar)thresh, inverse});
+}
+
+// 8 个位展开成 8 个 0 / 255 字节
+static const uint64_t* expandTable() {
+    static uint64_t table[256];
+    static const bool ready = [] {
+        for (int b = 0; b < 256; b++) {
+            uchar bytes[8];
+            for (int i = 0; i < 8; i++) {
+                bytes[i] = (b >> i) & 1 ? 255 : 0;
+            }
+            memcpy(&table[b], bytes, 8);
+        }
+        return true;
+    }();
+    (void)ready;
+    return table;
+}
+
+void toMat(const BitMask& src, cv::Mat& dst) {
+    dst.create(src.rows(), src.cols(), CV_8UC1);
+    const uint64_t* table = expandTable();
+    const int bytes = src.cols() / 8;
+    for (int y = 0; y < src.rows(); y++) {
+        const uint64_t* s = src.row(y);
+        uchar* d = dst.ptr<uchar>(y);
+        for (int b = 0; b < bytes; b++) {
+            memcpy(d + 8 * b, &table[(s[b >> 3] >> ((b & 7) * 8)) & 0xFF], 8);
+        }
+        for (int x = 8 * bytes; x < src.cols(); x++) {
+            d[x] = src.get(y, x) ? 255 : 0;
+        }
+    }
+}
+
+// 腐蚀取与、界外视为 1；膨胀取或、界外视为 0。和 OpenCV 默认的边界值效果相同：界外不影响结果
+template <bool Erode>
+struct MorphOp {
+    static uint64_t fill() { return Erode ? ~(uint64_t)0 : 0; }
+    static uint64_t apply(uint64_t a, uint64_t b) { return Erode ? a & b : a | b; }
+};
+
+// buf[i] 和它往后平移 s 位的结果合并：处理完 buf 的第 x 位是原来第 x 位和第 x + s 位的合并。
+// 从前往后原地更新，读到的总是还没更新的字
+template <bool Erode>
+static void combineShifted(uint64_t* buf, int len, int s) {
+    typedef MorphOp<Erode> Op;
+    const int q = s >> 6, r = s & 63;
+    const int safe = std::max(0, len - q - 1);
+    int i = 0;
+    if (r == 0) {
+        for (; i < safe; i++) buf[i] = Op::apply(buf[i], buf[i + q]);
+    } else {
+        for (; i < safe; i++) buf[i] = Op::apply(buf[i], (buf[i + q] >> r) | (buf[i + q + 1] << (64 - r)));
+    }
+    for (; i < len; i++) {
+        uint64_t a = i + q < len ? buf[i + q] : Op::fill();
+        uint64_t b = i + q + 1 < len ? buf[i + q + 1] : Op::fill();
+        buf[i] = Op::apply(buf[i], r ? (a >> r) | (b << (64 - r)) : a);
+    }
+}
+
+// 一行的水平方向腐蚀 / 膨胀，原地更新。
+// 行放进两侧各 pad 个字填充了界外值的缓冲区，倍增地合并平移后的自己：
+// 合并后第 x 位是原来 [x, x + k) 的合并，只需要 log2(k) 轮，最后按锚点整体平移回去
+template <bool Erode>
+static void morphRow(uint64_t* row, int nw, uint64_t tail, int k, int anchor, std::vector<uint64_t>& buf) {
+    typedef MorphOp<Erode> Op;
+    const int pad = (k + 63) / 64 + 1;
+    const int len = nw + 2 * pad;
+    buf.resize(len);
+    std::fill(buf.begin(), buf.begin() + pad, Op::fill());
+    std::copy(row, row + nw, buf.begin() + pad);
+    buf[pad + nw - 1] = (row[nw - 1] & tail) | (Op::fill() & ~tail);
+    std::fill(buf.begin() + pad + nw, buf.end(), Op::fill());
+
+    for (int w = 1; w < k;) {
+        int s = std::min(w, k - w);
+        combineShifted<Erode>(buf.data(), len, s);
+        w += s;
+    }
+
+    const int r = (64 - anchor % 64) % 64;
+    for (int j = 0; j < nw; j++) {
+        int q = pad + j - (anchor + 63) / 64;
+        row[j] = r ? (buf[q] >> r) | (buf[q + 1] << (64 - r)) : buf[q];
+    }
+    row[nw - 1] &= tail;
+}
+
+// 先竖直方向（逐字合并 ksize.height 行），再逐行做水平方向
+template <bool Erode>
+static void morph(const BitMask& src, BitMask& dst, cv::Size ksize) {
+    typedef MorphOp<Erode> Op;
+    CV_Assert(ksize.width > 0 && ksize.height > 0);
+    if (&src == &dst) {
+        BitMask copy = src;
+        morph<Erode>(copy, dst, ksize);
+        return;
+    }
+
+    const int rows = src.rows(), nw = src.wordsPerRow();
+    const int ky = ksize.height, ay = ky / 2;
+    dst.create(rows, src.cols());
+    if (nw == 0) return;
+
+    for (int y = 0; y < rows; y++) {
+        const int y0 = std::max(0, y - ay), y1 = std::min(rows, y - ay + ky);
+        uint64_t* d = dst.row(y);
+        std::copy(src.row(y0), src.row(y0) + nw, d);
+        for (int yy = y0 + 1; yy < y1; yy++) {
+            const uint64_t* s = src.row(yy);
+            for (int i = 0; i < nw; i++) {
+                d[i] = Op::apply(d[i], s[i]);
+            }
+        }
+    }
+
+    if (ksize.width > 1) {
+        std::vector<uint64_t> buf;
+        const uint64_t tail = src.tailMask();
+        for (int y = 0; y < rows; y++) {
+            morphRow<Erode>(dst.row(y), nw, tail, ksize.width, ksize.width / 2, buf);
+        }
+    }
+}
+
+void erode(const BitMask& src, BitMask& dst, cv::Size ksize) {
+    morph<true>(src, dst, ksize);
+}
+
+void dilate(const BitMask& src, BitMask& dst, cv::Size ksize) {
+    morph<false>(src, dst, ksize);
+}
+
+void extractRuns(const BitMask& mask, std::vector<Run>& runs) {
+    runs.clear();
+    for (int y = 0; y < mask.rows(); y++) {
+        const uint64_t* r = mask.row(y);
+        int begin = -1;
+        uint64_t carry = 0;
+        for (int j = 0; j < mask.wordsPerRow(); j++) {
+            // 和左边一个像素不同的位置就是行程的起点或终点，依次交替
+            uint64_t w = r[j];
+            uint64_t edges = w ^ ((w << 1) | carry);
+            carry = w >> 63;
+            while (edges) {
+                int x = j * 64 + __builtin_ctzll(edges);
+                if (begin < 0) {
+                    begin = x;
+                } else {
+                    runs.push_back({y, begin, x});
+                    begin = -1;
+                }
+                edges &= edges - 1;
+            }
+        }
+        if (begin >= 0) {
+            runs.push_back({y, begin, mask.cols()});
+        }
+    }
+}
+
+} // namespace bitmask
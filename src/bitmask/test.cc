@@ -0,0 +1,150 @@
+#include "bitmask.h"
+#include "golden.h"
+#include "log.h"
+#include "utils.h"
+#include <iostream>
+#include <vector>
+
+
+static void runs_reference(const cv::Mat& m, std::vector<bitmask::Run>& runs) {
+    runs.clear();
+    for (int y = 0; y < m.rows; y++) {
+        const uchar* p = m.ptr<uchar>(y);
+        int begin = -1;
+        for (int x = 0; x <= m.cols; x++) {
+            bool on = x < m.cols && p[x];
+            if (on && begin < 0) begin = x;
+            if (!on && begin >= 0) {
+                runs.push_back({y, begin, x});
+                begin = -1;
+            }
+        }
+    }
+}
+
+bool test_bitmask() {
+    cv::RNG rng(20241126);
+    // 宽度覆盖不满一个字、正好整字和跨字的情况
+    const int widths[] = {1, 7, 63, 64, 65, 130, 640, 1281};
+    const cv::Size ksizes[] = {cv::Size(1, 1), cv::Size(3, 3), cv::Size(5, 5), cv::Size(2, 4), cv::Size(7, 1),
+                               cv::Size(1, 9), cv::Size(31, 31), cv::Size(65, 3), cv::Size(130, 2)};
+
+    for (int cols : widths) {
+        int rows = rng.uniform(1, 80);
+        cv::Mat src = make_random_mask(rows, cols, 0.1, 6, rng);
+        bitmask::BitMask mask, out;
+        cv::Mat back, expected;
+
+        bitmask::fromMat(src, mask);
+        bitmask::toMat(mask, back);
+        cv::threshold(src, expected, 0, 255, cv::THRESH_BINARY);
+        if (golden::compare(back, expected).over_count != 0 || mask.count() != cv::countNonZero(src)) {
+            LOG_ERROR("%dx%d: 位图和 Mat 互相转换后不一致", cols, rows);
+            return false;
+        }
+
+        // 子区域不连续，按行打包
+        cv::Mat gray(rows, cols + 5, CV_8UC1);
+        rng.fill(gray, cv::RNG::UNIFORM, 0, 256);
+        gray = gray.colRange(3, 3 + cols);
+        for (int thresh : {-1, 0, 50, 127, 254, 255}) {
+            for (int type : {cv::THRESH_BINARY, cv::THRESH_BINARY_INV}) {
+                cv::threshold(gray, expected, thresh, 255, type);
+                bitmask::threshold(gray, thresh, out, type == cv::THRESH_BINARY_INV);
+                bitmask::toMat(out, back);
+                if (golden::compare(back, expected).over_count != 0) {
+                    LOG_ERROR("%dx%d: 阈值 %d 与 cv::threshold 不一致", cols, rows, thresh);
+                    return false;
+                }
+            }
+        }
+
+        for (const auto& ksize : ksizes) {
+            cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, ksize);
+            for (bool erode : {true, false}) {
+                if (erode) {
+                    cv::erode(src, expected, kernel);
+                    bitmask::erode(mask, out, ksize);
+                } else {
+                    cv::dilate(src, expected, kernel);
+                    bitmask::dilate(mask, out, ksize);
+                }
+                cv::threshold(expected, expected, 0, 255, cv::THRESH_BINARY);
+                bitmask::toMat(out, back);
+                int wrong = golden::compare(back, expected).over_count;
+                if (wrong != 0) {
+                    LOG_ERROR("%dx%d: %dx%d %s 与 OpenCV 不一致，不一致像素 %d", cols, rows,
+                              ksize.width, ksize.height, erode ? "腐蚀" : "膨胀", wrong);
+                    return false;
+                }
+            }
+        }
+
+        std::vector<bitmask::Run> runs, expected_runs;
+        bitmask::extractRuns(mask, runs);
+        runs_reference(src, expected_runs);
+        bool same = runs.size() == expected_runs.size();
+        for (size_t i = 0; same && i < runs.size(); i++) {
+            same = runs[i].y == expected_runs[i].y && runs[i].begin == expected_runs[i].begin &&
+                   runs[i].end == expected_runs[i].end;
+        }
+        if (!same) {
+            LOG_ERROR("%dx%d: 行程不一致，得到 %d 个，应为 %d 个", cols, rows,
+                      (int)runs.size(), (int)expected_runs.size());
+            return false;
+        }
+        std::cout << cols << "x" << rows << ": 转换、阈值、形态学、行程一致" << std::endl;
+    }
+    return true;
+}
+
+bool bench_bitmask() {
+    cv::RNG rng(12345);
+    const cv::Size sizes[] = {cv::Size(640, 480), cv::Size(1280, 1024), cv::Size(1920, 1080), cv::Size(3840, 2160)};
+    const cv::Size ksize(5, 5);
+    const cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, ksize);
+
+    for (const auto& size : sizes) {
+        // 平滑过的噪声，阈值后是大小不一的团块，行程数接近真实场景
+        cv::Mat gray(size, CV_8UC1);
+        rng.fill(gray, cv::RNG::UNIFORM, 0, 256);
+        cv::GaussianBlur(gray, gray, cv::Size(0, 0), 4);
+        cv::normalize(gray, gray, 0, 255, cv::NORM_MINMAX);
+        const int iterations = size.area() > 4000000 ? 20 : 100;
+
+        // 8 位链路：阈值 -> 开运算 -> 统计前景；位图链路：阈值直接出位图 -> 开运算 -> 行程
+        cv::Mat binary, opened;
+        bitmask::BitMask mask, tmp;
+        std::vector<bitmask::Run> runs;
+        int64 t0 = cv::getTickCount();
+        for (int i = 0; i < iterations; i++) {
+            cv::threshold(gray, binary, 128, 255, cv::THRESH_BINARY);
+            cv::erode(binary, opened, kernel);
+            cv::dilate(opened, binary, kernel);
+        }
+        int64 t1 = cv::getTickCount();
+        for (int i = 0; i < iterations; i++) {
+            bitmask::threshold(gray, 128, mask);
+            bitmask::erode(mask, tmp, ksize);
+            bitmask::dilate(tmp, mask, ksize);
+        }
+        int64 t2 = cv::getTickCount();
+        for (int i = 0; i < iterations; i++) {
+            bitmask::extractRuns(mask, runs);
+        }
+        int64 t3 = cv::getTickCount();
+
+        cv::Mat check;
+        bitmask::toMat(mask, check);
+        double mat_ms = (t1 - t0) * 1000.0 / cv::getTickFrequency() / iterations;
+        double bit_ms = (t2 - t1) * 1000.0 / cv::getTickFrequency() / iterations;
+        double runs_ms = (t3 - t2) * 1000.0 / cv::getTickFrequency() / iterations;
+        std::cout << size.width << "x" << size.height
+                  << ": 8 位阈值 + 5x5 开运算 " << mat_ms << " ms"
+                  << ", 位图 " << bit_ms << " ms, 加速 " << mat_ms / bit_ms << "x"
+                  << ", 行程提取 " << runs_ms << " ms (" << runs.size() << " 段)"
+                  << ", 二值图 " << size.area() / 1024 << " KB -> " << size.height * mask.wordsPerRow() * 8 / 1024
+                  << " KB, 不一致像素 " << golden::compare(check, binary).over_count << std::endl;
+    }
+    return true;
+}
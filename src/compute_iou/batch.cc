@@ -0,0 +1,177 @@
+#include "iou_batch.h"
+#include "cpu_features.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace iou_batch {
+
+void RectSoA::assign(const std::vector<cv::Rect>& rects) {
+    clear();
+    for (const auto& r : rects) {
+        push_back(r);
+    }
+}
+
+void RectSoA::clear() {
+    x1.clear();
+    y1.clear();
+    x2.clear();
+    y2.clear();
+    area.clear();
+}
+
+void RectSoA::push_back(const cv::Rect& rect) {
+    x1.push_back((float)rect.x);
+    y1.push_back((float)rect.y);
+    x2.push_back((float)(rect.x + rect.width));
+    y2.push_back((float)(rect.y + rect.height));
+    area.push_back((float)rect.width * (float)rect.height);
+}
+
+// 所有版本都按这个顺序做 float 运算，标量和向量的结果逐位一致
+static inline float iouScalar(float ax1, float ay1, float ax2, float ay2, float aarea,
+                              float bx1, float by1, float bx2, float by2, float barea) {
+    float w = std::max(std::min(ax2, bx2) - std::max(ax1, bx1), 0.f);
+    float h = std::max(std::min(ay2, by2) - std::max(ay1, by1), 0.f);
+    float inter = w * h;
+    return inter > 0.f ? inter / (aarea + barea - inter) : 0.f;
+}
+
+float iou(const cv::Rect& a, const cv::Rect& b) {
+    return iouScalar((float)a.x, (float)a.y, (float)(a.x + a.width), (float)(a.y + a.height),
+                     (float)a.width * (float)a.height,
+                     (float)b.x, (float)b.y, (float)(b.x + b.width), (float)(b.y + b.height),
+                     (float)b.width * (float)b.height);
+}
+
+#ifdef __SSE2__
+// 返回处理到的位置，剩下的交给标量循环。没有交集时 inter 为 0，
+// 分母可能也是 0，除出来的 NaN 被掩码清掉
+static int iouRowSSE2(const RectSoA& a, int i, const RectSoA& b, int j, int end, float* out) {
+    const __m128 ax1 = _mm_set1_ps(a.x1[i]), ay1 = _mm_set1_ps(a.y1[i]);
+    const __m128 ax2 = _mm_set1_ps(a.x2[i]), ay2 = _mm_set1_ps(a.y2[i]);
+    const __m128 aarea = _mm_set1_ps(a.area[i]);
+    const __m128 zero = _mm_setzero_ps();
+    for (; j + 4 <= end; j += 4, out += 4) {
+        __m128 w = _mm_max_ps(_mm_sub_ps(_mm_min_ps(ax2, _mm_loadu_ps(&b.x2[j])),
+                                         _mm_max_ps(ax1, _mm_loadu_ps(&b.x1[j]))), zero);
+        __m128 h = _mm_max_ps(_mm_sub_ps(_mm_min_ps(ay2, _mm_loadu_ps(&b.y2[j])),
+                                         _mm_max_ps(ay1, _mm_loadu_ps(&b.y1[j]))), zero);
+        __m128 inter = _mm_mul_ps(w, h);
+        __m128 uni = _mm_sub_ps(_mm_add_ps(aarea, _mm_loadu_ps(&b.area[j])), inter);
+        __m128 value = _mm_and_ps(_mm_cmpgt_ps(inter, zero), _mm_div_ps(inter, uni));
+        _mm_storeu_ps(out, value);
+    }
+    return j;
+}
+#endif
+
+#ifdef CPU_AVX2_DISPATCH
+__attribute__((target("avx2")))
+static int iouRowAVX2(const RectSoA& a, int i, const RectSoA& b, int j, int end, float* out) {
+    const __m256 ax1 = _mm256_set1_ps(a.x1[i]), ay1 = _mm256_set1_ps(a.y1[i]);
+    const __m256 ax2 = _mm256_set1_ps(a.x2[i]), ay2 = _mm256_set1_ps(a.y2[i]);
+    const __m256 aarea = _mm256_set1_ps(a.area[i]);
+    const __m256 zero = _mm256_setzero_ps();
+    for (; j + 8 <= end; j += 8, out += 8) {
+        __m256 w = _mm256_max_ps(_mm256_sub_ps(_mm256_min_ps(ax2, _mm256_loadu_ps(&b.x2[j])),
+                                               _mm256_max_ps(ax1, _mm256_loadu_ps(&b.x1[j]))), zero);
+        __m256 h = _mm256_max_ps(_mm256_sub_ps(_mm256_min_ps(ay2, _mm256_loadu_ps(&b.y2[j])),
+                                               _mm256_max_ps(ay1, _mm256_loadu_ps(&b.y1[j]))), zero);
+        __m256 inter = _mm256_mul_ps(w, h);
+        __m256 uni = _mm256_sub_ps(_mm256_add_ps(aarea, _mm256_loadu_ps(&b.area[j])), inter);
+        __m256 value = _mm256_and_ps(_mm256_cmp_ps(inter, zero, _CMP_GT_OQ), _mm256_div_ps(inter, uni));
+        _mm256_storeu_ps(out, value);
+    }
+    return j;
+}
+#endif
+
+void iou_row(const RectSoA& a, int i, const RectSoA& b, int begin, int end, float* out) {
+    int j = begin;
+#ifdef CPU_AVX2_DISPATCH
+    if (cpuHasAVX2()) {
+        j = iouRowAVX2(a, i, b, j, end, out);
+    }
+#endif
+#ifdef __SSE2__
+    j = iouRowSSE2(a, i, b, j, end, out + (j - begin));
+#endif
+    for (; j < end; j++) {
+        out[j - begin] = iouScalar(a.x1[i], a.y1[i], a.x2[i], a.y2[i], a.area[i],
+                                   b.x1[j], b.y1[j], b.x2[j], b.y2[j], b.area[j]);
+    }
+}
+
+void iou_matrix(const RectSoA& a, const RectSoA& b, float* out) {
+    const int n = a.size(), m = b.size();
+    for (int i = 0; i < n; i++) {
+        iou_row(a, i, b, 0, m, out + (size_t)i * m);
+    }
+}
+
+void iou_matrix(const RectSoA& a, const RectSoA& b, cv::Mat& out) {
+    out.create(a.size(), b.size(), CV_32F);
+    for (int i = 0; i < a.size(); i++) {
+        iou_row(a, i, b, 0, b.size(), out.ptr<float>(i));
+    }
+}
+
+// 和 double 阈值等价的 float 阈值：不超过 threshold 的最大 float。
+// 这样 iou > 返回值 当且仅当 (double)iou > threshold
+static float floatThreshold(double threshold) {
+    float t = (float)threshold;
+    if ((double)t > threshold) {
+        t = std::nextafter(t, -INFINITY);
+    }
+    return t;
+}
+
+void iou_row_pairs(const RectSoA& a, int i, const RectSoA& b, int begin, int end,
+                   double threshold, std::vector<IouPair>& out) {
+    // 分块算稠密的一行放在栈上，再挑出超过阈值的；大部分块一个都没有，整块跳过
+    const int kChunk = 256;
+    float buf[kChunk];
+    const float t = floatThreshold(threshold);
+    for (int j0 = begin; j0 < end; j0 += kChunk) {
+        const int n = std::min(kChunk, end - j0);
+        iou_row(a, i, b, j0, j0 + n, buf);
+        int k = 0;
+#ifdef __SSE2__
+        // 一次检查 16 个，全部不超过阈值时直接跳过
+        const __m128 vt = _mm_set1_ps(t);
+        for (; k + 16 <= n; k += 16) {
+            __m128 m0 = _mm_cmpgt_ps(_mm_loadu_ps(buf + k), vt);
+            __m128 m1 = _mm_cmpgt_ps(_mm_loadu_ps(buf + k + 4), vt);
+            __m128 m2 = _mm_cmpgt_ps(_mm_loadu_ps(buf + k + 8), vt);
+            __m128 m3 = _mm_cmpgt_ps(_mm_loadu_ps(buf + k + 12), vt);
+            if (!_mm_movemask_ps(_mm_or_ps(_mm_or_ps(m0, m1), _mm_or_ps(m2, m3)))) continue;
+            int mask = _mm_movemask_ps(m0) | _mm_movemask_ps(m1) << 4 |
+                       _mm_movemask_ps(m2) << 8 | _mm_movemask_ps(m3) << 12;
+            while (mask) {
+                int bit = __builtin_ctz(mask);
+                out.push_back({i, j0 + k + bit, buf[k + bit]});
+                mask &= mask - 1;
+            }
+        }
+#endif
+        for (; k < n; k++) {
+            if (buf[k] > t) {
+                out.push_back({i, j0 + k, buf[k]});
+            }
+        }
+    }
+}
+
+void iou_pairs(const RectSoA& a, const RectSoA& b, double threshold, std::vector<IouPair>& out) {
+    out.clear();
+    for (int i = 0; i < a.size(); i++) {
+        iou_row_pairs(a, i, b, 0, b.size(), threshold, out);
+    }
+}
+
+} // namespace iou_batch
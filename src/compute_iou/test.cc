@@ -1,4 +1,12 @@
 #include "impls.h"
+#include "iou_batch.h"
+#include "log.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
 
 
 bool test_compute_iou() {
@@ -32,4 +40,123 @@ bool test_compute_iou() {
         }
     }
     return true;
-}
\ No newline at end of file
+}
+
+// 随机矩形，包括空矩形、负坐标和只有边相接的情况
+static std::vector<cv::Rect> random_rects(int n, cv::RNG& rng) {
+    std::vector<cv::Rect> rects;
+    for (int i = 0; i < n; i++) {
+        rects.emplace_back(rng.uniform(-20, 60), rng.uniform(-20, 60), rng.uniform(0, 40), rng.uniform(0, 40));
+    }
+    return rects;
+}
+
+static bool same_bits(float a, float b) {
+    return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+bool test_iou_batch() {
+    cv::RNG rng(17);
+    iou_batch::RectSoA sa, sb;
+    std::vector<float> matrix;
+    std::vector<iou_batch::IouPair> pairs;
+
+    for (int round = 0; round < 200; round++) {
+        // 尺寸取奇数，覆盖 SIMD 之后的标量尾巴
+        std::vector<cv::Rect> as = random_rects(rng.uniform(0, 40), rng);
+        std::vector<cv::Rect> bs = random_rects(rng.uniform(0, 40), rng);
+        sa.assign(as);
+        sb.assign(bs);
+        matrix.assign(as.size() * bs.size(), -1.f);
+        iou_batch::iou_matrix(sa, sb, matrix.data());
+        cv::Mat mat;
+        iou_batch::iou_matrix(sa, sb, mat);
+
+        for (size_t i = 0; i < as.size(); i++) {
+            for (size_t j = 0; j < bs.size(); j++) {
+                float expected = compute_iou(as[i], bs[j]);
+                float got = matrix[i * bs.size() + j];
+                if (!same_bits(expected, got) || !same_bits(expected, mat.at<float>((int)i, (int)j))) {
+                    LOG_ERROR("第 %d 组 (%zu, %zu): 批量 %g, 单对 %g", round, i, j, got, expected);
+                    return false;
+                }
+            }
+        }
+
+        // 阈值取成恰好等于某个 IoU 的 double，检查“严格大于”在 float / double 之间一致
+        double threshold = round % 3 == 0 ? 0.3 : 0.0;
+        if (round % 3 == 2 && !as.empty() && !bs.empty()) {
+            threshold = compute_iou(as[0], bs[0]);
+        }
+        iou_batch::iou_pairs(sa, sb, threshold, pairs);
+        size_t k = 0;
+        for (size_t i = 0; i < as.size(); i++) {
+            for (size_t j = 0; j < bs.size(); j++) {
+                float v = compute_iou(as[i], bs[j]);
+                if ((double)v <= threshold) continue;
+                if (k >= pairs.size() || pairs[k].a != (int)i || pairs[k].b != (int)j || !same_bits(pairs[k].iou, v)) {
+                    LOG_ERROR("第 %d 组: 阈值 %.17g 的稀疏输出和稠密矩阵不一致", round, threshold);
+                    return false;
+                }
+                k++;
+            }
+        }
+        if (k != pairs.size()) {
+            LOG_ERROR("第 %d 组: 稀疏输出多了 %zu 对", round, pairs.size() - k);
+            return false;
+        }
+    }
+    return true;
+}
+
+// 4 到 4096 个框两两算 IoU：逐对调用 compute_iou、批量稠密矩阵、批量稀疏（阈值 0.3）
+bool bench_iou_batch() {
+    typedef std::chrono::steady_clock Clock;
+    cv::RNG rng(23);
+    std::cout << "    N x N     逐对(us)    稠密(us)   ns/对  加速比    稀疏(us)  输出对数" << std::endl;
+
+    for (int n = 4; n <= 4096; n *= 4) {
+        // 跟踪场景的分布：4K 画面里散布的装甲板，另一组在附近抖动
+        std::vector<cv::Rect> as, bs;
+        for (int i = 0; i < n; i++) {
+            cv::Rect r(rng.uniform(0, 3840), rng.uniform(0, 2160), rng.uniform(30, 80), rng.uniform(30, 80));
+            as.push_back(r);
+            bs.push_back(r + cv::Point(rng.uniform(-5, 6), rng.uniform(-5, 6)));
+        }
+        iou_batch::RectSoA sa, sb;
+        sa.assign(as);
+        sb.assign(bs);
+
+        const size_t total = (size_t)n * n;
+        const int iterations = (int)std::max<size_t>(3, 20000000 / total);
+        std::vector<float> matrix(total);
+        std::vector<iou_batch::IouPair> pairs;
+
+        Clock::time_point t0 = Clock::now();
+        for (int it = 0; it < iterations; it++) {
+            for (int i = 0; i < n; i++) {
+                for (int j = 0; j < n; j++) {
+                    matrix[(size_t)i * n + j] = compute_iou(as[i], bs[j]);
+                }
+            }
+        }
+        Clock::time_point t1 = Clock::now();
+        for (int it = 0; it < iterations; it++) {
+            iou_batch::iou_matrix(sa, sb, matrix.data());
+        }
+        Clock::time_point t2 = Clock::now();
+        for (int it = 0; it < iterations; it++) {
+            iou_batch::iou_pairs(sa, sb, 0.3, pairs);
+        }
+        Clock::time_point t3 = Clock::now();
+
+        double scalar_us = std::chrono::duration<double, std::micro>(t1 - t0).count() / iterations;
+        double dense_us = std::chrono::duration<double, std::micro>(t2 - t1).count() / iterations;
+        double sparse_us = std::chrono::duration<double, std::micro>(t3 - t2).count() / iterations;
+        char line[128];
+        snprintf(line, sizeof(line), "%5d x %-5d %10.2f %10.2f %7.3f %6.2fx %10.2f %9zu",
+                 n, n, scalar_us, dense_us, dense_us * 1000 / total, scalar_us / dense_us, sparse_us, pairs.size());
+        std::cout << line << std::endl;
+    }
+    return true;
+}
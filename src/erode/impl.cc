@@ -1,7 +1,11 @@
 #include "impls.h"
+#include "trace.h"
+#include "morphology.h"
+#include "histogram.h"
 
 
 std::vector<cv::Mat> erode(const cv::Mat& src_erode, const cv::Mat& src_dilate) {
+    TRACE_SCOPE("erode");
     /**
      * TODO: 先将图像转换为灰度图像, 然后二值化，然后进行腐蚀操作，具体内容：
      *  1. 将彩色图片 src_erode 转换为灰度图像
@@ -54,41 +58,41 @@ std::vector<cv::Mat> erode(const cv::Mat& src_erode, const cv::Mat& src_dilate)
     cv::Mat gray_erode;  // 存储src_erode转换后的灰度图像
     cv::Mat gray_dilate; // 存储src_dilate转换后的灰度图像
     
-    // 彩转灰
-    // 源图像，目标图像，转换类型
-    cv::cvtColor(src_erode, gray_erode, cv::COLOR_BGR2GRAY);
-    cv::cvtColor(src_dilate, gray_dilate, cv::COLOR_BGR2GRAY);
+    // 彩转灰，同时统计直方图，Otsu 阈值直接从直方图算，不用 cv::threshold 再扫一遍
+    // 源图像，目标图像
+    histogram::FrameHistogram hist_erode, hist_dilate;
+    hist_erode.update(src_erode, gray_erode);
+    hist_dilate.update(src_dilate, gray_dilate);
 
     cv::Mat binary_erode;
     cv::Mat binary_dilate;
     
     // 灰图二值化
     // 源图像，目标图像，阈值，最大值255，二值化类型
-    // 自适应阈值
-    cv::threshold(gray_erode, binary_erode, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
-    cv::threshold(gray_dilate, binary_dilate, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+    // 自适应阈值（Otsu，和 THRESH_OTSU 选出的阈值相同）
+    cv::threshold(gray_erode, binary_erode, hist_erode.otsu(), 255, cv::THRESH_BINARY);
+    cv::threshold(gray_dilate, binary_dilate, hist_dilate.otsu(), 255, cv::THRESH_BINARY);
 
     
-    // 创建腐蚀操作使用的核（结构元素）
-    // 核形状（矩形），核大小（像素） 1*1 3*3效果不行
+    // 腐蚀操作使用的矩形核大小（像素） 1*1 3*3效果不行
     // 消除头发中的白点
-    cv::Mat kernel_erode = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(5, 5));
+    const cv::Size kernel_erode(5, 5);
     
-    // 创建膨胀操作使用的核（结构元素）
-    // 参数说明：核形状（矩形），核大小（像素）1*1 5*5效果不行
+    // 膨胀操作使用的矩形核大小（像素）1*1 5*5效果不行
     // 消除图中的小脚
-    cv::Mat kernel_dilate = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(7, 7));
+    const cv::Size kernel_dilate(7, 7);
 
     
     // 对二值图像执行腐蚀操作
     // 作用：扩大黑色区域，消除小的白色噪点（如头发中的白点）
-    // 参数说明：输入图像，输出图像，腐蚀核
-    cv::erode(binary_erode, dst_erode, kernel_erode);
+    // 参数说明：输入图像，输出图像，腐蚀核大小
+    // 矩形核用 morph::erode，结果和 cv::erode 逐像素相同
+    morph::erode(binary_erode, dst_erode, kernel_erode);
     
     // 对二值图像执行膨胀操作
     // 作用：扩大白色区域，消除小的黑色细节（如图中的小脚）
-    // 参数说明：输入图像，输出图像，膨胀核
-    cv::dilate(binary_dilate, dst_dilate, kernel_dilate);
+    // 参数说明：输入图像，输出图像，膨胀核大小
+    morph::dilate(binary_dilate, dst_dilate, kernel_dilate);
     
     // 腐蚀 和 膨胀，两个向量
     return {dst_erode, dst_dilate};
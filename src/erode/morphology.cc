@@ -0,0 +1,293 @@
+#include "morphology.h"
+#include "mat_buffer.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace morph {
+
+// 核不超过这个长度时水平方向直接比较平移后的行，比转置成条带便宜
+static const int kDirectMaxKernel = 5;
+
+// 每块至少处理的行数，避免 halo 的重复计算占比过高
+static const int kMinTileRows = 32;
+
+// 块内每个像素需要的字节数：输入 1 + 两个乒乓缓冲区 2 + 竖直方向结果 1
+static const int kBytesPerPixel = 4;
+
+static inline uchar fillValue(Op op) {
+    // 腐蚀时界外取最大值、膨胀时取最小值，不影响结果
+    return op == ERODE ? 255 : 0;
+}
+
+// d[x] = op(a[x], b[x])，d 可以就是 a 或 b
+static void combineRow(Op op, const uchar* a, const uchar* b, uchar* d, int n) {
+    int x = 0;
+    if (op == ERODE) {
+#ifdef __SSE2__
+        for (; x + 16 <= n; x += 16) {
+            __m128i v = _mm_min_epu8(_mm_loadu_si128((const __m128i*)(a + x)),
+                                     _mm_loadu_si128((const __m128i*)(b + x)));
+            _mm_storeu_si128((__m128i*)(d + x), v);
+        }
+#endif
+        for (; x < n; x++) d[x] = std::min(a[x], b[x]);
+    } else {
+#ifdef __SSE2__
+        for (; x + 16 <= n; x += 16) {
+            __m128i v = _mm_max_epu8(_mm_loadu_si128((const __m128i*)(a + x)),
+                                     _mm_loadu_si128((const __m128i*)(b + x)));
+            _mm_storeu_si128((__m128i*)(d + x), v);
+        }
+#endif
+        for (; x < n; x++) d[x] = std::max(a[x], b[x]);
+    }
+}
+
+// van Herk / Gil-Werman：输出第 y 行是输入第 [y - a, y - a + k) 行的最值，界外行取 fill。
+// 输出按 k 行分段，段起点 bs 处：后缀 suffix[j] = op(p[bs + j .. bs + k))，
+// 前缀 prefix_j = op(p[bs + k .. bs + k + j))，dst[bs + j] = op(suffix[j], prefix_j)
+void Morphology::vertical(Op op, const cv::Mat& src, cv::Mat& dst, int k) {
+    const int n = src.rows, w = src.cols, a = k / 2;
+    fill_.assign(w, fillValue(op));
+    suffix_.resize((size_t)k * w);
+    prefix_.resize(w);
+    auto p = [&](int i) -> const uchar* {
+        int y = i - a;
+        return y >= 0 && y < n ? src.ptr<uchar>(y) : fill_.data();
+    };
+
+    for (int bs = 0; bs < n; bs += k) {
+        uchar* last = &suffix_[(size_t)(k - 1) * w];
+        memcpy(last, p(bs + k - 1), w);
+        for (int j = k - 2; j >= 0; j--) {
+            combineRow(op, p(bs + j), &suffix_[(size_t)(j + 1) * w], &suffix_[(size_t)j * w], w);
+        }
+        memcpy(dst.ptr<uchar>(bs), &suffix_[0], w);
+
+        const int count = std::min(k, n - bs);
+        const uchar* prefix = p(bs + k);
+        for (int j = 1; j < count; j++) {
+            if (j > 1) {
+                combineRow(op, prefix, p(bs + k + j - 1), prefix_.data(), w);
+                prefix = prefix_.data();
+            }
+            combineRow(op, &suffix_[(size_t)j * w], prefix, dst.ptr<uchar>(bs + j), w);
+        }
+    }
+}
+
+#ifdef __SSE2__
+template <Op OP>
+static inline __m128i combine16(__m128i a, __m128i b) {
+    return OP == ERODE ? _mm_min_epu8(a, b) : _mm_max_epu8(a, b);
+}
+
+// 同样的字节交错做 4 轮正好是 16x16 转置
+static inline void transpose16x16(__m128i v[16]) {
+    for (int round = 0; round < 4; round++) {
+        __m128i t[16];
+        for (int i = 0; i < 8; i++) {
+            t[2 * i] = _mm_unpacklo_epi8(v[i], v[i + 8]);
+            t[2 * i + 1] = _mm_unpackhi_epi8(v[i], v[i + 8]);
+        }
+        for (int i = 0; i < 16; i++) v[i] = t[i];
+    }
+}
+
+// 水平方向按 16 行一组处理：转置成 cols 个 16 字节的向量（同一列的 16 行），
+// 在这串向量上做和竖直方向一样的 van Herk / Gil-Werman，再转置回去。
+// 条带只有 cols * 16 字节，一直在 L1 里
+template <Op OP>
+static void horizontalStrips(const cv::Mat& src, cv::Mat& dst, int k, std::vector<uchar>& strip_buf,
+                             std::vector<uchar>& out_buf, std::vector<uchar>& suffix_buf, const uchar* fill_row) {
+    const int rows = src.rows, cols = src.cols, a = k / 2;
+    strip_buf.resize((size_t)cols * 16);
+    out_buf.resize((size_t)cols * 16);
+    suffix_buf.resize((size_t)k * 16);
+    __m128i* strip = (__m128i*)strip_buf.data();
+    __m128i* out = (__m128i*)out_buf.data();
+    __m128i* suffix = (__m128i*)suffix_buf.data();
+    const __m128i fill = _mm_set1_epi8((char)fillValue(OP));
+
+    for (int y = 0; y < rows; y += 16) {
+        const int n = std::min(16, rows - y);
+        const uchar* in[16];
+        for (int i = 0; i < 16; i++) {
+            in[i] = i < n ? src.ptr<uchar>(y + i) : fill_row;
+        }
+        int x = 0;
+        for (; x + 16 <= cols; x += 16) {
+            __m128i v[16];
+            for (int i = 0; i < 16; i++) v[i] = _mm_loadu_si128((const __m128i*)(in[i] + x));
+            transpose16x16(v);
+            for (int i = 0; i < 16; i++) _mm_storeu_si128(strip + x + i, v[i]);
+        }
+        for (; x < cols; x++) {
+            uchar* d = (uchar*)(strip + x);
+            for (int i = 0; i < 16; i++) d[i] = in[i][x];
+        }
+
+        auto p = [&](int i) -> __m128i {
+            int c = i - a;
+            return c >= 0 && c < cols ? _mm_loadu_si128(strip + c) : fill;
+        };
+        for (int bs = 0; bs < cols; bs += k) {
+            __m128i acc = p(bs + k - 1);
+            _mm_storeu_si128(suffix + k - 1, acc);
+            for (int j = k - 2; j >= 0; j--) {
+                acc = combine16<OP>(p(bs + j), acc);
+                _mm_storeu_si128(suffix + j, acc);
+            }
+            _mm_storeu_si128(out + bs, acc);
+            const int count = std::min(k, cols - bs);
+            __m128i prefix = fill;
+            for (int j = 1; j < count; j++) {
+                prefix = combine16<OP>(prefix, p(bs + k + j - 1));
+                _mm_storeu_si128(out + bs + j, combine16<OP>(_mm_loadu_si128(suffix + j), prefix));
+            }
+        }
+
+        x = 0;
+        for (; x + 16 <= cols; x += 16) {
+            __m128i v[16];
+            for (int i = 0; i < 16; i++) v[i] = _mm_loadu_si128(out + x + i);
+            transpose16x16(v);
+            for (int i = 0; i < n; i++) _mm_storeu_si128((__m128i*)(dst.ptr<uchar>(y + i) + x), v[i]);
+        }
+        for (; x < cols; x++) {
+            const uchar* s = (const uchar*)(out + x);
+            for (int i = 0; i < n; i++) dst.ptr<uchar>(y + i)[x] = s[i];
+        }
+    }
+}
+#endif
+
+void Morphology::horizontal(Op op, const cv::Mat& src, cv::Mat& dst, int k) {
+    const int rows = src.rows, cols = src.cols, a = k / 2;
+#ifdef __SSE2__
+    if (k > kDirectMaxKernel) {
+        // 读完 16 行才写回，dst 可以就是 src
+        fill_.assign(cols, fillValue(op));
+        if (op == ERODE) {
+            horizontalStrips<ERODE>(src, dst, k, strip_, strip_out_, suffix_, fill_.data());
+        } else {
+            horizontalStrips<DILATE>(src, dst, k, strip_, strip_out_, suffix_, fill_.data());
+        }
+        return;
+    }
+#endif
+    // 一行先拷进两侧补了界外值的缓冲区，所以 dst 可以就是 src
+    padded_.assign(cols + k - 1, fillValue(op));
+    for (int y = 0; y < rows; y++) {
+        memcpy(&padded_[a], src.ptr<uchar>(y), cols);
+        uchar* d = dst.ptr<uchar>(y);
+        combineRow(op, &padded_[0], &padded_[1], d, cols);
+        for (int j = 2; j < k; j++) {
+            combineRow(op, d, &padded_[j], d, cols);
+        }
+    }
+}
+
+void Morphology::apply(Op op, const cv::Mat& src, cv::Mat& dst, cv::Size ksize) {
+    CV_Assert(src.type() == CV_8UC1);
+    CV_Assert(ksize.width > 0 && ksize.height > 0);
+    dst.create(src.rows, src.cols, CV_8UC1);
+    if (src.empty()) return;
+
+    // 竖直方向写到自己的缓冲区，dst 和 src 是同一块内存也没关系
+    if (ksize.height > 1) {
+        cv::Mat v = reserveBuffer(vbuf_, src.rows, src.cols, CV_8UC1);
+        vertical(op, src, v, ksize.height);
+        if (ksize.width > 1) {
+            horizontal(op, v, dst, ksize.width);
+        } else {
+            v.copyTo(dst);
+        }
+    } else if (ksize.width > 1) {
+        horizontal(op, src, dst, ksize.width);
+    } else if (dst.data != src.data) {
+        src.copyTo(dst);
+    }
+}
+
+MorphSequence::MorphSequence(size_t l2_bytes)
+    : l2_bytes_(l2_bytes ? l2_bytes : 256 * 1024), tile_rows_(0) {}
+
+MorphSequence& MorphSequence::erode(cv::Size ksize) {
+    CV_Assert(ksize.width > 0 && ksize.height > 0);
+    steps_.push_back({ERODE, ksize});
+    return *this;
+}
+
+MorphSequence& MorphSequence::dilate(cv::Size ksize) {
+    CV_Assert(ksize.width > 0 && ksize.height > 0);
+    steps_.push_back({DILATE, ksize});
+    return *this;
+}
+
+MorphSequence& MorphSequence::close(cv::Size ksize) {
+    return dilate(ksize).erode(ksize);
+}
+
+MorphSequence& MorphSequence::open(cv::Size ksize) {
+    return erode(ksize).dilate(ksize);
+}
+
+int MorphSequence::haloRows() const {
+    // 块的上下边界处缺的行当作界外值，每一步让错误往块内传播竖直半径那么多行
+    int halo = 0;
+    for (const auto& step : steps_) {
+        halo += step.ksize.height / 2;
+    }
+    return halo;
+}
+
+void MorphSequence::apply(const cv::Mat& src, cv::Mat& dst) {
+    CV_Assert(src.type() == CV_8UC1);
+    const int rows = src.rows, cols = src.cols;
+    dst.create(rows, cols, CV_8UC1);
+    CV_Assert(dst.data != src.data);
+    if (steps_.empty() || src.empty()) {
+        src.copyTo(dst);
+        return;
+    }
+
+    const int halo = haloRows();
+    int rows_fit = (int)(l2_bytes_ / ((size_t)cols * kBytesPerPixel));
+    tile_rows_ = std::min(std::max(rows_fit - 2 * halo, kMinTileRows), rows);
+    const int buf_rows = std::min(tile_rows_ + 2 * halo, rows);
+    cv::Mat ping_all = reserveBuffer(ping_, buf_rows, cols, CV_8UC1);
+    cv::Mat pong_all = reserveBuffer(pong_, buf_rows, cols, CV_8UC1);
+
+    // 图像上下边界处块从第 0 行 / 最后一行开始，边界处理与整幅图一致；
+    // 块与块之间缺的行造成的误差最多传播 halo 行，被裁掉不输出
+    for (int y0 = 0; y0 < rows; y0 += tile_rows_) {
+        int y1 = std::min(rows, y0 + tile_rows_);
+        int a = std::max(0, y0 - halo);
+        int b = std::min(rows, y1 + halo);
+
+        cv::Mat bufs[2] = {ping_all.rowRange(0, b - a), pong_all.rowRange(0, b - a)};
+        cv::Mat cur = src.rowRange(a, b);
+        for (size_t i = 0; i < steps_.size(); i++) {
+            engine_.apply(steps_[i].op, cur, bufs[i & 1], steps_[i].ksize);
+            cur = bufs[i & 1];
+        }
+        cur.rowRange(y0 - a, y1 - a).copyTo(dst.rowRange(y0, y1));
+    }
+}
+
+void erode(const cv::Mat& src, cv::Mat& dst, cv::Size ksize) {
+    Morphology engine;
+    engine.erode(src, dst, ksize);
+}
+
+void dilate(const cv::Mat& src, cv::Mat& dst, cv::Size ksize) {
+    Morphology engine;
+    engine.dilate(src, dst, ksize);
+}
+
+} // namespace morph
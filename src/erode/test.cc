@@ -1,4 +1,8 @@
 #include "impls.h"
+#include "utils.h"
+#include "golden.h"
+#include "log.h"
+#include "morphology.h"
 
 
 bool test_erode() {
@@ -10,6 +14,22 @@ bool test_erode() {
     cv::Mat dst_erode = dst[0];
     cv::Mat dst_dilate = dst[1];
 
+    if (is_headless()) {
+        if (dst_erode.empty() || dst_dilate.empty()) {
+            std::cout << "erode检查点. 你的实现有误，返回的图像为空" << std::endl;
+            return false;
+        }
+        // 白点和小脚是否消除体现在前景和答案的重合程度上，只做二值化不处理时 IoU 约 0.94 / 0.97
+        golden::Tolerance tolerance;
+        tolerance.pixel = 127;
+        tolerance.max_over_fraction = 1;
+        tolerance.min_iou = 0.98;
+        cv::Mat erode_key = cv::imread("../assets/erode/erode_key.jpg", cv::IMREAD_GRAYSCALE);
+        cv::Mat dilate_key = cv::imread("../assets/erode/dilate_key.jpg", cv::IMREAD_GRAYSCALE);
+        bool pass = golden::check("erode", dst_erode, erode_key, tolerance);
+        return golden::check("dilate", dst_dilate, dilate_key, tolerance) && pass;
+    }
+
     {
         cv::Mat gray;
         cv::cvtColor(src_erode, gray, cv::COLOR_BGR2GRAY);
@@ -75,5 +95,143 @@ bool test_erode() {
         cv::destroyAllWindows();
     }
 
+    return flag;
+}
+
+bool test_morphology() {
+    cv::RNG rng(20241203);
+    // 宽高覆盖不满 16 个像素、正好 16 的倍数和有尾巴的情况
+    const cv::Size sizes[] = {cv::Size(1, 1), cv::Size(7, 5), cv::Size(16, 16), cv::Size(203, 157), cv::Size(640, 37)};
+    const cv::Size ksizes[] = {cv::Size(1, 1), cv::Size(3, 3), cv::Size(5, 5), cv::Size(7, 7), cv::Size(2, 2),
+                               cv::Size(4, 6), cv::Size(1, 9), cv::Size(9, 1), cv::Size(31, 31), cv::Size(15, 3),
+                               cv::Size(40, 2)};
+    morph::Morphology engine;
+
+    for (const auto& size : sizes) {
+        cv::Mat src = make_random_mask(size.height, size.width, 1, 4, rng);
+        cv::Mat out, expected;
+        for (const auto& ksize : ksizes) {
+            cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, ksize);
+            for (bool erode : {true, false}) {
+                if (erode) {
+                    cv::erode(src, expected, kernel);
+                    engine.erode(src, out, ksize);
+                } else {
+                    cv::dilate(src, expected, kernel);
+                    engine.dilate(src, out, ksize);
+                }
+                int wrong = golden::compare(out, expected).over_count;
+                if (wrong != 0) {
+                    LOG_ERROR("%dx%d: %dx%d %s 与 OpenCV 不一致，不一致像素 %d", size.width, size.height,
+                              ksize.width, ksize.height, erode ? "腐蚀" : "膨胀", wrong);
+                    return false;
+                }
+            }
+        }
+        std::cout << size.width << "x" << size.height << ": 腐蚀、膨胀与 OpenCV 一致" << std::endl;
+    }
+
+    // 不连续的子区域当作独立图像处理，也可以原地处理
+    cv::Mat big = make_random_mask(157, 203, 1, 4, rng);
+    cv::Mat roi = big(cv::Rect(5, 7, 101, 93));
+    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(7, 5));
+    cv::Mat expected, out = roi.clone();
+    cv::erode(roi, expected, kernel, cv::Point(-1, -1), 1, cv::BORDER_CONSTANT | cv::BORDER_ISOLATED);
+    engine.erode(out, out, cv::Size(7, 5));
+    if (golden::compare(out, expected).over_count != 0) {
+        LOG_ERROR("原地腐蚀与 OpenCV 不一致");
+        return false;
+    }
+    kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(19, 3));
+    cv::dilate(roi, expected, kernel, cv::Point(-1, -1), 1, cv::BORDER_CONSTANT | cv::BORDER_ISOLATED);
+    engine.dilate(roi, out, cv::Size(19, 3));
+    if (golden::compare(out, expected).over_count != 0) {
+        LOG_ERROR("子区域膨胀与 OpenCV 不一致");
+        return false;
+    }
+
+    // 分块的序列和逐步调用 OpenCV 一致，很小的 L2 让图像切成很多块
+    cv::Mat k3 = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
+    cv::Mat k5 = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(5, 5));
+    cv::Mat k97 = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(9, 7));
+    cv::Mat close_open, chain;
+    cv::morphologyEx(big, close_open, cv::MORPH_CLOSE, k3);
+    cv::morphologyEx(close_open, close_open, cv::MORPH_OPEN, k3);
+    cv::dilate(big, chain, k3);
+    cv::erode(chain, chain, k5);
+    cv::dilate(chain, chain, k3);
+    cv::morphologyEx(chain, chain, cv::MORPH_CLOSE, k97);
+    for (size_t l2 : {(size_t)0, (size_t)4096}) {
+        morph::MorphSequence seq1(l2), seq2(l2);
+        seq1.close(cv::Size(3, 3)).open(cv::Size(3, 3));
+        seq2.dilate(cv::Size(3, 3)).erode(cv::Size(5, 5)).dilate(cv::Size(3, 3)).close(cv::Size(9, 7));
+        seq1.apply(big, out);
+        int wrong1 = golden::compare(out, close_open).over_count;
+        seq2.apply(big, out);
+        int wrong2 = golden::compare(out, chain).over_count;
+        if (wrong1 != 0 || wrong2 != 0) {
+            LOG_ERROR("L2 %d 字节: 分块序列与 OpenCV 不一致，不一致像素 %d / %d", (int)l2, wrong1, wrong2);
+            return false;
+        }
+        std::cout << "L2 " << (l2 ? l2 : 256 * 1024) << " 字节: 块 " << seq2.tileRows() << " 行, halo "
+                  << seq2.haloRows() << " 行，分块序列与 OpenCV 一致" << std::endl;
+    }
+    return true;
+}
+
+bool bench_morphology() {
+    cv::RNG rng(12345);
+    cv::Mat src(1024, 1280, CV_8UC1);
+    rng.fill(src, cv::RNG::UNIFORM, 0, 256);
+    cv::GaussianBlur(src, src, cv::Size(0, 0), 2);
+    const int iterations = 50;
+    morph::Morphology engine;
+    cv::Mat expected, out;
+
+    // 单次腐蚀：OpenCV 每个像素的比较次数随核长增长，van Herk / Gil-Werman 基本不变
+    for (int k = 3; k <= 31; k += 4) {
+        const cv::Size ksize(k, k);
+        const cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, ksize);
+        cv::erode(src, expected, kernel);
+        engine.erode(src, out, ksize);
+        int64 t0 = cv::getTickCount();
+        for (int i = 0; i < iterations; i++) {
+            cv::erode(src, expected, kernel);
+        }
+        int64 t1 = cv::getTickCount();
+        for (int i = 0; i < iterations; i++) {
+            engine.erode(src, out, ksize);
+        }
+        int64 t2 = cv::getTickCount();
+        double cv_ms = (t1 - t0) * 1000.0 / cv::getTickFrequency() / iterations;
+        double our_ms = (t2 - t1) * 1000.0 / cv::getTickFrequency() / iterations;
+        std::cout << "1280x1024 腐蚀 " << k << "x" << k << ": cv::erode " << cv_ms << " ms, morph "
+                  << our_ms << " ms, 加速 " << cv_ms / our_ms << "x, 不一致像素 "
+                  << golden::compare(out, expected).over_count << std::endl;
+    }
+
+    // 闭运算接开运算：两次 morphologyEx 对比分块的一次序列
+    for (int k : {3, 5, 9}) {
+        const cv::Size ksize(k, k);
+        const cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, ksize);
+        morph::MorphSequence seq;
+        seq.close(ksize).open(ksize);
+        cv::Mat tmp;
+        int64 t0 = cv::getTickCount();
+        for (int i = 0; i < iterations; i++) {
+            cv::morphologyEx(src, tmp, cv::MORPH_CLOSE, kernel);
+            cv::morphologyEx(tmp, expected, cv::MORPH_OPEN, kernel);
+        }
+        int64 t1 = cv::getTickCount();
+        for (int i = 0; i < iterations; i++) {
+            seq.apply(src, out);
+        }
+        int64 t2 = cv::getTickCount();
+        double cv_ms = (t1 - t0) * 1000.0 / cv::getTickFrequency() / iterations;
+        double our_ms = (t2 - t1) * 1000.0 / cv::getTickFrequency() / iterations;
+        std::cout << "1280x1024 闭运算 + 开运算 " << k << "x" << k << ": morphologyEx " << cv_ms
+                  << " ms, 分块序列 " << our_ms << " ms (块 " << seq.tileRows() << " 行), 加速 "
+                  << cv_ms / our_ms << "x, 不一致像素 " << golden::compare(out, expected).over_count << std::endl;
+    }
     return true;
 }
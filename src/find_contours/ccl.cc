@@ -0,0 +1,311 @@
+#include "ccl.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ccl {
+
+// 每个条带的行数。条带数只取决于图像高度，和线程数无关，结果和单线程逐行扫描相同
+static const int kBandRows = 64;
+
+void Component::principalVariances(double& major, double& minor) const {
+    const double cx = (double)m10 / area, cy = (double)m01 / area;
+    const double a = (double)m20 / area - cx * cx;
+    const double b = (double)m11 / area - cx * cy;
+    const double c = (double)m02 / area - cy * cy;
+    const double mean = 0.5 * (a + c);
+    const double d = std::sqrt(0.25 * (a - c) * (a - c) + b * b);
+    major = mean + d;
+    minor = std::max(0.0, mean - d);
+}
+
+double Component::elongation() const {
+    double major, minor;
+    principalVariances(major, minor);
+    return std::sqrt((12 * major + 1) / (12 * minor + 1));
+}
+
+cv::RotatedRect Component::equivalentRect() const {
+    double major, minor;
+    principalVariances(major, minor);
+    const double cx = (double)m10 / area, cy = (double)m01 / area;
+    const double a = (double)m20 / area - cx * cx;
+    const double b = (double)m11 / area - cx * cy;
+    const double c = (double)m02 / area - cy * cy;
+    const float len = (float)std::sqrt(12 * major + 1);
+    const float wid = (float)std::sqrt(12 * minor + 1);
+
+    // 主轴方向（图像坐标，y 向下，和 RotatedRect 的角度方向一致），取 [0, 180)
+    double phi = 0.5 * std::atan2(2 * b, a - c) * 180 / CV_PI;
+    if (phi < 0) phi += 180;
+    // 两条边的方向是 phi 和 phi + 90，取落在 (0, 90] 的那条作为 width 边
+    if (phi > 0 && phi <= 90) {
+        return cv::RotatedRect(cv::Point2f((float)cx, (float)cy), cv::Size2f(len, wid), (float)phi);
+    }
+    float angle = phi == 0 ? 90.f : (float)(phi - 90);
+    return cv::RotatedRect(cv::Point2f((float)cx, (float)cy), cv::Size2f(wid, len), angle);
+}
+
+// 一行里的前景行程追加到 out。SSE2 下整 16 个像素全是背景或全是前景时直接跳过
+static void extractRowRuns(const uchar* p, int cols, int y, std::vector<bitmask::Run>& out) {
+    int x = 0;
+    while (x < cols) {
+#ifdef __SSE2__
+        for (; x + 16 <= cols; x += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(p + x));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xFFFF) break;
+        }
+#endif
+        while (x < cols && !p[x]) x++;
+        if (x == cols) break;
+        const int begin = x;
+#ifdef __SSE2__
+        for (; x + 16 <= cols; x += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(p + x));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0) break;
+        }
+#endif
+        while (x < cols && p[x]) x++;
+        out.push_back({y, begin, x});
+    }
+}
+
+static inline int findRoot(int* parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// 根总是下标小的一方，也就是光栅顺序靠前的行程
+static inline void unite(int* parent, int a, int b) {
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a < b) {
+        parent[b] = a;
+    } else if (b < a) {
+        parent[a] = b;
+    }
+}
+
+// 合并相邻两行的行程：上一行 [a0, a1)，这一行 [b0, b1)，下标同时用于 runs 和 parent。
+// 8 连通时斜对角相接也算，区间各向外放宽 1
+static void mergeRows(const bitmask::Run* runs, int* parent, int a0, int a1, int b0, int b1, int slack) {
+    int i = a0, j = b0;
+    while (i < a1 && j < b1) {
+        const bitmask::Run& a = runs[i];
+        const bitmask::Run& b = runs[j];
+        if (a.begin < b.end + slack && b.begin < a.end + slack) {
+            unite(parent, i, j);
+        }
+        if (a.end < b.end) {
+            i++;
+        } else {
+            j++;
+        }
+    }
+}
+
+void Labeller::label(const cv::Mat& binary, std::vector<Component>& components, int connectivity) {
+    CV_Assert(binary.type() == CV_8UC1 && (connectivity == 4 || connectivity == 8));
+    const int rows = binary.rows, cols = binary.cols;
+    const int nbands = (rows + kBandRows - 1) / kBandRows;
+    const int slack = connectivity == 8 ? 1 : 0;
+    if (bands_.size() < (size_t)nbands) bands_.resize(nbands);
+
+    // 条带内：逐行提取行程，和上一行合并
+    cv::parallel_for_(cv::Range(0, nbands), [&](const cv::Range& range) {
+        for (int b = range.start; b < range.end; b++) {
+            Band& band = bands_[b];
+            band.y0 = b * kBandRows;
+            band.y1 = std::min(rows, band.y0 + kBandRows);
+            band.runs.clear();
+            int prev0 = 0, prev1 = 0;
+            for (int y = band.y0; y < band.y1; y++) {
+                extractRowRuns(binary.ptr<uchar>(y), cols, y, band.runs);
+                const int cur1 = (int)band.runs.size();
+                band.parent.resize(cur1);
+                for (int i = prev1; i < cur1; i++) band.parent[i] = i;
+                mergeRows(band.runs.data(), band.parent.data(), prev0, prev1, prev1, cur1, slack);
+                prev0 = prev1;
+                prev1 = cur1;
+            }
+            band.count = (int)band.runs.size();
+        }
+    }, nbands);
+
+    // 拼成整幅图的行程表，并查集的下标加上条带的偏移
+    int total = 0;
+    for (int b = 0; b < nbands; b++) {
+        bands_[b].first = total;
+        total += bands_[b].count;
+    }
+    runs_.resize(total);
+    parent_.resize(total);
+    for (int b = 0; b < nbands; b++) {
+        const Band& band = bands_[b];
+        std::copy(band.runs.begin(), band.runs.begin() + band.count, runs_.begin() + band.first);
+        for (int i = 0; i < band.count; i++) {
+            parent_[band.first + i] = band.parent[i] + band.first;
+        }
+    }
+
+    row_start_.assign(rows + 1, 0);
+    for (const auto& r : runs_) row_start_[r.y + 1]++;
+    for (int y = 0; y < rows; y++) row_start_[y + 1] += row_start_[y];
+
+    // 条带之间只剩交界的两行没有合并
+    for (int b = 1; b < nbands; b++) {
+        const int y = bands_[b].y0;
+        mergeRows(runs_.data(), parent_.data(), row_start_[y - 1], row_start_[y], row_start_[y],
+                  row_start_[y + 1], slack);
+    }
+    resolve(components);
+}
+
+void Labeller::label(const std::vector<bitmask::Run>& runs, int rows, std::vector<Component>& components,
+                     int connectivity) {
+    CV_Assert(connectivity == 4 || connectivity == 8);
+    // 行程已经提取好了，合并只是按行程数线性的一遍，不再分条带
+    runs_.assign(runs.begin(), runs.end());
+    const int total = (int)runs_.size();
+    parent_.resize(total);
+    for (int i = 0; i < total; i++) parent_[i] = i;
+
+    row_start_.assign(rows + 1, 0);
+    for (const auto& r : runs_) {
+        CV_Assert(r.y >= 0 && r.y < rows);
+        row_start_[r.y + 1]++;
+    }
+    for (int y = 0; y < rows; y++) row_start_[y + 1] += row_start_[y];
+
+    const int slack = connectivity == 8 ? 1 : 0;
+    for (int y = 1; y < rows; y++) {
+        mergeRows(runs_.data(), parent_.data(), row_start_[y - 1], row_start_[y], row_start_[y],
+                  row_start_[y + 1], slack);
+    }
+    resolve(components);
+}
+
+// n 以内非负整数的平方和
+static inline int64_t sumSquares(int64_t n) {
+    return (n - 1) * n * (2 * n - 1) / 6;
+}
+
+void Labeller::resolve(std::vector<Component>& components) {
+    const int total = (int)runs_.size();
+    run_label_.resize(total);
+    components.clear();
+
+    for (int i = 0; i < total; i++) {
+        // 根是连通域里光栅顺序最靠前的行程，在 i 之前已经编好号
+        const int root = findRoot(parent_.data(), i);
+        const bitmask::Run& r = runs_[i];
+        if (root == i) {
+            run_label_[i] = (int)components.size();
+            Component c;
+            c.area = 0;
+            // 累加期间 bbox 的 width / height 暂存右、下边界（不含）
+            c.bbox = cv::Rect(r.begin, r.y, r.end, r.y + 1);
+            c.m10 = c.m01 = c.m20 = c.m11 = c.m02 = 0;
+            components.push_back(c);
+        } else {
+            run_label_[i] = run_label_[root];
+        }
+
+        Component& c = components[run_label_[i]];
+        const int64_t n = r.end - r.begin, y = r.y;
+        const int64_t sx = (int64_t)(r.begin + r.end - 1) * n / 2;
+        c.area += (int)n;
+        c.m10 += sx;
+        c.m01 += y * n;
+        c.m20 += sumSquares(r.end) - sumSquares(r.begin);
+        c.m11 += y * sx;
+        c.m02 += y * y * n;
+        c.bbox.x = std::min(c.bbox.x, r.begin);
+        c.bbox.width = std::max(c.bbox.width, r.end);
+        c.bbox.height = r.y + 1;
+    }
+
+    for (auto& c : components) {
+        c.bbox.width -= c.bbox.x;
+        c.bbox.height -= c.bbox.y;
+    }
+}
+
+void Labeller::labels(cv::Size size, cv::Mat& dst) const {
+    dst.create(size, CV_32SC1);
+    dst.setTo(cv::Scalar(0));
+    for (size_t i = 0; i < runs_.size(); i++) {
+        const bitmask::Run& r = runs_[i];
+        int* p = dst.ptr<int>(r.y);
+        std::fill(p + r.begin, p + r.end, run_label_[i] + 1);
+    }
+}
+
+void Labeller::paint(const std::vector<uchar>& keep, cv::Size size, cv::Mat& dst) const {
+    dst.create(size, CV_8UC1);
+    dst.setTo(cv::Scalar(0));
+    for (size_t i = 0; i < runs_.size(); i++) {
+        if (!keep[run_label_[i]]) continue;
+        const bitmask::Run& r = runs_[i];
+        uchar* p = dst.ptr<uchar>(r.y);
+        std::fill(p + r.begin, p + r.end, (uchar)255);
+    }
+}
+
+void OuterFilter::compute(const Labeller& labeller, const std::vector<Component>& components, cv::Size size,
+                          std::vector<uchar>& outer) {
+    const int rows = size.height, cols = size.width;
+    const std::vector<bitmask::Run>& fg = labeller.runs_;
+    const std::vector<int>& fg_start = labeller.row_start_;
+    CV_Assert((int)fg_start.size() == rows + 1);
+
+    runs_.clear();
+    for (int y = 0; y < rows; y++) {
+        int x = 0;
+        for (int i = fg_start[y]; i < fg_start[y + 1]; i++) {
+            if (fg[i].begin > x) runs_.push_back(bitmask::Run{y, x, fg[i].begin});
+            x = fg[i].end;
+        }
+        if (x < cols) runs_.push_back(bitmask::Run{y, x, cols});
+    }
+    background_.label(runs_, rows, components_, 4);
+    const std::vector<bitmask::Run>& bg = background_.runs_;
+    const std::vector<int>& bg_start = background_.row_start_;
+
+    // 连通域按第一个行程的顺序编号，依次遇到的新编号就是各自的第一个行程
+    outer.assign(components.size(), 0);
+    int next = 0;
+    for (size_t i = 0; i < fg.size() && next < (int)components.size(); i++) {
+        if (labeller.run_label_[i] != next) continue;
+        const bitmask::Run& r = fg[i];
+        if (r.y == 0) {
+            outer[next++] = 1;
+            continue;
+        }
+        // 上一行里包含 r.begin 的背景行程
+        const bitmask::Run* first = bg.data() + bg_start[r.y - 1];
+        const bitmask::Run* last = bg.data() + bg_start[r.y];
+        const bitmask::Run* above = std::upper_bound(first, last, r.begin,
+            [](int x, const bitmask::Run& run) { return x < run.begin; }) - 1;
+        CV_DbgAssert(above >= first && above->begin <= r.begin && r.begin < above->end);
+        const cv::Rect& box = components_[background_.run_label_[above - bg.data()]].bbox;
+        outer[next++] = box.x == 0 || box.y == 0 || box.x + box.width == cols || box.y + box.height == rows;
+    }
+}
+
+size_t Labeller::bufferBytes() const {
+    size_t bytes = runs_.capacity() * sizeof(bitmask::Run) +
+                   (parent_.capacity() + run_label_.capacity() + row_start_.capacity()) * sizeof(int);
+    for (const auto& band : bands_) {
+        bytes += band.runs.capacity() * sizeof(bitmask::Run) + band.parent.capacity() * sizeof(int);
+    }
+    return bytes;
+}
+
+} // namespace ccl
@@ -1,7 +1,12 @@
 #include "impls.h"
+#include "trace.h"
+#include "histogram.h"
+#include "ccl.h"
+#include "leaf_contours.h"
 
 
-std::vector<std::vector<cv::Point>> find_contours(const cv::Mat& input) {
+std::vector<std::vector<cv::Point>> find_contours(const cv::Mat& input, bool leaf_only, int min_blob_area) {
+    TRACE_SCOPE("find_contours");
     /**
      * 要求：
      * 使用cv::findContours函数，从输入图像（3个通道）中找出所有的最内层轮廓。
@@ -30,11 +35,33 @@ std::vector<std::vector<cv::Point>> find_contours(const cv::Mat& input) {
     
     // 彩色-->灰度-->二值，简化处理
     cv::Mat gray;
-    cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);// 源图像，目标图像，转换类型
+    histogram::FrameHistogram hist;
+    hist.update(input, gray);// 彩转灰的同时统计直方图
     cv::Mat binary;
-    cv::threshold(gray, binary, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);//源图像，目标图像，阈值，最大值，二值化类型
+    cv::threshold(gray, binary, hist.otsu(), 255, cv::THRESH_BINARY);//源图像，目标图像，Otsu 阈值，最大值，二值化类型
+
+    // 调用方要求去掉噪点时：一次连通域标记拿到每块的面积，直接从二值图上抹掉，
+    // 不用先提取它们的轮廓再按 contourArea 过滤。抹掉的块本来可能是最内层轮廓，也可能让外面的轮廓变成最内层
+    if (min_blob_area > 0) {
+        ccl::Labeller labeller;
+        std::vector<ccl::Component> components;
+        labeller.label(binary, components);
+        std::vector<uchar> keep(components.size());
+        for (size_t i = 0; i < components.size(); i++) {
+            keep[i] = components[i].area >= min_blob_area;
+        }
+        labeller.paint(keep, binary.size(), binary);
+    }
     
 
+    if (leaf_only) {
+        // 有子轮廓的轮廓点列提取出来马上就丢掉了。先由连通域标记弄清包含关系，只追踪最内层的那些边界，
+        // 结果和下面 RETR_TREE 筛出来的轮廓逐点相同。外层轮廓又长又多时省得多，几乎全是叶子时差不多
+        ccl::LeafContours leaves;
+        leaves.find(binary, res);
+        return res;
+    }
+
     std::vector<std::vector<cv::Point>> contours;// 用于存储所有找到的轮廓
     std::vector<cv::Vec4i> hierarchy;// 用于存储轮廓的层次结构信息，cv::Vec4i表示每个轮廓的4个层次信息
     /*
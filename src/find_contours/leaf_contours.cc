@@ -0,0 +1,150 @@
+#include "leaf_contours.h"
+#include <algorithm>
+
+namespace ccl {
+
+// 包含像素 (x, y) 的行程下标，runs 按 (y, begin) 升序，并且这个像素一定在某个行程里
+static int runAt(const std::vector<bitmask::Run>& runs, int y, int x) {
+    auto it = std::lower_bound(runs.begin(), runs.end(), cv::Point(x, y),
+                               [](const bitmask::Run& r, const cv::Point& p) {
+                                   return r.y < p.y || (r.y == p.y && r.end <= p.x);
+                               });
+    return (int)(it - runs.begin());
+}
+
+void LeafContours::find(const cv::Mat& binary, std::vector<std::vector<cv::Point>>& contours) {
+    CV_Assert(binary.type() == CV_8UC1);
+    const int rows = binary.rows, cols = binary.cols;
+
+    fg_.label(binary, fg_components_, 8);
+    const std::vector<bitmask::Run>& runs = fg_.runs();
+    const std::vector<int>& run_label = fg_.runComponents();
+    const int nruns = (int)runs.size();
+
+    // 前景行程之间的空隙就是背景行程
+    gaps_.clear();
+    int i = 0;
+    for (int y = 0; y < rows; y++) {
+        int x = 0;
+        for (; i < nruns && runs[i].y == y; i++) {
+            if (runs[i].begin > x) gaps_.push_back({y, x, runs[i].begin});
+            x = runs[i].end;
+        }
+        if (x < cols) gaps_.push_back({y, x, cols});
+    }
+    bg_.label(gaps_, rows, bg_components_, 4);
+    const std::vector<int>& gap_label = bg_.runComponents();
+
+    // 孔：不碰边界的背景连通域。第一个像素左边一定是前景，所在的连通域就是外层，外边界不是叶子。
+    // 连通域按第一个行程的光栅顺序编号，顺序扫行程时标签等于已见个数的就是第一个行程
+    const int nfg = (int)fg_components_.size(), nbg = (int)bg_components_.size();
+    keep_.assign(nfg, 1);
+    hole_leaf_.assign(nbg, 0);
+    holes_ = 0;
+    for (int g = 0, next = 0; g < (int)gaps_.size(); g++) {
+        const int h = gap_label[g];
+        if (h < next) continue;
+        next++;
+        const cv::Rect& b = bg_components_[h].bbox;
+        if (b.x == 0 || b.y == 0 || b.x + b.width == cols || b.y + b.height == rows) continue;
+        hole_leaf_[h] = 1;
+        holes_++;
+        keep_[run_label[runAt(runs, gaps_[g].y, gaps_[g].begin - 1)]] = 0;
+    }
+
+    // 前景连通域第一个像素左边的背景就是它的外层，是孔的话就不是叶子
+    for (int r = 0, next = 0; r < nruns; r++) {
+        if (run_label[r] < next) continue;
+        next++;
+        if (runs[r].begin > 0) hole_leaf_[gap_label[runAt(gaps_, runs[r].y, runs[r].begin - 1)]] = 0;
+    }
+
+    // 没有孔的前景连通域互不包含，画在一起一次取外边界。边界追踪只看 8 邻域，
+    // 擦掉的都是别的连通域，和原图上追踪的结果相同
+    fg_.paint(keep_, binary.size(), canvas_);
+    cv::findContours(canvas_, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+
+    // 叶子孔：追踪孔边界时每一步转圈找下一个点，经过的 0 像素都和孔 4 连通，停下的像素都是前景，
+    // 所以孔以外的像素全当成前景，追踪结果也一样。每个孔取外接框外扩 2 像素的一块，除了孔都是 255，
+    // 四周各留一圈 0，一行行排进一张拼图：每块恰好一条外边界（矩形，4 个点）和一条孔边界
+    tiles_.clear();
+    for (int g = 0; g < (int)gaps_.size(); g++) {
+        const int h = gap_label[g];
+        if (!hole_leaf_[h]) continue;
+        hole_leaf_[h] = 0;      // 从第一个行程处理，之后跳过
+        const cv::Rect& b = bg_components_[h].bbox;
+        Tile tile;
+        tile.src = cv::Rect(b.x - 2, b.y - 2, b.width + 4, b.height + 4);
+        tile.hole = h;
+        tiles_.push_back(tile);
+    }
+    if (tiles_.empty()) return;
+
+    // 按高度从大到小排成若干行，每行高度由第一块决定，浪费的面积少
+    std::stable_sort(tiles_.begin(), tiles_.end(),
+                     [](const Tile& a, const Tile& b) { return a.src.height > b.src.height; });
+    shelf_y_.clear();
+    shelf_first_.clear();
+    hole_tile_.assign(nbg, -1);
+    const int width = cols + 4;
+    int x = width, y = 0, shelf_height = 0;
+    for (size_t i = 0; i < tiles_.size(); i++) {
+        Tile& tile = tiles_[i];
+        hole_tile_[tile.hole] = (int)i;
+        if (x + tile.src.width + 2 > width) {
+            y += shelf_height;
+            x = 0;
+            shelf_height = tile.src.height + 2;
+            shelf_y_.push_back(y);
+            shelf_first_.push_back((int)i);
+        }
+        tile.dst = cv::Point(x + 1, y + 1);
+        x += tile.src.width + 2;
+    }
+
+    mosaic_.create(y + shelf_height, width, CV_8UC1);
+    mosaic_.setTo(cv::Scalar(0));
+    for (const Tile& tile : tiles_) {
+        mosaic_(cv::Rect(tile.dst, tile.src.size())).setTo(cv::Scalar(255));
+    }
+    for (int g = 0; g < (int)gaps_.size(); g++) {
+        const int t = hole_tile_[gap_label[g]];
+        if (t < 0) continue;
+        const Tile& tile = tiles_[t];
+        const bitmask::Run& r = gaps_[g];
+        uchar* p = mosaic_.ptr<uchar>(tile.dst.y + r.y - tile.src.y) + tile.dst.x - tile.src.x;
+        std::fill(p + r.begin, p + r.end, (uchar)0);
+    }
+    cv::findContours(mosaic_, tile_contours_, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+
+    // 轮廓的第一个点落在哪一块，就平移回那块在原图上的位置。外边界从块的左上角开始，跳过
+    for (size_t c = 0; c < tile_contours_.size(); c++) {
+        const cv::Point& p = tile_contours_[c][0];
+        const int shelf = (int)(std::upper_bound(shelf_y_.begin(), shelf_y_.end(), p.y) - shelf_y_.begin()) - 1;
+        const int end = shelf + 1 < (int)shelf_first_.size() ? shelf_first_[shelf + 1] : (int)tiles_.size();
+        auto it = std::upper_bound(tiles_.begin() + shelf_first_[shelf], tiles_.begin() + end, p.x,
+                                   [](int x, const Tile& t) { return x < t.dst.x; });
+        const Tile& tile = *(it - 1);
+        if (p.x == tile.dst.x && p.y == tile.dst.y) continue;
+        const int dx = tile.src.x - tile.dst.x, dy = tile.src.y - tile.dst.y;
+
+        contours.emplace_back();
+        std::vector<cv::Point>& contour = contours.back();
+        contour.reserve(tile_contours_[c].size());
+        for (const auto& q : tile_contours_[c]) contour.push_back(cv::Point(q.x + dx, q.y + dy));
+    }
+}
+
+size_t LeafContours::bufferBytes() const {
+    size_t bytes = fg_.bufferBytes() + bg_.bufferBytes() +
+                   (fg_components_.capacity() + bg_components_.capacity()) * sizeof(Component) +
+                   gaps_.capacity() * sizeof(bitmask::Run) +
+                   keep_.capacity() + hole_leaf_.capacity() +
+                   tiles_.capacity() * sizeof(Tile) +
+                   (hole_tile_.capacity() + shelf_y_.capacity() + shelf_first_.capacity()) * sizeof(int) +
+                   canvas_.total() * canvas_.elemSize() + mosaic_.total() * mosaic_.elemSize();
+    for (const auto& c : tile_contours_) bytes += c.capacity() * sizeof(cv::Point);
+    return bytes;
+}
+
+} // namespace ccl
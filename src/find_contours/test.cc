@@ -1,10 +1,24 @@
 #include "impls.h"
 #include "utils.h"
+#include "golden.h"
+#include "ccl.h"
+#include "leaf_contours.h"
 
 using std::vector;
 using std::cout;
 using std::endl;
 
+// 轮廓按点列排序后比较，顺序不同不算错
+static std::vector<std::vector<cv::Point>> sorted_contours(std::vector<std::vector<cv::Point>> contours) {
+    std::sort(contours.begin(), contours.end(), [](const vector<cv::Point>& a, const vector<cv::Point>& b) {
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(),
+                                            [](const cv::Point& p, const cv::Point& q) {
+                                                return p.y != q.y ? p.y < q.y : p.x < q.x;
+                                            });
+    });
+    return contours;
+}
+
 bool test_find_contours() {
     cv::Mat input = cv::imread("../assets/find_contours/input.png");
     cv::Mat ans = cv::imread("../assets/find_contours/answer.jpg");
@@ -12,16 +26,277 @@ bool test_find_contours() {
     vector<vector<cv::Point>> output = find_contours(input);
     cv::Mat res = show_contours(output, input.rows, input.cols);
 
-    cv::imshow("<test_find_contours> 正确的答案", ans);
-    cv::imshow("<test_find_contours> 你的答案", res);
-    cv::waitKey(0);
-    cv::destroyAllWindows();
+    if (!is_headless()) {
+        cv::imshow("<test_find_contours> 正确的答案", ans);
+        cv::imshow("<test_find_contours> 你的答案", res);
+        cv::waitKey(0);
+        cv::destroyAllWindows();
+    }
     
     if (output.size() != 3) {
         cout << "轮廓的个数不对，正确的个数应当为3个，你找到了" << output.size()
              << "个。" << endl;
         return false;
     }
+    if (sorted_contours(output) != sorted_contours(find_contours(input, false))) {
+        cout << "只取最内层轮廓和 RETR_TREE 筛选的结果不一致" << endl;
+        return false;
+    }
+
+    if (is_headless()) {
+        // 线条图各自膨胀 1 像素再比较，容忍抗锯齿和线宽的差别
+        double iou = golden::mask_iou(res, ans, 1);
+        cout << "轮廓图与答案的 IoU: " << iou << endl;
+        return iou >= 0.8;
+    }
+
+    return true;
+}
+bool test_ccl() {
+    cv::RNG rng(20241214);
+    // 高度跨过条带边界（64 行），宽度有不满 16 个像素的尾巴
+    const cv::Size sizes[] = {cv::Size(1, 1), cv::Size(50, 1), cv::Size(1, 50), cv::Size(64, 63),
+                              cv::Size(65, 64), cv::Size(17, 130), cv::Size(301, 200), cv::Size(640, 257)};
+    const double densities[] = {0.05, 0.3, 0.5, 0.7};
+    ccl::Labeller labeller, run_labeller;
+    std::vector<ccl::Component> components, from_runs;
+
+    for (int s = 0; s < 8; s++) {
+        cv::Mat binary = make_random_mask(sizes[s].height, sizes[s].width, densities[s % 4], 5, rng);
+        for (int connectivity : {4, 8}) {
+            labeller.label(binary, components, connectivity);
+            cv::Mat labels, expected, stats, centroids;
+            labeller.labels(binary.size(), labels);
+            int n = cv::connectedComponentsWithStats(binary, expected, stats, centroids, connectivity, CV_32S);
+            if ((int)components.size() != n - 1) {
+                cout << sizes[s].width << "x" << sizes[s].height << ": 连通域 " << components.size()
+                     << " 个，OpenCV " << n - 1 << " 个" << endl;
+                return false;
+            }
+
+            // 8 连通时 OpenCV 的编号顺序不同，用第一个像素所在的标签对应起来
+            for (size_t i = 0; i < components.size(); i++) {
+                const ccl::Component& c = components[i];
+                const bitmask::Run* first = nullptr;
+                for (size_t r = 0; r < labeller.runs().size() && !first; r++) {
+                    if (labeller.runComponents()[r] == (int)i) first = &labeller.runs()[r];
+                }
+                int j = expected.at<int>(first->y, first->begin);
+                cv::Mat mask = expected == j;
+                cv::Moments m = cv::moments(mask, true);
+                bool same = c.area == stats.at<int>(j, cv::CC_STAT_AREA) &&
+                            c.bbox == cv::Rect(stats.at<int>(j, cv::CC_STAT_LEFT), stats.at<int>(j, cv::CC_STAT_TOP),
+                                               stats.at<int>(j, cv::CC_STAT_WIDTH), stats.at<int>(j, cv::CC_STAT_HEIGHT)) &&
+                            c.m10 == (int64_t)m.m10 && c.m01 == (int64_t)m.m01 && c.m20 == (int64_t)m.m20 &&
+                            c.m11 == (int64_t)m.m11 && c.m02 == (int64_t)m.m02 &&
+                            cv::countNonZero(mask != (labels == (int)i + 1)) == 0;
+                if (!same) {
+                    cout << sizes[s].width << "x" << sizes[s].height << ", " << connectivity << " 连通: 第 " << i
+                         << " 个连通域的统计或标签与 OpenCV 不一致" << endl;
+                    return false;
+                }
+            }
+
+            // 位图提取的行程直接标记，结果相同
+            bitmask::BitMask mask;
+            std::vector<bitmask::Run> runs;
+            bitmask::fromMat(binary, mask);
+            bitmask::extractRuns(mask, runs);
+            run_labeller.label(runs, binary.rows, from_runs, connectivity);
+            bool same = from_runs.size() == components.size();
+            for (size_t i = 0; same && i < from_runs.size(); i++) {
+                same = from_runs[i].area == components[i].area && from_runs[i].bbox == components[i].bbox &&
+                       from_runs[i].m11 == components[i].m11;
+            }
+            if (!same) {
+                cout << sizes[s].width << "x" << sizes[s].height << ": 从行程标记的结果不一致" << endl;
+                return false;
+            }
+        }
+
+        // 只保留面积不小于 5 的连通域
+        std::vector<uchar> keep(components.size());
+        for (size_t i = 0; i < components.size(); i++) keep[i] = components[i].area >= 5;
+        cv::Mat painted, labels;
+        labeller.paint(keep, binary.size(), painted);
+        labeller.labels(binary.size(), labels);
+        int expected_pixels = 0;
+        for (size_t i = 0; i < components.size(); i++) expected_pixels += keep[i] ? components[i].area : 0;
+        if (cv::countNonZero(painted) != expected_pixels || cv::countNonZero(painted & (labels == 0)) != 0) {
+            cout << sizes[s].width << "x" << sizes[s].height << ": 按连通域重画的二值图不对" << endl;
+            return false;
+        }
+        cout << sizes[s].width << "x" << sizes[s].height << ": " << components.size()
+             << " 个连通域，标签、面积、外接框、矩与 OpenCV 一致" << endl;
+    }
+    return true;
+}
+
+bool bench_ccl() {
+    cv::RNG rng(12345);
+    const cv::Size sizes[] = {cv::Size(640, 480), cv::Size(1280, 1024), cv::Size(1920, 1080)};
+    const int blob_counts[] = {10, 100, 1000};
+    ccl::Labeller labeller;
+    std::vector<ccl::Component> components;
+    std::vector<std::vector<cv::Point>> contours;
+    cv::Mat labels, stats, centroids;
+
+    for (const auto& size : sizes) {
+        for (int blobs : blob_counts) {
+            // 大小不一的倾斜实心条和圆斑，类似阈值后的灯条和光斑
+            cv::Mat binary(size, CV_8UC1, cv::Scalar(0));
+            for (int i = 0; i < blobs; i++) {
+                cv::Point c(rng.uniform(0, size.width), rng.uniform(0, size.height));
+                cv::Size axes(rng.uniform(2, 20), rng.uniform(2, 40));
+                cv::ellipse(binary, c, axes, rng.uniform(0, 180), 0, 360, cv::Scalar(255), -1);
+            }
+            const int iterations = 30;
+            int kept_contours = 0, kept_components = 0;
+
+            int64 t0 = cv::getTickCount();
+            for (int it = 0; it < iterations; it++) {
+                // 原来的做法：提取轮廓点，每个轮廓再算面积和最小外接矩形
+                cv::findContours(binary, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+                kept_contours = 0;
+                for (const auto& contour : contours) {
+                    if (cv::contourArea(contour) < 100) continue;
+                    cv::RotatedRect rect = cv::minAreaRect(contour);
+                    if (std::max(rect.size.width, rect.size.height) > 2 * std::min(rect.size.width, rect.size.height)) {
+                        kept_contours++;
+                    }
+                }
+            }
+            int64 t1 = cv::getTickCount();
+            for (int it = 0; it < iterations; it++) {
+                cv::connectedComponentsWithStats(binary, labels, stats, centroids, 8, CV_32S);
+            }
+            int64 t2 = cv::getTickCount();
+            for (int it = 0; it < iterations; it++) {
+                labeller.label(binary, components);
+                kept_components = 0;
+                for (const auto& c : components) {
+                    if (c.area >= 100 && c.elongation() > 2.0) {
+                        c.equivalentRect();
+                        kept_components++;
+                    }
+                }
+            }
+            int64 t3 = cv::getTickCount();
+
+            double contour_ms = (t1 - t0) * 1000.0 / cv::getTickFrequency() / iterations;
+            double cc_ms = (t2 - t1) * 1000.0 / cv::getTickFrequency() / iterations;
+            double ccl_ms = (t3 - t2) * 1000.0 / cv::getTickFrequency() / iterations;
+            cout << size.width << "x" << size.height << ", " << blobs << " 个斑块 (" << components.size()
+                 << " 个连通域): 轮廓 + contourArea + minAreaRect " << contour_ms << " ms (" << kept_contours
+                 << " 根), connectedComponentsWithStats " << cc_ms << " ms, 行程标记 + 统计 " << ccl_ms
+                 << " ms (" << kept_components << " 根), 相对轮廓加速 " << contour_ms / ccl_ms << "x" << endl;
+        }
+    }
+    return true;
+}
+
+bool test_leaf_contours() {
+    cv::RNG rng(20241221);
+    const cv::Size sizes[] = {cv::Size(1, 1), cv::Size(30, 2), cv::Size(2, 30), cv::Size(64, 63),
+                              cv::Size(65, 64), cv::Size(17, 130), cv::Size(301, 200), cv::Size(640, 257)};
+    const double densities[] = {0.05, 0.3, 0.5, 0.7};
+    ccl::LeafContours leaves;
+    vector<vector<cv::Point>> contours, all;
+    vector<cv::Vec4i> hierarchy;
 
+    for (int round = 0; round < 3; round++) {
+        for (int s = 0; s < 8; s++) {
+            cv::Mat binary = make_random_mask(sizes[s].height, sizes[s].width, densities[(s + round) % 4], 5, rng);
+            leaves.find(binary, contours);
+
+            cv::findContours(binary, all, hierarchy, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
+            vector<vector<cv::Point>> expected;
+            for (size_t i = 0; i < all.size(); i++) {
+                if (hierarchy[i][2] == -1) expected.push_back(all[i]);
+            }
+            if (leaves.borderCount() != (int)all.size() || sorted_contours(contours) != sorted_contours(expected)) {
+                cout << sizes[s].width << "x" << sizes[s].height << ": 最内层轮廓 " << contours.size() << " 条（共 "
+                     << leaves.borderCount() << " 条边界），RETR_TREE 筛出 " << expected.size() << " 条（共 "
+                     << all.size() << " 条）" << endl;
+                return false;
+            }
+        }
+    }
+    cout << "最内层轮廓与 RETR_TREE 中没有子轮廓的轮廓逐点一致" << endl;
+    return true;
+}
+
+bool bench_leaf_contours() {
+    cv::RNG rng(54321);
+    const cv::Size sizes[] = {cv::Size(1280, 1024), cv::Size(1920, 1080)};
+    // 噪点密度：0 是只有成块的前景，0.2 时大部分轮廓是单像素噪点和它们围出的小孔
+    const double densities[] = {0, 0.01, 0.2};
+    vector<vector<cv::Point>> all, leaf_contours;
+    vector<cv::Vec4i> hierarchy;
+
+    for (const auto& size : sizes) {
+        for (double density : densities) {
+            // 大面积杂乱前景：实心斑、圆环、环里套斑，互相重叠，嵌套层数多、外层轮廓长
+            cv::Mat noise(size, CV_8UC1);
+            rng.fill(noise, cv::RNG::UNIFORM, 0, 1000);
+            cv::Mat binary = noise < density * 1000;
+            for (int i = 0; i < 1500; i++) {
+                cv::Point c(rng.uniform(0, size.width), rng.uniform(0, size.height));
+                cv::Size axes(rng.uniform(3, 60), rng.uniform(3, 60));
+                double angle = rng.uniform(0, 180);
+                switch (rng.uniform(0, 3)) {
+                    case 0:
+                        cv::ellipse(binary, c, axes, angle, 0, 360, cv::Scalar(255), -1);
+                        break;
+                    case 1:
+                        cv::ellipse(binary, c, axes, angle, 0, 360, cv::Scalar(255), rng.uniform(2, 6));
+                        break;
+                    default:
+                        cv::ellipse(binary, c, axes, angle, 0, 360, cv::Scalar(255), 2);
+                        cv::ellipse(binary, c, cv::Size(axes.width / 3, axes.height / 3), angle, 0, 360,
+                                    cv::Scalar(255), -1);
+                        break;
+                }
+            }
+            const int iterations = 10;
+            // 每个场景用新的对象，缓冲区大小只反映这一张图；先跑一次把缓冲区分配好
+            ccl::LeafContours leaves;
+            leaves.find(binary, leaf_contours);
+
+            int64 t0 = cv::getTickCount();
+            vector<vector<cv::Point>> tree_leaves;
+            for (int it = 0; it < iterations; it++) {
+                cv::findContours(binary, all, hierarchy, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
+                tree_leaves.clear();
+                for (size_t i = 0; i < all.size(); i++) {
+                    if (hierarchy[i][2] == -1) tree_leaves.push_back(all[i]);
+                }
+            }
+            int64 t1 = cv::getTickCount();
+            for (int it = 0; it < iterations; it++) {
+                leaves.find(binary, leaf_contours);
+            }
+            int64 t2 = cv::getTickCount();
+
+            // 内存：全树是所有轮廓的点列加层次结构；叶子模式是叶子的点列加内部缓冲区（行程表、拼图等）。
+            // 两边 findContours 内部的临时内存都不计
+            size_t tree_points = 0, leaf_points = 0;
+            for (const auto& c : all) tree_points += c.size();
+            for (const auto& c : leaf_contours) leaf_points += c.size();
+            const size_t tree_bytes = tree_points * sizeof(cv::Point) + all.size() * sizeof(vector<cv::Point>) +
+                                      hierarchy.size() * sizeof(cv::Vec4i);
+            const size_t leaf_bytes = leaf_points * sizeof(cv::Point) +
+                                      leaf_contours.size() * sizeof(vector<cv::Point>) + leaves.bufferBytes();
+
+            double tree_ms = (t1 - t0) * 1000.0 / cv::getTickFrequency() / iterations;
+            double leaf_ms = (t2 - t1) * 1000.0 / cv::getTickFrequency() / iterations;
+            cout << size.width << "x" << size.height << ", 噪点密度 " << density << ": " << all.size() << " 条轮廓 ("
+                 << tree_points << " 点) 中 " << leaf_contours.size() << " 条最内层 (" << leaf_points << " 点)"
+                 << (sorted_contours(leaf_contours) == sorted_contours(tree_leaves) ? "" : "，结果不一致！") << endl
+                 << "    RETR_TREE + 筛选 " << tree_ms << " ms, " << tree_bytes / 1024 << " KB; 只取叶子 " << leaf_ms
+                 << " ms, " << leaf_bytes / 1024 << " KB (其中缓冲区 " << leaves.bufferBytes() / 1024
+                 << " KB); 时间 " << tree_ms / leaf_ms << "x" << endl;
+        }
+    }
     return true;
-}
\ No newline at end of file
+}
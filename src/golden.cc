@@ -0,0 +1,109 @@
+#include "golden.h"
+#include "log.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+namespace golden {
+
+// 多通道图像按像素取各通道的最大值，得到单通道图
+static cv::Mat channel_max(const cv::Mat& m) {
+    if (m.channels() == 1) return m;
+    cv::Mat src = m.isContinuous() ? m : m.clone();
+    cv::Mat reduced;
+    cv::reduce(src.reshape(1, (int)src.total()), reduced, 1, cv::REDUCE_MAX);
+    return reduced.reshape(1, m.rows);
+}
+
+DiffStats compare(const cv::Mat& actual, const cv::Mat& expected, double tolerance) {
+    DiffStats stats;
+    stats.comparable = !actual.empty() && actual.size() == expected.size() && actual.type() == expected.type();
+    if (!stats.comparable) {
+        stats.max_diff = stats.mean_diff = std::numeric_limits<double>::infinity();
+        stats.over_fraction = 1;
+        stats.over_count = (int)std::max(actual.total(), expected.total());
+        stats.psnr = 0;
+        stats.iou = 0;
+        return stats;
+    }
+
+    cv::Mat diff;
+    cv::absdiff(actual, expected, diff);
+    cv::Mat diff_max = channel_max(diff);
+    cv::minMaxLoc(diff_max, nullptr, &stats.max_diff);
+    stats.mean_diff = cv::mean(diff_max)[0];
+    stats.over_count = cv::countNonZero(diff_max > tolerance);
+    stats.over_fraction = (double)stats.over_count / diff_max.total();
+
+    // 峰值按 8 位图像的 255 计算
+    double mse = cv::norm(actual, expected, cv::NORM_L2SQR) / ((double)actual.total() * actual.channels());
+    stats.psnr = mse == 0 ? std::numeric_limits<double>::infinity() : 10 * std::log10(255.0 * 255.0 / mse);
+    stats.iou = mask_iou(actual, expected);
+    return stats;
+}
+
+bool passes(const DiffStats& stats, const Tolerance& tolerance) {
+    return stats.comparable &&
+           stats.over_fraction <= tolerance.max_over_fraction &&
+           stats.psnr >= tolerance.min_psnr &&
+           stats.iou >= tolerance.min_iou;
+}
+
+bool check(const char* name, const cv::Mat& actual, const cv::Mat& expected, const Tolerance& tolerance) {
+    DiffStats stats = compare(actual, expected, tolerance.pixel);
+    if (!stats.comparable) {
+        LOG_ERROR("%s: 和答案的尺寸或类型不一致 (%dx%d, type %d / %dx%d, type %d)", name,
+                  actual.cols, actual.rows, actual.type(), expected.cols, expected.rows, expected.type());
+        return false;
+    }
+
+    bool ok = passes(stats, tolerance);
+    LOG_MSG("%s: 最大差 %.0f, 平均差 %.3f, 超过 %.0f 的像素 %.3f%%, PSNR %.2f dB, IoU %.4f -> %s",
+            name, stats.max_diff, stats.mean_diff, tolerance.pixel, stats.over_fraction * 100,
+            stats.psnr, stats.iou, ok ? "通过" : "不通过");
+    if (!ok) {
+        cv::Mat diff;
+        cv::absdiff(actual, expected, diff);
+        diff = channel_max(diff);
+        cv::normalize(diff, diff, 0, 255, cv::NORM_MINMAX, CV_8U);
+        std::string path = std::string("golden_diff_") + name + ".png";
+        cv::imwrite(path, diff);
+        LOG_WARN("差异图已保存为 %s", path.c_str());
+    }
+    return ok;
+}
+
+double mask_iou(const cv::Mat& a, const cv::Mat& b, int dilate) {
+    if (a.empty() || a.size() != b.size()) return 0;
+
+    cv::Mat fa = channel_max(a) > 127;
+    cv::Mat fb = channel_max(b) > 127;
+    if (dilate > 0) {
+        cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * dilate + 1, 2 * dilate + 1));
+        cv::dilate(fa, fa, kernel);
+        cv::dilate(fb, fb, kernel);
+    }
+    int inter = cv::countNonZero(fa & fb);
+    int uni = cv::countNonZero(fa | fb);
+    return uni ? (double)inter / uni : 1.0;
+}
+
+double rect_iou(const cv::Rect& a, const cv::Rect& b) {
+    double inter = (a & b).area();
+    double uni = a.area() + b.area() - inter;
+    return uni > 0 ? inter / uni : 0;
+}
+
+double rotated_rect_iou(const cv::RotatedRect& a, const cv::RotatedRect& b) {
+    std::vector<cv::Point2f> region, hull;
+    if (cv::rotatedRectangleIntersection(a, b, region) == cv::INTERSECT_NONE || region.size() < 3) {
+        return 0;
+    }
+    cv::convexHull(region, hull);
+    double inter = cv::contourArea(hull);
+    double uni = a.size.area() + b.size.area() - inter;
+    return uni > 0 ? inter / uni : 0;
+}
+
+} // namespace golden
@@ -1,7 +1,9 @@
 #include "impls.h"
-#include <iostream>
+#include "trace.h"
+#include "log.h"
 
 std::pair<cv::Rect, cv::RotatedRect> get_rect_by_contours(const cv::Mat& input) {
+    TRACE_SCOPE("get_rect_by_contours");
     std::pair<cv::Rect, cv::RotatedRect> res;
     
     // ========== 第一步：图像预处理 ==========
@@ -22,7 +24,7 @@ std::pair<cv::Rect, cv::RotatedRect> get_rect_by_contours(const cv::Mat& input)
     
     // ========== 调试：保存二值化图像 ==========
     cv::imwrite("debug_binary.jpg", binary);
-    std::cout << "二值化图像已保存为 debug_binary.jpg" << std::endl;
+    LOG_MSG("二值化图像已保存为 debug_binary.jpg");
     
     // ========== 第二步：轮廓检测 ==========
     std::vector<std::vector<cv::Point>> contours;
@@ -31,11 +33,11 @@ std::pair<cv::Rect, cv::RotatedRect> get_rect_by_contours(const cv::Mat& input)
     // 尝试使用 RETR_LIST 而不是 RETR_EXTERNAL
     cv::findContours(binary, contours, hierarchy, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
     
-    std::cout << "找到轮廓数量: " << contours.size() << std::endl;
+    LOG_MSG("找到轮廓数量: %zu", contours.size());
     
     // ========== 第三步：筛选矩形轮廓 ==========
     if (contours.empty()) {
-        std::cout << "没有找到任何轮廓" << std::endl;
+        LOG_MSG("没有找到任何轮廓");
         return res;
     }
     
@@ -44,18 +46,18 @@ std::pair<cv::Rect, cv::RotatedRect> get_rect_by_contours(const cv::Mat& input)
     for (size_t i = 0; i < contours.size(); i++) {
         const auto& contour = contours[i];
         double area = cv::contourArea(contour);
-        std::cout << "轮廓 " << i << " 面积: " << area << std::endl;
+        LOG_MSG("轮廓 %zu 面积: %g", i, area);
         
         // 忽略太小的轮廓
         if (area < 100) {
-            std::cout << "轮廓 " << i << " 太小，跳过" << std::endl;
+            LOG_MSG("轮廓 %zu 太小，跳过", i);
             continue;
         }
         
         // 排除边框轮廓
         double image_area = input.rows * input.cols;
         if (area > image_area * 0.95) {
-            std::cout << "轮廓 " << i << " 太大，可能是边框，跳过" << std::endl;
+            LOG_MSG("轮廓 %zu 太大，可能是边框，跳过", i);
             continue;
         }
         
@@ -64,7 +66,7 @@ std::pair<cv::Rect, cv::RotatedRect> get_rect_by_contours(const cv::Mat& input)
         if (bbox.x <= margin || bbox.y <= margin ||
             bbox.x + bbox.width >= input.cols - margin ||
             bbox.y + bbox.height >= input.rows - margin) {
-            std::cout << "轮廓 " << i << " 太接近边界，跳过" << std::endl;
+            LOG_MSG("轮廓 %zu 太接近边界，跳过", i);
             continue;
         }
         
@@ -72,19 +74,19 @@ std::pair<cv::Rect, cv::RotatedRect> get_rect_by_contours(const cv::Mat& input)
         std::vector<cv::Point> approx;
         cv::approxPolyDP(contour, approx, 0.02 * cv::arcLength(contour, true), true);
         
-        std::cout << "轮廓 " << i << " 顶点数: " << approx.size() << std::endl;
+        LOG_MSG("轮廓 %zu 顶点数: %zu", i, approx.size());
         
         // 检查是否是四边形
         if (approx.size() == 4) {
-            std::cout << "轮廓 " << i << " 是四边形，添加到候选列表" << std::endl;
+            LOG_MSG("轮廓 %zu 是四边形，添加到候选列表", i);
             rectangle_contours.push_back(contour);
         }
     }
     
-    std::cout << "筛选后矩形轮廓数量: " << rectangle_contours.size() << std::endl;
+    LOG_MSG("筛选后矩形轮廓数量: %zu", rectangle_contours.size());
     
     if (rectangle_contours.empty()) {
-        std::cout << "没有找到合适的矩形轮廓" << std::endl;
+        LOG_MSG("没有找到合适的矩形轮廓");
         return res;
     }
     
@@ -98,8 +100,8 @@ std::pair<cv::Rect, cv::RotatedRect> get_rect_by_contours(const cv::Mat& input)
     cv::Rect bounding_rect = cv::boundingRect(*largest_rectangle);
     cv::RotatedRect min_area_rect = cv::minAreaRect(*largest_rectangle);
     
-    std::cout << "选择的矩形位置: x=" << bounding_rect.x << ", y=" << bounding_rect.y 
-              << ", w=" << bounding_rect.width << ", h=" << bounding_rect.height << std::endl;
+    LOG_MSG("选择的矩形位置: x=%d, y=%d, w=%d, h=%d",
+            bounding_rect.x, bounding_rect.y, bounding_rect.width, bounding_rect.height);
     
     res.first = bounding_rect;
     res.second = min_area_rect;
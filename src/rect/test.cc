@@ -1,5 +1,6 @@
 #include "impls.h"
 #include "utils.h"
+#include "golden.h"
 
 
 bool test_get_rect_by_contours() {
@@ -10,6 +11,23 @@ bool test_get_rect_by_contours() {
     cv::Rect rect = output.first;
     cv::RotatedRect rrect = output.second;
 
+    if (is_headless()) {
+        // 从答案图的线条还原出矩形，再和输出的矩形比较 IoU
+        cv::Mat rect_ans = cv::imread("../assets/rect/answer_rect.jpg", cv::IMREAD_GRAYSCALE);
+        cv::Mat rrect_ans = cv::imread("../assets/rect/answer_rrect.jpg", cv::IMREAD_GRAYSCALE);
+        std::vector<cv::Point> rect_pts, rrect_pts;
+        cv::findNonZero(rect_ans > 127, rect_pts);
+        cv::findNonZero(rrect_ans > 127, rrect_pts);
+        if (rect_pts.empty() || rrect_pts.empty()) {
+            std::cout << "答案图像读取失败" << std::endl;
+            return false;
+        }
+        double rect_iou = golden::rect_iou(rect, cv::boundingRect(rect_pts));
+        double rrect_iou = golden::rotated_rect_iou(rrect, cv::minAreaRect(rrect_pts));
+        std::cout << "外接矩形 IoU: " << rect_iou << ", 最小外接矩形 IoU: " << rrect_iou << std::endl;
+        return rect_iou >= 0.85 && rrect_iou >= 0.85;
+    }
+
     cv::Mat rect_ans = cv::imread("../assets/rect/answer_rect.jpg");
     cv::imshow("<test_get_rect_by_contours> 正确的答案", rect_ans);
     cv::imshow("<test_get_rect_by_contours> 你的答案", show_rectangle(rect, input.rows, input.cols));
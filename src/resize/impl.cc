@@ -1,99 +1,487 @@
 #include "impls.h"
+#include "cpu_features.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * 放大（或一边放大）用双线性插值，两边都缩小时用区域平均，和 cv::resize 的
+ * INTER_LINEAR / INTER_AREA 对应。
+ *
+ * 双线性插值分两步：先把用到的源行在水平方向插值成中间行，再把上下两行在竖直方向
+ * 插值成输出行。相邻输出行大多共用源行，水平插值的结果缓存两行复用。8 位图像的
+ * 中间行和系数是定点整数，竖直插值用 SSE2 / AVX2 向量化；16 位和浮点图像用 float。
+ *
+ * 取样位置、系数在调用开始时按列、按行算成表，内层循环只查表，不再做浮点坐标计算。
+ * 元素类型和通道数都是模板参数，每次调用只分派一次，内层循环里没有按类型、通道数的分支。
+ *
+ * 缩小整数倍时每个输出像素就是一个整块的平均，直接求和。
+ *
+ * 输出行分成若干条带交给 cv::parallel_for_，每条带有自己的行缓存，表是只读共享的。
+ * 条带函数里的循环边界都是局部变量，不从 lambda 按引用捕获，否则 8 位输出的写入
+ * 可能和捕获的变量重叠，编译器不敢向量化。
+ */
+
+namespace {
+
+// 定点系数的小数位数，和 OpenCV 的 INTER_RESIZE_COEF_BITS 相同
+const int kCoefBits = 11;
+const int kCoefScale = 1 << kCoefBits;
+
+// 整数倍缩小时块内元素个数的上限：16 位图像的块和用 int 累加，不超过 65535 * 256 < 2^24，
+// 求平均时转成 float 乘 1 / area 也没有舍入
+const int kMaxIntegerArea = 256;
+
+// 各元素类型的中间类型。WT: 水平插值的结果，AT: 插值系数，ST: 整数倍缩小时的块和
+template <typename T>
+struct ResizeTraits {
+    typedef float WT;
+    typedef float AT;
+    typedef float ST;
+    static AT coef(float w) { return w; }
+    static T average(ST sum, float inv_area) { return cv::saturate_cast<T>(sum * inv_area); }
+};
+
+template <>
+struct ResizeTraits<uchar> {
+    typedef int WT;
+    typedef short AT;
+    typedef int ST;
+    static AT coef(float w) { return cv::saturate_cast<short>(w * kCoefScale); }
+    static uchar average(ST sum, float inv_area) { return (uchar)(int)(sum * inv_area + 0.5f); }
+};
+
+template <>
+struct ResizeTraits<ushort> {
+    typedef float WT;
+    typedef float AT;
+    typedef int ST;
+    static AT coef(float w) { return w; }
+    static ushort average(ST sum, float inv_area) { return (ushort)(int)(sum * inv_area + 0.5f); }
+};
+
+// 每条带至少处理的元素个数，和 cv::resize 的划分粒度相同
+double resizeStripes(const cv::Mat& dst) {
+    return std::max(1.0, dst.total() / (double)(1 << 16));
+}
+
+// 输出坐标按像素中心映射回源坐标，返回左（上）侧取样点和到它的距离
+void linearCoord(int src_len, double inv_scale, int d, int& s, float& f) {
+    double fs = (d + 0.5) * inv_scale - 0.5;
+    s = (int)std::floor(fs);
+    f = (float)(fs - s);
+    if (s < 0) {
+        s = 0;
+        f = 0;
+    }
+    if (s >= src_len - 1) {
+        s = src_len - 1;
+        f = 0;
+    }
+}
+
+template <typename AT>
+struct LinearTables {
+    std::vector<int> xofs0, xofs1;  // 每个输出像素左右两个取样像素的首个元素在源行里的下标
+    std::vector<AT> alpha;          // 每个输出像素两个系数，和为 1（定点时为 kCoefScale）
+    std::vector<int> yofs;          // 每个输出行上面的源行，下面一行是 min(yofs + 1, rows - 1)
+    std::vector<AT> beta;           // 每个输出行两个系数
+};
+
+template <typename T>
+void buildLinearTables(const cv::Size& src, const cv::Size& dst, int cn,
+                       LinearTables<typename ResizeTraits<T>::AT>& t) {
+    typedef ResizeTraits<T> Traits;
+    const double inv_x = (double)src.width / dst.width;
+    const double inv_y = (double)src.height / dst.height;
+    // 两个系数的和：定点时是 kCoefScale，浮点时是 1
+    const typename Traits::AT one = Traits::coef(1.f);
+
+    t.xofs0.resize(dst.width);
+    t.xofs1.resize(dst.width);
+    t.alpha.resize(2 * dst.width);
+    for (int dx = 0; dx < dst.width; dx++) {
+        int sx;
+        float fx;
+        linearCoord(src.width, inv_x, dx, sx, fx);
+        t.xofs0[dx] = sx * cn;
+        t.xofs1[dx] = std::min(sx + 1, src.width - 1) * cn;
+        t.alpha[2 * dx] = Traits::coef(1.f - fx);
+        t.alpha[2 * dx + 1] = one - t.alpha[2 * dx];
+    }
+
+    t.yofs.resize(dst.height);
+    t.beta.resize(2 * dst.height);
+    for (int dy = 0; dy < dst.height; dy++) {
+        float fy;
+        linearCoord(src.height, inv_y, dy, t.yofs[dy], fy);
+        t.beta[2 * dy] = Traits::coef(1.f - fy);
+        t.beta[2 * dy + 1] = one - t.beta[2 * dy];
+    }
+}
+
+// 水平插值。8 位时结果是放大了 kCoefScale 倍的整数，最大 255 * 2048，不会溢出
+template <typename T, int CN, typename WT, typename AT>
+void hresizeLinear(const T* __restrict src, WT* __restrict dst, int width,
+                   const int* xofs0, const int* xofs1, const AT* alpha) {
+    for (int dx = 0; dx < width; dx++, dst += CN) {
+        const T* s0 = src + xofs0[dx];
+        const T* s1 = src + xofs1[dx];
+        const WT a0 = alpha[2 * dx], a1 = alpha[2 * dx + 1];
+        for (int c = 0; c < CN; c++) {
+            dst[c] = s0[c] * a0 + s1[c] * a1;
+        }
+    }
+}
+
+// 竖直插值。先右移 4 位让行数据放进 16 位，乘系数取高 16 位，最后带舍入右移 2 位，
+// 总共去掉 2 * kCoefBits 位。标量和向量版本逐位一致。
+inline uchar vlerp(int r0, int r1, int b0, int b1) {
+    return (uchar)(((((r0 >> 4) * b0) >> 16) + (((r1 >> 4) * b1) >> 16) + 2) >> 2);
+}
+
+#ifdef __SSE2__
+// 返回处理到的位置，剩下的交给标量循环
+int vresizeLinearSSE2(const int* r0, const int* r1, uchar* dst, int b0, int b1, int k, int len) {
+    const __m128i vb0 = _mm_set1_epi16((short)b0);
+    const __m128i vb1 = _mm_set1_epi16((short)b1);
+    const __m128i round = _mm_set1_epi16(2);
+    for (; k + 16 <= len; k += 16) {
+        __m128i s0lo = _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128((const __m128i*)(r0 + k)), 4),
+                                       _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(r0 + k + 4)), 4));
+        __m128i s0hi = _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128((const __m128i*)(r0 + k + 8)), 4),
+                                       _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(r0 + k + 12)), 4));
+        __m128i s1lo = _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128((const __m128i*)(r1 + k)), 4),
+                                       _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(r1 + k + 4)), 4));
+        __m128i s1hi = _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128((const __m128i*)(r1 + k + 8)), 4),
+                                       _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(r1 + k + 12)), 4));
+        __m128i lo = _mm_add_epi16(_mm_mulhi_epi16(s0lo, vb0), _mm_mulhi_epi16(s1lo, vb1));
+        __m128i hi = _mm_add_epi16(_mm_mulhi_epi16(s0hi, vb0), _mm_mulhi_epi16(s1hi, vb1));
+        lo = _mm_srai_epi16(_mm_add_epi16(lo, round), 2);
+        hi = _mm_srai_epi16(_mm_add_epi16(hi, round), 2);
+        _mm_storeu_si128((__m128i*)(dst + k), _mm_packus_epi16(lo, hi));
+    }
+    return k;
+}
+#endif
+
+#ifdef CPU_AVX2_DISPATCH
+__attribute__((target("avx2")))
+inline __m256i loadShifted(const int* p) {
+    return _mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)p), 4);
+}
+
+// AVX2 的 pack 在两个 128 位通道内各自进行，打包后用 permute4x64 恢复元素顺序
+__attribute__((target("avx2")))
+int vresizeLinearAVX2(const int* r0, const int* r1, uchar* dst, int b0, int b1, int k, int len) {
+    const __m256i vb0 = _mm256_set1_epi16((short)b0);
+    const __m256i vb1 = _mm256_set1_epi16((short)b1);
+    const __m256i round = _mm256_set1_epi16(2);
+    for (; k + 32 <= len; k += 32) {
+        __m256i s0lo = _mm256_permute4x64_epi64(
+            _mm256_packs_epi32(loadShifted(r0 + k), loadShifted(r0 + k + 8)), 0xD8);
+        __m256i s0hi = _mm256_permute4x64_epi64(
+            _mm256_packs_epi32(loadShifted(r0 + k + 16), loadShifted(r0 + k + 24)), 0xD8);
+        __m256i s1lo = _mm256_permute4x64_epi64(
+            _mm256_packs_epi32(loadShifted(r1 + k), loadShifted(r1 + k + 8)), 0xD8);
+        __m256i s1hi = _mm256_permute4x64_epi64(
+            _mm256_packs_epi32(loadShifted(r1 + k + 16), loadShifted(r1 + k + 24)), 0xD8);
+        __m256i lo = _mm256_add_epi16(_mm256_mulhi_epi16(s0lo, vb0), _mm256_mulhi_epi16(s1lo, vb1));
+        __m256i hi = _mm256_add_epi16(_mm256_mulhi_epi16(s0hi, vb0), _mm256_mulhi_epi16(s1hi, vb1));
+        lo = _mm256_srai_epi16(_mm256_add_epi16(lo, round), 2);
+        hi = _mm256_srai_epi16(_mm256_add_epi16(hi, round), 2);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+        _mm256_storeu_si256((__m256i*)(dst + k), packed);
+    }
+    return k;
+}
+#endif
+
+// 8 位图像的竖直插值，和下面的通用版本是重载关系
+void vresizeLinear(const int* r0, const int* r1, uchar* dst, short b0, short b1, int len) {
+    int k = 0;
+#ifdef CPU_AVX2_DISPATCH
+    if (cpuHasAVX2()) {
+        k = vresizeLinearAVX2(r0, r1, dst, b0, b1, k, len);
+    }
+#endif
+#ifdef __SSE2__
+    k = vresizeLinearSSE2(r0, r1, dst, b0, b1, k, len);
+#endif
+    for (; k < len; k++) {
+        dst[k] = vlerp(r0[k], r1[k], b0, b1);
+    }
+}
+
+template <typename T, typename WT, typename AT>
+void vresizeLinear(const WT* r0, const WT* r1, T* dst, AT b0, AT b1, int len) {
+    for (int k = 0; k < len; k++) {
+        dst[k] = cv::saturate_cast<T>(r0[k] * b0 + r1[k] * b1);
+    }
+}
+
+// 计算一条带 [range.start, range.end) 的输出行。条带开头的一两行源行和上一条带
+// 重复做水平插值，换来条带之间没有依赖
+template <typename T, int CN>
+void resizeLinearBand(const cv::Mat& src, cv::Mat& dst,
+                      const LinearTables<typename ResizeTraits<T>::AT>& t, const cv::Range& range) {
+    typedef typename ResizeTraits<T>::WT WT;
+    const int len = dst.cols * CN;
+
+    // 两行水平插值结果的缓存，cached 记录各自对应的源行
+    std::vector<WT> rows(2 * len);
+    WT* buf[2] = {rows.data(), rows.data() + len};
+    int cached[2] = {-1, -1};
+    // 取得源行 sy 的水平插值结果，不覆盖这一输出行还要用的源行 keep
+    auto fetch = [&](int sy, int keep) -> const WT* {
+        for (int i = 0; i < 2; i++) {
+            if (cached[i] == sy) return buf[i];
+        }
+        int slot = cached[0] == keep ? 1 : 0;
+        hresizeLinear<T, CN>(src.ptr<T>(sy), buf[slot], dst.cols, t.xofs0.data(), t.xofs1.data(), t.alpha.data());
+        cached[slot] = sy;
+        return buf[slot];
+    };
+
+    for (int dy = range.start; dy < range.end; dy++) {
+        int sy0 = t.yofs[dy];
+        int sy1 = std::min(sy0 + 1, src.rows - 1);
+        const WT* r0 = fetch(sy0, sy1);
+        const WT* r1 = fetch(sy1, sy0);
+        vresizeLinear(r0, r1, dst.ptr<T>(dy), t.beta[2 * dy], t.beta[2 * dy + 1], len);
+    }
+}
+
+template <typename T, int CN>
+void resizeLinear(const cv::Mat& src, cv::Mat& dst) {
+    LinearTables<typename ResizeTraits<T>::AT> t;
+    buildLinearTables<T>(src.size(), dst.size(), CN, t);
+    cv::parallel_for_(cv::Range(0, dst.rows), [&](const cv::Range& range) {
+        resizeLinearBand<T, CN>(src, dst, t, range);
+    }, resizeStripes(dst));
+}
+
+// 区域平均的表：输出像素 d 由源像素 index[begin[d]] .. index[begin[d + 1] - 1]
+// 按 weight 加权平均，权重和为 1
+struct AreaTable {
+    std::vector<int> begin;
+    std::vector<int> index;
+    std::vector<float> weight;
+};
+
+// 和 OpenCV 的 computeResizeAreaTab 相同：每个输出像素覆盖 [d * scale, (d + 1) * scale)，
+// 两端不完整覆盖的源像素按覆盖长度计权
+void buildAreaTable(int src_len, int dst_len, AreaTable& t) {
+    const double scale = (double)src_len / dst_len;
+    t.begin.assign(1, 0);
+    t.index.clear();
+    t.weight.clear();
+    for (int d = 0; d < dst_len; d++) {
+        double fs1 = d * scale, fs2 = fs1 + scale;
+        double cell = std::min(scale, src_len - fs1);
+        int s1 = (int)std::ceil(fs1), s2 = (int)std::floor(fs2);
+        s2 = std::min(s2, src_len - 1);
+        s1 = std::min(s1, s2);
+
+        if (s1 - fs1 > 1e-3) {
+            t.index.push_back(s1 - 1);
+            t.weight.push_back((float)((s1 - fs1) / cell));
+        }
+        for (int s = s1; s < s2; s++) {
+            t.index.push_back(s);
+            t.weight.push_back((float)(1.0 / cell));
+        }
+        if (fs2 - s2 > 1e-3) {
+            t.index.push_back(s2);
+            t.weight.push_back((float)(std::min(std::min(fs2 - s2, 1.0), cell) / cell));
+        }
+        t.begin.push_back((int)t.index.size());
+    }
+}
+
+template <typename T, int CN>
+void hresizeArea(const T* src, float* dst, int width, const AreaTable& t) {
+    for (int dx = 0; dx < width; dx++, dst += CN) {
+        // 在寄存器里累加，不反复读写 dst
+        float acc[CN] = {};
+        for (int i = t.begin[dx]; i < t.begin[dx + 1]; i++) {
+            const T* s = src + t.index[i] * CN;
+            const float w = t.weight[i];
+            for (int c = 0; c < CN; c++) {
+                acc[c] += s[c] * w;
+            }
+        }
+        for (int c = 0; c < CN; c++) {
+            dst[c] = acc[c];
+        }
+    }
+}
+
+template <typename T, int CN>
+void resizeAreaBand(const cv::Mat& src, cv::Mat& dst, const AreaTable& xt, const AreaTable& yt,
+                    const cv::Range& range) {
+    const int len = dst.cols * CN;
+    // 相邻两个输出行会共用边界上的源行，hrow 缓存最近一次的水平平均结果
+    std::vector<float> hrow(len), sum(len);
+    int cached = -1;
+    for (int dy = range.start; dy < range.end; dy++) {
+        std::fill(sum.begin(), sum.end(), 0.f);
+        for (int i = yt.begin[dy]; i < yt.begin[dy + 1]; i++) {
+            const int sy = yt.index[i];
+            if (sy != cached) {
+                hresizeArea<T, CN>(src.ptr<T>(sy), hrow.data(), dst.cols, xt);
+                cached = sy;
+            }
+            const float w = yt.weight[i];
+            for (int k = 0; k < len; k++) {
+                sum[k] += hrow[k] * w;
+            }
+        }
+        T* out = dst.ptr<T>(dy);
+        for (int k = 0; k < len; k++) {
+            out[k] = cv::saturate_cast<T>(sum[k]);
+        }
+    }
+}
+
+template <typename T, int CN>
+void resizeArea(const cv::Mat& src, cv::Mat& dst) {
+    AreaTable xt, yt;
+    buildAreaTable(src.cols, dst.cols, xt);
+    buildAreaTable(src.rows, dst.rows, yt);
+    cv::parallel_for_(cv::Range(0, dst.rows), [&](const cv::Range& range) {
+        resizeAreaBand<T, CN>(src, dst, xt, yt, range);
+    }, resizeStripes(dst));
+}
+
+// 一行按 kx 个像素一组求和，原地写回 colsum 的前 width * CN 个元素（写的位置
+// 总在还没读到的位置之前）。kx 为 0 时用运行时的 kx_rt，常见的 2、4 倍在编译时展开
+template <typename ST, int CN, int KX>
+void hsumAreaInteger(ST* colsum, int width, int kx_rt) {
+    const int kx = KX ? KX : kx_rt;
+    const ST* s = colsum;
+    for (int dx = 0; dx < width; dx++, s += kx * CN) {
+        ST acc[CN] = {};
+        for (int i = 0; i < kx; i++) {
+            for (int c = 0; c < CN; c++) {
+                acc[c] += s[i * CN + c];
+            }
+        }
+        for (int c = 0; c < CN; c++) {
+            colsum[dx * CN + c] = acc[c];
+        }
+    }
+}
+
+// 缩小整数倍时每个输出像素正好是 kx * ky 块的平均，直接求和，不需要表。
+// 先把 ky 行逐元素加成一行，再在这一行上按 kx 个像素一组求和，最后统一除以面积；
+// 第一步和最后一步都是连续的逐元素运算，可以被编译器向量化
+template <typename T, int CN>
+void resizeAreaIntegerBand(const cv::Mat& src, cv::Mat& dst, int kx, int ky, const cv::Range& range) {
+    typedef ResizeTraits<T> Traits;
+    typedef typename Traits::ST ST;
+    const int src_len = src.cols * CN;
+    const int len = dst.cols * CN;
+    const float inv_area = 1.f / (kx * ky);
+
+    std::vector<ST> colsum(src_len);
+    for (int dy = range.start; dy < range.end; dy++) {
+        const T* s = src.ptr<T>(dy * ky);
+        for (int k = 0; k < src_len; k++) {
+            colsum[k] = s[k];
+        }
+        for (int j = 1; j < ky; j++) {
+            s = src.ptr<T>(dy * ky + j);
+            for (int k = 0; k < src_len; k++) {
+                colsum[k] += s[k];
+            }
+        }
+
+        switch (kx) {
+            case 2: hsumAreaInteger<ST, CN, 2>(colsum.data(), dst.cols, kx); break;
+            case 4: hsumAreaInteger<ST, CN, 4>(colsum.data(), dst.cols, kx); break;
+            default: hsumAreaInteger<ST, CN, 0>(colsum.data(), dst.cols, kx); break;
+        }
+
+        T* out = dst.ptr<T>(dy);
+        for (int k = 0; k < len; k++) {
+            out[k] = Traits::average(colsum[k], inv_area);
+        }
+    }
+}
+
+template <typename T, int CN>
+void resizeAreaInteger(const cv::Mat& src, cv::Mat& dst, int kx, int ky) {
+    cv::parallel_for_(cv::Range(0, dst.rows), [&](const cv::Range& range) {
+        resizeAreaIntegerBand<T, CN>(src, dst, kx, ky, range);
+    }, resizeStripes(dst));
+}
+
+template <typename T, int CN>
+void resizeDispatch(const cv::Mat& src, cv::Mat& dst) {
+    if (dst.cols < src.cols && dst.rows < src.rows) {
+        // 缩小时只取四个点会混叠，改为对覆盖的源像素求平均
+        int kx = src.cols / dst.cols, ky = src.rows / dst.rows;
+        if (kx * dst.cols == src.cols && ky * dst.rows == src.rows && kx * ky <= kMaxIntegerArea) {
+            resizeAreaInteger<T, CN>(src, dst, kx, ky);
+        } else {
+            resizeArea<T, CN>(src, dst);
+        }
+    } else {
+        resizeLinear<T, CN>(src, dst);
+    }
+}
+
+// 元素类型和通道数只在这里分派一次
+template <typename T>
+void resizeChannels(const cv::Mat& src, cv::Mat& dst) {
+    switch (src.channels()) {
+        case 1: resizeDispatch<T, 1>(src, dst); break;
+        case 2: resizeDispatch<T, 2>(src, dst); break;
+        case 3: resizeDispatch<T, 3>(src, dst); break;
+        case 4: resizeDispatch<T, 4>(src, dst); break;
+    }
+}
+
+} // namespace
 
 
 cv::Mat my_resize(const cv::Mat& input, float scale) { //原图、缩放比例
+    TRACE_SCOPE("my_resize");
     /**
      * 要求：
      *      实现resize算法，只能使用基础的语法，比如说for循环，Mat的基本操作。不能
      * 用cv::resize。resize算法的内容自行查找学习，不是很难。
-     * 
+     *
      * 提示：
      * 无。
-     * 
+     *
      * 通过条件：
      * 运行测试点，你的结果跟答案长的差不多就行。
      */
 
-    /*
-    Mat功能：
-    class Mat {
-        public:
-        // 头部信息（元数据）
-        int rows;        // 行数（图像高度）
-        int cols;        // 列数（图像宽度）
-        int type();      // 数据类型和通道数
-        int channels();  // 通道数
-        int depth();     // 数据类型深度
-    
-        // 数据指针
-        uchar* data;     // 指向实际像素数据的指针
-    
-        // 其他管理信息...
-    };
-    
-    
-    */
-
     int new_rows = input.rows * scale, new_cols = input.cols * scale;
-    // IMPLEMENT YOUR CODE HERE
-    
+    const int depth = input.depth();
+    CV_Assert((depth == CV_8U || depth == CV_16U || depth == CV_32F) && input.channels() <= 4);
+
     cv::Mat output(new_rows, new_cols, input.type());
-    
-    // 计算缩放比例 新图-->旧图
-    float scale_x = static_cast<float>(input.cols) / new_cols;
-    float scale_y = static_cast<float>(input.rows) / new_rows;
-    
-    
-    for (int y = 0; y < new_rows; y++) {
-        for (int x = 0; x < new_cols; x++) {
-            //每个像素在输入图像中的对应位置
-            float src_x = x * scale_x;
-            float src_y = y * scale_y;
-            
-            // 双线性插值
-            int x0 = static_cast<int>(src_x);
-            int y0 = static_cast<int>(src_y);
-            int x1 = x0 + 1;
-            int y1 = y0 + 1;
-            
-            // 边界检查
-            if (x1 >= input.cols) x1 = input.cols - 1;
-            if (y1 >= input.rows) y1 = input.rows - 1;
-            if (x0 >= input.cols) x0 = input.cols - 1;
-            if (y0 >= input.rows) y0 = input.rows - 1;
-            
-            // 计算权重
-            float dx = src_x - x0;
-            float dy = src_y - y0;
-            float w1 = (1 - dx) * (1 - dy);
-            float w2 = dx * (1 - dy);
-            float w3 = (1 - dx) * dy;
-            float w4 = dx * dy;
-            
-            // 根据通道数处理
-            if (input.channels() == 1) {
-                // 单通道图像
-                float value = input.at<uchar>(y0, x0) * w1 +
-                              input.at<uchar>(y0, x1) * w2 +
-                              input.at<uchar>(y1, x0) * w3 +
-                              input.at<uchar>(y1, x1) * w4;
-                output.at<uchar>(y, x) = cv::saturate_cast<uchar>(value);//第y行第x列
-            } else if (input.channels() == 3) {
-                // 三通道图像
-                cv::Vec3b p1 = input.at<cv::Vec3b>(y0, x0);
-                cv::Vec3b p2 = input.at<cv::Vec3b>(y0, x1);
-                cv::Vec3b p3 = input.at<cv::Vec3b>(y1, x0);
-                cv::Vec3b p4 = input.at<cv::Vec3b>(y1, x1);
-                
-                cv::Vec3b result;
-                for (int c = 0; c < 3; c++) {
-                    float value = p1[c] * w1 + p2[c] * w2 + p3[c] * w3 + p4[c] * w4;
-                    result[c] = cv::saturate_cast<uchar>(value);
-                }
-                output.at<cv::Vec3b>(y, x) = result;
-            }
-        }
+    if (output.empty() || input.empty()) {
+        return output;
+    }
+    if (output.size() == input.size()) {
+        input.copyTo(output);
+        return output;
+    }
+
+    switch (depth) {
+        case CV_8U:  resizeChannels<uchar>(input, output); break;
+        case CV_16U: resizeChannels<ushort>(input, output); break;
+        case CV_32F: resizeChannels<float>(input, output); break;
     }
-    
     return output;
 }
@@ -1,4 +1,12 @@
 #include "impls.h"
+#include "utils.h"
+#include "golden.h"
+#include "log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
 
 
 bool test_my_resize() {
@@ -8,6 +16,22 @@ bool test_my_resize() {
     std::vector<float> scales{1.5f, 0.5f};
     cv::Mat res;
 
+    if (is_headless()) {
+        // 插值的取样位置可以和 cv::resize 略有不同，用 PSNR 衡量“长得差不多”
+        golden::Tolerance tolerance;
+        tolerance.pixel = 10;
+        tolerance.max_over_fraction = 0.1;
+        tolerance.min_psnr = 30;
+        bool pass = true;
+        for (const auto& s : scales) {
+            cv::Mat resized = my_resize(input, s);
+            cv::resize(input, res, cv::Size((int)(input.cols * s), (int)(input.rows * s)));
+            std::string name = "resize_x" + std::to_string(s).substr(0, 3);
+            pass = golden::check(name.c_str(), resized, res, tolerance) && pass;
+        }
+        return pass;
+    }
+
     for (const auto& s : scales) {
         std::string title = "scale = " + std::to_string(s);
 
@@ -23,4 +47,183 @@ bool test_my_resize() {
     }
 
     return true;
-}
\ No newline at end of file
+}
+
+// 和 cv::resize 比速度和精度：放大对比 INTER_LINEAR，缩小对比 INTER_AREA（my_resize 缩小时走区域平均）。
+// 两边都按输出行并行，比较时都限制为单线程，只比单核的速度（多线程结果见 test_resize_types）
+bool bench_my_resize() {
+    typedef std::chrono::steady_clock Clock;
+    cv::Mat input = cv::imread("../assets/resize/input.jpg");
+    if (input.empty()) {
+        std::cout << "无法读取 ../assets/resize/input.jpg" << std::endl;
+        return false;
+    }
+
+    const int threads = cv::getNumThreads();
+    cv::setNumThreads(1);
+
+    const int warmup = 2, iterations = 20;
+    std::vector<float> scales{0.25f, 0.5f, 0.75f, 1.5f, 2.0f};
+    std::cout << "输入 " << input.cols << "x" << input.rows << ", 每个比例运行 " << iterations << " 次取中位数" << std::endl;
+    std::cout << "比例    输出尺寸      my_resize(ms)  cv::resize(ms)  加速比   最大差  PSNR(dB)" << std::endl;
+
+    bool pass = true;
+    for (float s : scales) {
+        cv::Size size((int)(input.cols * s), (int)(input.rows * s));
+        int interpolation = s < 1 ? cv::INTER_AREA : cv::INTER_LINEAR;
+
+        cv::Mat mine, ref;
+        std::vector<double> mine_ms, ref_ms;
+        for (int i = 0; i < warmup + iterations; i++) {
+            Clock::time_point t0 = Clock::now();
+            mine = my_resize(input, s);
+            Clock::time_point t1 = Clock::now();
+            cv::resize(input, ref, size, 0, 0, interpolation);
+            Clock::time_point t2 = Clock::now();
+            if (i >= warmup) {
+                mine_ms.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+                ref_ms.push_back(std::chrono::duration<double, std::milli>(t2 - t1).count());
+            }
+        }
+        std::sort(mine_ms.begin(), mine_ms.end());
+        std::sort(ref_ms.begin(), ref_ms.end());
+        double mine_med = mine_ms[iterations / 2], ref_med = ref_ms[iterations / 2];
+
+        golden::DiffStats stats = golden::compare(mine, ref, 1);
+        // 定点系数和 OpenCV 的取整方式不完全相同，允许 ±1
+        bool ok = stats.comparable && stats.max_diff <= 1;
+        pass = pass && ok;
+
+        char line[160];
+        snprintf(line, sizeof(line), "%-7.2f %5dx%-7d %13.2f %15.2f %7.2fx %7.0f %9.2f%s",
+                 s, size.width, size.height, mine_med, ref_med, ref_med / mine_med,
+                 stats.max_diff, stats.psnr, ok ? "" : "  <- 误差过大");
+        std::cout << line << std::endl;
+    }
+
+    cv::setNumThreads(threads);
+    return pass;
+}
+
+
+// 各元素类型、通道数和 cv::resize 的差别，以及多线程和单线程结果是否完全一致
+bool test_resize_types() {
+    cv::Mat bgr = cv::imread("../assets/resize/input.jpg");
+    if (bgr.empty()) {
+        std::cout << "无法读取 ../assets/resize/input.jpg" << std::endl;
+        return false;
+    }
+    cv::resize(bgr, bgr, cv::Size(bgr.cols / 3, bgr.rows / 3));
+
+    std::vector<cv::Mat> channels;
+    cv::split(bgr, channels);
+    std::vector<cv::Mat> inputs(4);
+    inputs[0] = channels[0];
+    cv::merge(std::vector<cv::Mat>{channels[0], channels[1]}, inputs[1]);
+    inputs[2] = bgr;
+    cv::cvtColor(bgr, inputs[3], cv::COLOR_BGR2BGRA);
+
+    const int depths[] = {CV_8U, CV_16U, CV_32F};
+    const char* depth_names[] = {"8U", "16U", "32F"};
+    const std::vector<float> scales{0.5f, 0.37f, 1.6f};
+    const int threads = cv::getNumThreads();
+
+    bool pass = true;
+    for (int d = 0; d < 3; d++) {
+        // 16 位用满量程，浮点归一化到 [0, 1]；允许的误差对应 8 位的 ±1 左右
+        double alpha = depths[d] == CV_16U ? 257 : depths[d] == CV_32F ? 1 / 255. : 1;
+        double max_allowed = depths[d] == CV_32F ? 1e-4 : 1;
+        for (int cn = 1; cn <= 4; cn++) {
+            cv::Mat input;
+            inputs[cn - 1].convertTo(input, depths[d], alpha);
+
+            for (float s : scales) {
+                cv::Size size((int)(input.cols * s), (int)(input.rows * s));
+                cv::Mat ref, single;
+                cv::resize(input, ref, size, 0, 0, s < 1 ? cv::INTER_AREA : cv::INTER_LINEAR);
+                cv::Mat mine = my_resize(input, s);
+                cv::setNumThreads(1);
+                single = my_resize(input, s);
+                cv::setNumThreads(threads);
+
+                bool same_size = mine.size() == ref.size() && mine.type() == ref.type();
+                double diff = same_size ? cv::norm(mine, ref, cv::NORM_INF) : -1;
+                bool deterministic = same_size && cv::norm(mine, single, cv::NORM_INF) == 0;
+                bool ok = same_size && diff <= max_allowed && deterministic;
+                pass = pass && ok;
+                if (!ok) {
+                    LOG_WARN("%sC%d x%.2f: 最大差 %g, 多线程与单线程%s", depth_names[d], cn, s, diff,
+                             deterministic ? "一致" : "不一致");
+                }
+            }
+        }
+        LOG_MSG("%s 1~4 通道检查完毕", depth_names[d]);
+    }
+    return pass;
+}
+
+// 线程数从 1 到核数，输入从 720p 到 4K，看条带并行的加速比；各线程数的结果必须完全一致
+bool bench_resize_scaling() {
+    typedef std::chrono::steady_clock Clock;
+    cv::Mat source = cv::imread("../assets/resize/input.jpg");
+    if (source.empty()) {
+        std::cout << "无法读取 ../assets/resize/input.jpg" << std::endl;
+        return false;
+    }
+
+    const int threads = cv::getNumThreads();
+    const int hw = std::max(1, (int)std::thread::hardware_concurrency());
+    std::vector<int> thread_counts;
+    for (int n = 1; n < hw; n *= 2) thread_counts.push_back(n);
+    thread_counts.push_back(hw);
+
+    const std::vector<cv::Size> sizes{cv::Size(1280, 720), cv::Size(1920, 1080), cv::Size(3840, 2160)};
+    const std::vector<float> scales{0.5f, 0.75f, 1.5f};
+    const int warmup = 2, iterations = 10;
+
+    std::cout << "输入     比例   线程  my_resize(ms)  加速比  cv::resize(ms)" << std::endl;
+    bool pass = true;
+    for (const cv::Size& size : sizes) {
+        cv::Mat input;
+        cv::resize(source, input, size);
+        for (float s : scales) {
+            cv::Mat baseline;
+            double single_ms = 0;
+            for (int n : thread_counts) {
+                cv::setNumThreads(n);
+                cv::Size out_size((int)(size.width * s), (int)(size.height * s));
+                cv::Mat mine, ref;
+                std::vector<double> mine_ms, ref_ms;
+                for (int i = 0; i < warmup + iterations; i++) {
+                    Clock::time_point t0 = Clock::now();
+                    mine = my_resize(input, s);
+                    Clock::time_point t1 = Clock::now();
+                    cv::resize(input, ref, out_size, 0, 0, s < 1 ? cv::INTER_AREA : cv::INTER_LINEAR);
+                    Clock::time_point t2 = Clock::now();
+                    if (i >= warmup) {
+                        mine_ms.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+                        ref_ms.push_back(std::chrono::duration<double, std::milli>(t2 - t1).count());
+                    }
+                }
+                std::sort(mine_ms.begin(), mine_ms.end());
+                std::sort(ref_ms.begin(), ref_ms.end());
+                double mine_med = mine_ms[iterations / 2];
+                if (n == 1) {
+                    baseline = mine;
+                    single_ms = mine_med;
+                } else if (cv::norm(mine, baseline, cv::NORM_INF) != 0) {
+                    LOG_WARN("%dx%d x%.2f: %d 线程的结果和单线程不一致", size.width, size.height, s, n);
+                    pass = false;
+                }
+
+                char line[128];
+                snprintf(line, sizeof(line), "%4dx%-5d %5.2f %5d %13.2f %7.2fx %14.2f",
+                         size.width, size.height, s, n, mine_med, single_ms / mine_med, ref_ms[iterations / 2]);
+                std::cout << line << std::endl;
+            }
+        }
+    }
+
+    cv::setNumThreads(threads);
+    return pass;
+}
@@ -1,8 +1,13 @@
 #include "impls.h"
+#include "trace.h"
+#include "histogram.h"
+#include "ccl.h"
+#include "region_stats.h"
 #include <unordered_map>
 
 
 std::unordered_map<int, cv::Rect> roi_color(const cv::Mat& input) {
+    TRACE_SCOPE("roi_color");
     /**
      * INPUT: 一张彩色图片, 路径: assets/roi_color/input.png
      * OUTPUT: 一个 unordered_map, key 为颜色(Blue: 0, Green: 1, Red: 2), value 为对应颜色的矩形区域(cv::Rect)
@@ -35,53 +40,36 @@ std::unordered_map<int, cv::Rect> roi_color(const cv::Mat& input) {
     // 1 . 图像预处理：彩色 -> 灰度 -> 二值
     cv::Mat gray, binary;
     
-    // 将彩色图像转换为灰度图像
-    // 参数：源图像, 目标图像, 转换类型
-    cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
+    // 将彩色图像转换为灰度图像，同时统计直方图
+    // 参数：源图像, 目标图像
+    histogram::FrameHistogram hist;
+    hist.update(input, gray);
     
     // 对灰度图像进行二值化处理
-    // 参数：源图像, 目标图像, 阈值(使用OTSU时设为0), 255-最大值, 
-    // cv::THRESH_BINARY_INV | cv::THRESH_OTSU-二值化类型(反转+OTSU自适应阈值)
+    // 参数：源图像, 目标图像, 阈值(从直方图算出的 Otsu 阈值), 255-最大值, 
+    // cv::THRESH_BINARY_INV-二值化类型(反转)
     // THRESH_BINARY_INV: 将大于阈值的像素设为0，小于等于的设为255（白底黑字变为黑底白字）
-    // THRESH_OTSU: 自动计算最佳阈值
-    cv::threshold(gray, binary, 0, 255, cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
+    // hist.otsu(): 和 THRESH_OTSU 自动计算的最佳阈值相同，不用再扫一遍灰度图
+    cv::threshold(gray, binary, hist.otsu(), 255, cv::THRESH_BINARY_INV);
 
-    // 2. 查找轮廓
-    std::vector<std::vector<cv::Point>> contours;  // 存储找到的轮廓点集
-    std::vector<cv::Vec4i> hierarchy;             // 存储轮廓的层次结构信息
-    
-    // 查找图像中的所有轮廓
-    // 参数：输入二值图像, 输出轮廓, 输出层次结构,
-    // cv::RETR_EXTERNAL-只检索最外层轮廓, cv::CHAIN_APPROX_SIMPLE-压缩轮廓点
-    cv::findContours(binary, contours, hierarchy, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    // 2. 标记连通域：每个前景连通域就是一个色块，外接框即 findContours(RETR_EXTERNAL) + boundingRect 的结果
+    ccl::Labeller labeller;
+    std::vector<ccl::Component> components;
+    labeller.label(binary, components, 8);
+
+    // 3. 一次统计所有色块的颜色，只算色块自己的像素，不混入外接框里的背景
+    region::ColourStatistics statistics;
+    std::vector<region::ColourStats> colours;
+    statistics.compute(input, labeller.runs(), labeller.runComponents(), (int)components.size(), colours);
+
+    for (size_t i = 0; i < components.size(); i++) {
+        // 根据平均颜色里最大的通道判断颜色类型（OpenCV 使用 BGR 格式）：
+        // 0 - Blue, 1 - Green, 2 - Red, -1 - 没有严格最大的通道
+        int color_type = colours[i].meanColour();
 
-    // 3. 处理每个找到的轮廓
-    for (const auto& contour : contours) {
-        // 使用boundingRect计算轮廓的最小外接矩形
-        cv::Rect rect = cv::boundingRect(contour);
-        
-        
-        cv::Mat roi = input(rect);// 从原图中提取ROI区域
-        cv::Scalar mean_color = cv::mean(roi);// 计算ROI区域的平均颜色
-        
-        // 根据BGR通道值判断颜色类型
-        int color_type = -1;
-        
-        // OpenCV使用BGR格式：mean_color[0]=B, mean_color[1]=G, mean_color[2]=R
-        if (mean_color[0] > mean_color[1] && mean_color[0] > mean_color[2]) {
-            // 蓝色通道值最大 -> 蓝色
-            color_type = 0; // Blue
-        } else if (mean_color[1] > mean_color[0] && mean_color[1] > mean_color[2]) {
-            // 绿色通道值最大 -> 绿色
-            color_type = 1; // Green
-        } else if (mean_color[2] > mean_color[0] && mean_color[2] > mean_color[1]) {
-            // 红色通道值最大 -> 红色
-            color_type = 2; // Red
-        }
-        
         // 如果成功识别颜色，将颜色和矩形位置存入结果map
         if (color_type != -1) {
-            res[color_type] = rect;
+            res[color_type] = components[i].bbox;
         }
     }
 
@@ -0,0 +1,132 @@
+#include "region_stats.h"
+#include <algorithm>
+
+namespace region {
+
+// 三个数里严格最大的下标，没有则 -1
+template <typename T>
+static int strictMax(const T* v) {
+    if (v[0] > v[1] && v[0] > v[2]) return 0;
+    if (v[1] > v[0] && v[1] > v[2]) return 1;
+    if (v[2] > v[0] && v[2] > v[1]) return 2;
+    return -1;
+}
+
+cv::Scalar ColourStats::mean() const {
+    if (area == 0) return cv::Scalar();
+    return cv::Scalar((double)sum[0] / area, (double)sum[1] / area, (double)sum[2] / area);
+}
+
+cv::Scalar ColourStats::variance() const {
+    if (area == 0) return cv::Scalar();
+    cv::Scalar v;
+    for (int c = 0; c < 3; c++) {
+        const double m = (double)sum[c] / area;
+        v[c] = std::max(0.0, (double)sqsum[c] / area - m * m);
+    }
+    return v;
+}
+
+int ColourStats::meanColour() const {
+    // 面积相同，比较和就是比较均值
+    return area == 0 ? -1 : strictMax(sum);
+}
+
+int ColourStats::dominant() const {
+    return strictMax(votes);
+}
+
+// p 指向 n 个连续的 BGR 像素
+static void accumulate(const uchar* p, int n, uint32_t* sum, uint32_t* sqsum, uint32_t* votes) {
+    uint32_t b = 0, g = 0, r = 0, bb = 0, gg = 0, rr = 0, vb = 0, vg = 0, vr = 0;
+    for (int i = 0; i < n; i++, p += 3) {
+        const uint32_t B = p[0], G = p[1], R = p[2];
+        b += B;
+        g += G;
+        r += R;
+        bb += B * B;
+        gg += G * G;
+        rr += R * R;
+        vb += B > G && B > R;
+        vg += G > B && G > R;
+        vr += R > B && R > G;
+    }
+    sum[0] = b, sum[1] = g, sum[2] = r;
+    sqsum[0] = bb, sqsum[1] = gg, sqsum[2] = rr;
+    votes[0] = vb, votes[1] = vg, votes[2] = vr;
+}
+
+void ColourStatistics::reduce(const std::vector<Span>& spans, std::vector<ColourStats>& stats) const {
+    for (const Span& s : spans) {
+        ColourStats& st = stats[s.label];
+        st.area += s.area;
+        for (int c = 0; c < 3; c++) {
+            st.sum[c] += s.sum[c];
+            st.sqsum[c] += s.sqsum[c];
+            st.votes[c] += s.votes[c];
+        }
+    }
+}
+
+void ColourStatistics::compute(const cv::Mat& bgr, const cv::Mat& labels, int count,
+                               std::vector<ColourStats>& stats) {
+    CV_Assert(bgr.type() == CV_8UC3 && labels.type() == CV_32SC1 && bgr.size() == labels.size());
+    CV_Assert(bgr.cols <= 65535);
+    stats.assign(count, ColourStats());
+
+    // 每个线程一块行，块内逐行把同标签的连续像素切成一段
+    const int rows = bgr.rows, cols = bgr.cols;
+    const int nchunks = std::max(1, std::min(cv::getNumThreads(), rows));
+    if (chunks_.size() < (size_t)nchunks) chunks_.resize(nchunks);
+    cv::parallel_for_(cv::Range(0, nchunks), [&](const cv::Range& range) {
+        for (int k = range.start; k < range.end; k++) {
+            std::vector<Span>& spans = chunks_[k];
+            spans.clear();
+            const int y0 = (int)((int64_t)rows * k / nchunks), y1 = (int)((int64_t)rows * (k + 1) / nchunks);
+            for (int y = y0; y < y1; y++) {
+                const int* l = labels.ptr<int>(y);
+                const uchar* p = bgr.ptr<uchar>(y);
+                for (int x = 0; x < cols;) {
+                    const int label = l[x];
+                    int end = x + 1;
+                    while (end < cols && l[end] == label) end++;
+                    if (label > 0) {
+                        Span s;
+                        s.label = label - 1;
+                        s.area = end - x;
+                        accumulate(p + x * 3, end - x, s.sum, s.sqsum, s.votes);
+                        spans.push_back(s);
+                    }
+                    x = end;
+                }
+            }
+        }
+    }, nchunks);
+
+    for (int k = 0; k < nchunks; k++) reduce(chunks_[k], stats);
+}
+
+void ColourStatistics::compute(const cv::Mat& bgr, const std::vector<bitmask::Run>& runs,
+                               const std::vector<int>& run_labels, int count, std::vector<ColourStats>& stats) {
+    CV_Assert(bgr.type() == CV_8UC3 && runs.size() == run_labels.size());
+    CV_Assert(bgr.cols <= 65535);
+    stats.assign(count, ColourStats());
+
+    // 每个行程的小计写到自己的位置，分给各线程不用加锁
+    const int nruns = (int)runs.size();
+    spans_.resize(nruns);
+    const int nstripes = std::max(1, std::min(cv::getNumThreads(), nruns / 256));
+    cv::parallel_for_(cv::Range(0, nruns), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            const bitmask::Run& r = runs[i];
+            Span& s = spans_[i];
+            s.label = run_labels[i];
+            s.area = r.end - r.begin;
+            accumulate(bgr.ptr<uchar>(r.y) + r.begin * 3, r.end - r.begin, s.sum, s.sqsum, s.votes);
+        }
+    }, nstripes);
+
+    reduce(spans_, stats);
+}
+
+} // namespace region
@@ -1,6 +1,10 @@
 #include "tests.h"
 #include "impls.h"
 #include "log.h"
+#include "utils.h"
+#include "ccl.h"
+#include "region_stats.h"
+#include <algorithm>
 
 
 std::string to_string(int i) {
@@ -78,9 +82,169 @@ bool test_roi_color() {
 
     if (check_force(res)) {
         return true;
+    } else if (is_headless()) {
+        // 无界面时没法人工检查，只认强行答案对比
+        return false;
     } else if (check_self(input, res)) {
         return true;
     } else {
         return false;
     }
 }
+
+// 彩色背景上画 blobs 个颜色各异、半轴不超过 max_axis 的椭圆，binary 为椭圆所在的位置
+static void colour_scene(cv::Size size, int blobs, int max_axis, cv::RNG& rng, cv::Mat& bgr, cv::Mat& binary) {
+    bgr.create(size, CV_8UC3);
+    rng.fill(bgr, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+    binary = cv::Mat::zeros(size, CV_8UC1);
+    for (int i = 0; i < blobs; i++) {
+        cv::Point c(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        cv::Size axes(rng.uniform(1, max_axis), rng.uniform(1, max_axis));
+        double angle = rng.uniform(0, 180);
+        cv::Scalar colour(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        cv::ellipse(bgr, c, axes, angle, 0, 360, colour, -1);
+        cv::ellipse(binary, c, axes, angle, 0, 360, cv::Scalar(255), -1);
+    }
+    // 椭圆内部也加点噪声，方差不为 0
+    cv::Mat noise(size, CV_8UC3);
+    rng.fill(noise, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(16));
+    cv::add(bgr, noise, bgr);
+}
+
+static bool same_stats(const region::ColourStats& a, const region::ColourStats& b) {
+    if (a.area != b.area) return false;
+    for (int c = 0; c < 3; c++) {
+        if (a.sum[c] != b.sum[c] || a.sqsum[c] != b.sqsum[c] || a.votes[c] != b.votes[c]) return false;
+    }
+    return true;
+}
+
+bool test_region_stats() {
+    cv::RNG rng(20241228);
+    const cv::Size sizes[] = {cv::Size(1, 1), cv::Size(40, 3), cv::Size(3, 40), cv::Size(320, 240), cv::Size(641, 257)};
+    const int blob_counts[] = {1, 5, 5, 60, 200};
+    const int max_axes[] = {2, 4, 4, 25, 8};
+    ccl::Labeller labeller;
+    std::vector<ccl::Component> components;
+    region::ColourStatistics statistics;
+    std::vector<region::ColourStats> by_runs, by_labels, by_cc;
+    cv::Mat bgr, binary, labels, cc_labels, mask;
+
+    for (int s = 0; s < 5; s++) {
+        colour_scene(sizes[s], blob_counts[s], max_axes[s], rng, bgr, binary);
+        labeller.label(binary, components);
+        labeller.labels(binary.size(), labels);
+        const int count = (int)components.size();
+        statistics.compute(bgr, labeller.runs(), labeller.runComponents(), count, by_runs);
+        statistics.compute(bgr, labels, count, by_labels);
+
+        for (int i = 0; i < count; i++) {
+            const region::ColourStats& a = by_runs[i];
+            const region::ColourStats& b = by_labels[i];
+            if (!same_stats(a, b)) {
+                std::cout << sizes[s].width << "x" << sizes[s].height << ": 第 " << i
+                          << " 个区域行程版和标签图版的结果不同" << std::endl;
+                return false;
+            }
+
+            // 逐像素重新算一遍
+            mask = labels == i + 1;
+            cv::Scalar mean, stddev;
+            cv::meanStdDev(bgr, mean, stddev, mask);
+            int votes[3] = {0, 0, 0};
+            for (int y = 0; y < bgr.rows; y++) {
+                for (int x = 0; x < bgr.cols; x++) {
+                    if (!mask.at<uchar>(y, x)) continue;
+                    const cv::Vec3b& p = bgr.at<cv::Vec3b>(y, x);
+                    for (int c = 0; c < 3; c++) {
+                        votes[c] += p[c] > p[(c + 1) % 3] && p[c] > p[(c + 2) % 3];
+                    }
+                }
+            }
+            const cv::Scalar m = a.mean(), v = a.variance();
+            bool ok = a.area == components[i].area && a.area == cv::countNonZero(mask);
+            for (int c = 0; c < 3; c++) {
+                ok = ok && std::abs(m[c] - mean[c]) < 1e-6 && std::abs(v[c] - stddev[c] * stddev[c]) < 1e-4 &&
+                     a.votes[c] == votes[c];
+            }
+            if (!ok) {
+                std::cout << sizes[s].width << "x" << sizes[s].height << ": 第 " << i << " 个区域 面积 " << a.area
+                          << " 均值 " << m << " 方差 " << v << "，meanStdDev 得到均值 " << mean << " 标准差 " << stddev
+                          << std::endl;
+                return false;
+            }
+        }
+
+        // 别的标签图（编号顺序不同）也一样：按区域里任意一个像素对上号
+        const int n = cv::connectedComponents(binary, cc_labels, 8, CV_32S);
+        statistics.compute(bgr, cc_labels, n - 1, by_cc);
+        for (int i = 0; i < count; i++) {
+            const bitmask::Run& r = labeller.runs()[std::find(labeller.runComponents().begin(),
+                                                              labeller.runComponents().end(), i) -
+                                                    labeller.runComponents().begin()];
+            const int j = cc_labels.at<int>(r.y, r.begin) - 1;
+            if (!same_stats(by_cc[j], by_runs[i])) {
+                std::cout << sizes[s].width << "x" << sizes[s].height << ": connectedComponents 标签图上第 " << j
+                          << " 个区域的结果不同" << std::endl;
+                return false;
+            }
+        }
+    }
+    std::cout << "区域颜色统计与 meanStdDev(掩码) 及逐像素投票一致" << std::endl;
+    return true;
+}
+
+bool bench_region_stats() {
+    cv::RNG rng(12345);
+    const cv::Size size(1280, 1024);
+    // 区域越多越小，5000 个椭圆大约是 3000 多个连通域
+    const int blob_counts[] = {10, 100, 1000, 5000};
+    const int max_axes[] = {40, 25, 10, 6};
+    ccl::Labeller labeller;
+    std::vector<ccl::Component> components;
+    region::ColourStatistics statistics;
+    std::vector<region::ColourStats> colours;
+    cv::Mat bgr, binary, labels;
+
+    for (int b = 0; b < 4; b++) {
+        colour_scene(size, blob_counts[b], max_axes[b], rng, bgr, binary);
+        labeller.label(binary, components);
+        labeller.labels(binary.size(), labels);
+        const int count = (int)components.size();
+        const int iterations = 30;
+        std::vector<int> box_colour(count);
+
+        int64 t0 = cv::getTickCount();
+        for (int it = 0; it < iterations; it++) {
+            // 原来的做法：每个区域对外接框求均值
+            for (int i = 0; i < count; i++) {
+                cv::Scalar m = cv::mean(bgr(components[i].bbox));
+                box_colour[i] = -1;
+                for (int c = 0; c < 3; c++) {
+                    if (m[c] > m[(c + 1) % 3] && m[c] > m[(c + 2) % 3]) box_colour[i] = c;
+                }
+            }
+        }
+        int64 t1 = cv::getTickCount();
+        for (int it = 0; it < iterations; it++) {
+            statistics.compute(bgr, labels, count, colours);
+        }
+        int64 t2 = cv::getTickCount();
+        for (int it = 0; it < iterations; it++) {
+            statistics.compute(bgr, labeller.runs(), labeller.runComponents(), count, colours);
+        }
+        int64 t3 = cv::getTickCount();
+
+        // 外接框里混进了背景，颜色判断可能不同
+        int differ = 0;
+        for (int i = 0; i < count; i++) differ += box_colour[i] != colours[i].meanColour();
+
+        double box_ms = (t1 - t0) * 1000.0 / cv::getTickFrequency() / iterations;
+        double label_ms = (t2 - t1) * 1000.0 / cv::getTickFrequency() / iterations;
+        double run_ms = (t3 - t2) * 1000.0 / cv::getTickFrequency() / iterations;
+        std::cout << size.width << "x" << size.height << ", " << count << " 个区域: 外接框 cv::mean " << box_ms
+                  << " ms, 标签图一遍 " << label_ms << " ms, 行程一遍 " << run_ms << " ms (相对外接框加速 "
+                  << box_ms / run_ms << "x), 颜色判断不同的区域 " << differ << " 个" << std::endl;
+    }
+    return true;
+}
@@ -1,6 +1,8 @@
 #include "impls.h"
+#include "trace.h"
 
 std::vector<cv::Mat> split(const cv::Mat& rgb_image) {
+    TRACE_SCOPE("split");
     /**
      * TODO: 将图像分割为 blue green red 三个通道，具体内容：
      *  1. 将彩色图片 rgb_image 转换为三个通道的 cv::Mat
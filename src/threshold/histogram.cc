@@ -0,0 +1,117 @@
+#include "histogram.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+namespace histogram {
+
+// 每块的行数：1280 宽时彩色 60KB、灰度 20KB，统计直方图时灰度还在 L1 / L2 里
+static const int kBlockRows = 16;
+
+void FrameHistogram::reset() {
+    memset(bins_, 0, sizeof(bins_));
+    total_ = 0;
+    otsu_ = -1;
+}
+
+// 4 份直方图轮流累加，相邻相同的灰度不会互相等待同一个计数器的写回
+static void accumulate(const uchar* p, int n, uint32_t (*h)[256]) {
+    int x = 0;
+    for (; x + 4 <= n; x += 4) {
+        h[0][p[x]]++;
+        h[1][p[x + 1]]++;
+        h[2][p[x + 2]]++;
+        h[3][p[x + 3]]++;
+    }
+    for (; x < n; x++) h[0][p[x]]++;
+}
+
+static void accumulateMat(const cv::Mat& gray, uint32_t (*h)[256]) {
+    if (gray.isContinuous()) {
+        accumulate(gray.ptr<uchar>(0), gray.rows * gray.cols, h);
+        return;
+    }
+    for (int y = 0; y < gray.rows; y++) {
+        accumulate(gray.ptr<uchar>(y), gray.cols, h);
+    }
+}
+
+void FrameHistogram::update(const cv::Mat& bgr, cv::Mat& gray) {
+    CV_Assert(bgr.type() == CV_8UC3);
+    reset();
+    gray.create(bgr.rows, bgr.cols, CV_8UC1);
+    uint32_t h[4][256] = {};
+    for (int y0 = 0; y0 < bgr.rows; y0 += kBlockRows) {
+        const int y1 = std::min(bgr.rows, y0 + kBlockRows);
+        cv::Mat block = gray.rowRange(y0, y1);
+        cv::cvtColor(bgr.rowRange(y0, y1), block, cv::COLOR_BGR2GRAY);
+        accumulateMat(block, h);
+    }
+    for (int i = 0; i < 256; i++) {
+        bins_[i] = h[0][i] + h[1][i] + h[2][i] + h[3][i];
+    }
+    total_ = bgr.rows * bgr.cols;
+}
+
+void FrameHistogram::updateGray(const cv::Mat& gray) {
+    CV_Assert(gray.type() == CV_8UC1);
+    reset();
+    uint32_t h[4][256] = {};
+    accumulateMat(gray, h);
+    for (int i = 0; i < 256; i++) {
+        bins_[i] = h[0][i] + h[1][i] + h[2][i] + h[3][i];
+    }
+    total_ = gray.rows * gray.cols;
+}
+
+// 和 OpenCV 的 getThreshVal_Otsu_8u 相同的 double 运算顺序，类间方差最大且最靠前的灰度
+int FrameHistogram::otsu() const {
+    if (otsu_ >= 0) return otsu_;
+    if (total_ == 0) return otsu_ = 0;
+
+    const double scale = 1. / total_;
+    double mu = 0;
+    for (int i = 0; i < 256; i++) {
+        mu += i * (double)bins_[i];
+    }
+    mu *= scale;
+
+    double mu1 = 0, q1 = 0;
+    double max_sigma = 0;
+    int max_val = 0;
+    for (int i = 0; i < 256; i++) {
+        double p_i = bins_[i] * scale;
+        mu1 *= q1;
+        q1 += p_i;
+        double q2 = 1. - q1;
+        if (std::min(q1, q2) < FLT_EPSILON || std::max(q1, q2) > 1. - FLT_EPSILON) continue;
+        mu1 = (mu1 + i * p_i) / q1;
+        double mu2 = (mu - q1 * mu1) / q2;
+        double sigma = q1 * q2 * (mu1 - mu2) * (mu1 - mu2);
+        if (sigma > max_sigma) {
+            max_sigma = sigma;
+            max_val = i;
+        }
+    }
+    return otsu_ = max_val;
+}
+
+int FrameHistogram::percentile(double q) const {
+    if (total_ == 0) return 0;
+    q = std::min(1., std::max(0., q));
+    // 至少要有一个像素，q = 0 时得到最暗的灰度
+    const double need = std::max(1., q * total_);
+    uint64_t sum = 0;
+    for (int i = 0; i < 256; i++) {
+        sum += bins_[i];
+        if (sum >= need) return i;
+    }
+    return 255;
+}
+
+int SmoothedThreshold::update(int raw) {
+    value_ = value_ < 0 ? raw : alpha_ * raw + (1 - alpha_) * value_;
+    return cvRound(value_);
+}
+
+} // namespace histogram
@@ -1,7 +1,9 @@
 #include "impls.h"
+#include "trace.h"
 
 
 std::vector<cv::Mat> threshold(const cv::Mat& src, int threshold_value) {
+    TRACE_SCOPE("threshold");
     /**
      * TODO: 将一个彩色图片转换为二值化图
      *  1. 将 src 转换成灰度图像
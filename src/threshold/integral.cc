@@ -0,0 +1,145 @@
+#include "integral.h"
+#include "mat_buffer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace integral {
+
+// 每块至少的行数，块太小时传递累计的开销比并行省下的多
+static const int kMinBandRows = 32;
+
+// 一行（含左右各 border 个复制的边界像素）的前缀和加上表的上一行 prev，第 0 个为 0。
+// 一行之内用 32 位累加，加 prev 和转成 double 都不在依赖链上
+template <typename T, bool Square>
+static void prefixRow(const uchar* src, int cols, int border, const T* prev, T* out) {
+    const uint32_t first = Square ? src[0] * src[0] : src[0];
+    const uint32_t last = Square ? src[cols - 1] * src[cols - 1] : src[cols - 1];
+    uint32_t s = 0;
+    out[0] = 0;
+    const T* p = prev + 1;
+    T* o = out + 1;
+    for (int k = 0; k < border; k++) *o++ = *p++ + (T)(s += first);
+    for (int x = 0; x < cols; x++) {
+        const uint32_t v = src[x];
+        *o++ = *p++ + (T)(s += Square ? v * v : v);
+    }
+    for (int k = 0; k < border; k++) *o++ = *p++ + (T)(s += last);
+}
+
+// 块内自己累计，第一行加的是全 0 的一行
+template <typename T, bool Square>
+static void bandTable(const cv::Mat& gray, int border, int y0, int y1, const T* zeros, cv::Mat& table) {
+    for (int y = y0; y < y1; y++) {
+        const int sy = std::min(std::max(y - border, 0), gray.rows - 1);
+        prefixRow<T, Square>(gray.ptr<uchar>(sy), gray.cols, border, y == y0 ? zeros : table.ptr<T>(y),
+                             table.ptr<T>(y + 1));
+    }
+}
+
+// 各块最后一行依次累计：offsets 的第 b 段是第 b 块每一行要加上的值（第 0 块不用加）
+template <typename T>
+static void bandOffsets(const cv::Mat& table, const std::vector<int>& band_end, std::vector<T>& offsets) {
+    const int n = table.cols, nbands = (int)band_end.size();
+    offsets.assign((size_t)nbands * n, 0);
+    for (int b = 1; b < nbands; b++) {
+        const T* last = table.ptr<T>(band_end[b - 1]);
+        const T* prev = &offsets[(size_t)(b - 1) * n];
+        T* cur = &offsets[(size_t)b * n];
+        for (int x = 0; x < n; x++) cur[x] = prev[x] + last[x];
+    }
+}
+
+template <typename T>
+static void addOffsets(const std::vector<T>& offsets, int b, int y0, int y1, cv::Mat& table) {
+    const int n = table.cols;
+    const T* add = &offsets[(size_t)b * n];
+    for (int y = y0; y < y1; y++) {
+        T* row = table.ptr<T>(y + 1);
+        for (int x = 0; x < n; x++) row[x] += add[x];
+    }
+}
+
+void IntegralImage::build(const cv::Mat& gray, int border, bool squares) {
+    CV_Assert(gray.type() == CV_8UC1 && !gray.empty() && border >= 0);
+    const int rows = gray.rows + 2 * border, cols = gray.cols + 2 * border;
+    // 255 * 8M 还在 int 范围内；一行的平方和用 32 位无符号累加，255^2 * 66051 < 2^32，一行不超过 66051 个像素
+    CV_Assert((int64_t)rows * cols <= (1 << 23) && cols <= 66051);
+    size_ = gray.size();
+    border_ = border;
+    squares_ = squares;
+
+    sum_ = reserveBuffer(sum_buf_, rows + 1, cols + 1, CV_32SC1);
+    std::fill(sum_.ptr<int>(0), sum_.ptr<int>(0) + cols + 1, 0);
+    if (squares) {
+        sqsum_ = reserveBuffer(sqsum_buf_, rows + 1, cols + 1, CV_64FC1);
+        std::fill(sqsum_.ptr<double>(0), sqsum_.ptr<double>(0) + cols + 1, 0.0);
+    } else {
+        sqsum_ = cv::Mat();
+    }
+
+    // 表的第 y + 1 行对应扩边后的第 y 行
+    const int nbands = std::max(1, std::min(cv::getNumThreads(), rows / kMinBandRows));
+    std::vector<int> band_end(nbands);
+    for (int b = 0; b < nbands; b++) band_end[b] = (int)((int64_t)rows * (b + 1) / nbands);
+    auto bandStart = [&](int b) { return b == 0 ? 0 : band_end[b - 1]; };
+
+    cv::parallel_for_(cv::Range(0, nbands), [&](const cv::Range& range) {
+        for (int b = range.start; b < range.end; b++) {
+            bandTable<int, false>(gray, border, bandStart(b), band_end[b], sum_.ptr<int>(0), sum_);
+            if (squares) {
+                bandTable<double, true>(gray, border, bandStart(b), band_end[b], sqsum_.ptr<double>(0), sqsum_);
+            }
+        }
+    }, nbands);
+    if (nbands == 1) return;
+
+    bandOffsets(sum_, band_end, band_offsets_);
+    if (squares) bandOffsets(sqsum_, band_end, band_sq_offsets_);
+    cv::parallel_for_(cv::Range(1, nbands), [&](const cv::Range& range) {
+        for (int b = range.start; b < range.end; b++) {
+            addOffsets(band_offsets_, b, bandStart(b), band_end[b], sum_);
+            if (squares) addOffsets(band_sq_offsets_, b, bandStart(b), band_end[b], sqsum_);
+        }
+    }, nbands - 1);
+}
+
+double IntegralImage::variance(const cv::Rect& r) const {
+    CV_Assert(squares_);
+    const double n = r.area(), m = sum(r) / n;
+    return std::max(0.0, sqsum(r) / n - m * m);
+}
+
+void adaptiveMeanThreshold(const IntegralImage& table, const cv::Mat& gray, cv::Mat& binary, int block_size,
+                           double C) {
+    CV_Assert(gray.type() == CV_8UC1 && gray.size() == table.size());
+    CV_Assert(block_size % 2 == 1 && block_size > 1 && block_size <= 1023 && table.border() >= block_size / 2);
+    const int rows = gray.rows, cols = gray.cols;
+    const int radius = block_size / 2, n = block_size * block_size;
+    binary.create(rows, cols, CV_8UC1);
+
+    // adaptiveThreshold 的均值是框内平均四舍五入到 8 位，dst = src - mean > -ceil(C) ? 255 : 0，
+    // 也就是 round(sum / n) <= src + ceil(C) - 1。n 为奇数时 sum / n 不会恰好落在 .5 上，
+    // 等价于 2 * sum < (2 * src + 2 * ceil(C) - 1) * n，不用做除法。
+    // ceil(C) 超出 [-256, 256] 时结果全 0 或全 255，截断后不变，乘积也不会溢出
+    const int idelta = std::min(std::max((int)std::ceil(C), -256), 256);
+    const int bias = 2 * idelta - 1;
+    const int offset = table.border() - radius;
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        // 常量拷到局部，内层循环才能向量化
+        const int k = block_size, nk = n, bk = bias, w = cols;
+        for (int y = range.start; y < range.end; y++) {
+            const int* top = table.sums().ptr<int>(y + offset) + offset;
+            const int* bottom = table.sums().ptr<int>(y + offset + k) + offset;
+            const uchar* s = gray.ptr<uchar>(y);
+            uchar* d = binary.ptr<uchar>(y);
+            for (int x = 0; x < w; x++) {
+                const int sum = bottom[x + k] - bottom[x] - top[x + k] + top[x];
+                d[x] = (uchar)(2 * sum < (2 * s[x] + bk) * nk ? 255 : 0);
+            }
+        }
+    });
+}
+
+} // namespace integral
@@ -0,0 +1,138 @@
+#include "trace.h"
+
+#ifdef TJURM_TRACE
+
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace trace {
+
+struct Event {
+    const char* name;
+    uint64_t begin_ns;
+    uint64_t end_ns;
+};
+
+// 每个线程一个环形缓冲区，只有所属线程写；written 用 release 发布，dump 时 acquire 读
+struct ThreadBuffer {
+    int tid;
+    std::string name;
+    std::vector<Event> events;
+    std::atomic<uint64_t> written;
+
+    explicit ThreadBuffer(int _tid) : tid(_tid), events(TRACE_RING_SIZE), written(0) {}
+};
+
+// 线程退出后缓冲区仍由这里持有，dump 时还能读到
+static std::mutex& registryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::vector<std::shared_ptr<ThreadBuffer>>& registry() {
+    static std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    return buffers;
+}
+
+static thread_local ThreadBuffer* t_buffer = nullptr;
+
+static ThreadBuffer* threadBuffer() {
+    if (!t_buffer) {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        std::vector<std::shared_ptr<ThreadBuffer>>& buffers = registry();
+        buffers.push_back(std::make_shared<ThreadBuffer>((int)buffers.size() + 1));
+        t_buffer = buffers.back().get();
+    }
+    return t_buffer;
+}
+
+uint64_t now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void record(const char* name, uint64_t begin_ns, uint64_t end_ns) {
+    ThreadBuffer* buffer = threadBuffer();
+    uint64_t n = buffer->written.load(std::memory_order_relaxed);
+    Event& e = buffer->events[n & (TRACE_RING_SIZE - 1)];
+    e.name = name;
+    e.begin_ns = begin_ns;
+    e.end_ns = end_ns;
+    buffer->written.store(n + 1, std::memory_order_release);
+}
+
+void set_thread_name(const char* name) {
+    ThreadBuffer* buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex());
+    buffer->name = name;
+}
+
+static void writeString(FILE* file, const char* s) {
+    fputc('"', file);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', file);
+        fputc(*s, file);
+    }
+    fputc('"', file);
+}
+
+bool dump(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+
+    std::lock_guard<std::mutex> lock(registryMutex());
+    const std::vector<std::shared_ptr<ThreadBuffer>>& buffers = registry();
+    const int pid = (int)getpid();
+
+    // 时间戳以最早的事件为零点，单位是微秒
+    uint64_t origin = UINT64_MAX;
+    uint64_t dropped = 0;
+    for (const auto& buffer : buffers) {
+        uint64_t n = buffer->written.load(std::memory_order_acquire);
+        uint64_t first = n > TRACE_RING_SIZE ? n - TRACE_RING_SIZE : 0;
+        for (uint64_t i = first; i < n; i++) {
+            origin = std::min(origin, buffer->events[i & (TRACE_RING_SIZE - 1)].begin_ns);
+        }
+        dropped += first;
+    }
+    if (origin == UINT64_MAX) origin = 0;
+
+    fprintf(file, "{\"traceEvents\": [\n");
+    bool first_event = true;
+    for (const auto& buffer : buffers) {
+        if (!buffer->name.empty()) {
+            fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": ",
+                    first_event ? "" : ",\n", pid, buffer->tid);
+            writeString(file, buffer->name.c_str());
+            fprintf(file, "}}");
+            first_event = false;
+        }
+
+        uint64_t n = buffer->written.load(std::memory_order_acquire);
+        uint64_t first = n > TRACE_RING_SIZE ? n - TRACE_RING_SIZE : 0;
+        for (uint64_t i = first; i < n; i++) {
+            const Event& e = buffer->events[i & (TRACE_RING_SIZE - 1)];
+            fprintf(file, "%s{\"name\": ", first_event ? "" : ",\n");
+            writeString(file, e.name);
+            fprintf(file, ", \"ph\": \"X\", \"pid\": %d, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                    pid, buffer->tid, (e.begin_ns - origin) / 1000.0, (e.end_ns - e.begin_ns) / 1000.0);
+            first_event = false;
+        }
+    }
+    fprintf(file, "\n], \"displayTimeUnit\": \"ms\", \"otherData\": {\"dropped_events\": %llu}}\n",
+            (unsigned long long)dropped);
+
+    return fclose(file) == 0;
+}
+
+} // namespace trace
+
+#endif // TJURM_TRACE
@@ -6,11 +6,24 @@
 using std::vector;
 
 int get_terminal_width() {
+    // 输出被重定向（无界面、并行运行）时拿不到终端宽度
     struct winsize size;
-    ioctl(STDOUT_FILENO, TIOCGWINSZ, &size);
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0 || size.ws_col == 0) {
+        return 80;
+    }
     return size.ws_col;
 }
 
+static bool headless_mode = false;
+
+void set_headless(bool headless) {
+    headless_mode = headless;
+}
+
+bool is_headless() {
+    return headless_mode;
+}
+
 void print_line(int width, char c) {
     for (int j = 0; j < width / 2; j++)
         std::cout << c << ' ';
@@ -71,4 +84,26 @@ std::vector<cv::Point> make_random_contour(int rows, int cols) {
     }
 
     return contour;
-}
\ No newline at end of file
+}
+cv::Mat make_random_mask(int rows, int cols, double density, int shapes, cv::RNG& rng) {
+    cv::Mat m(rows, cols, CV_8UC1);
+    rng.fill(m, cv::RNG::UNIFORM, 0, 256);
+    if (density < 1) {
+        cv::Mat noise(rows, cols, CV_16UC1), sparse(rows, cols, CV_8UC1, cv::Scalar(0));
+        rng.fill(noise, cv::RNG::UNIFORM, 0, 1000);
+        m.copyTo(sparse, noise < density * 1000);
+        m = sparse;
+    }
+    for (int i = 0; i < shapes; i++) {
+        cv::Point p(rng.uniform(0, cols), rng.uniform(0, rows));
+        cv::Scalar color(rng.uniform(0, 2) * 255);
+        if (i % 2 == 0) {
+            cv::Size s(rng.uniform(1, cols / 2 + 2), rng.uniform(1, rows / 2 + 2));
+            cv::rectangle(m, cv::Rect(p, s), color, -1);
+        } else {
+            cv::Size axes(rng.uniform(1, cols / 4 + 2), rng.uniform(1, rows / 4 + 2));
+            cv::ellipse(m, p, axes, rng.uniform(0, 180), 0, 360, color, -1);
+        }
+    }
+    return m;
+}
@@ -0,0 +1,329 @@
+/*
+ * 装甲板检测回放基准
+ *
+ * 把视频文件或图片目录逐帧送进 ArmorDetector::processFrame，统计各阶段的延迟分布，
+ * 结果以 JSON 输出，方便比较不同构建。
+ *
+ * 用法: armor_replay <视频文件|图片目录> [选项]
+ *   --rate FPS      按固定帧率送帧，0（默认）为全速
+ *   --loops N       重复回放 N 遍（默认 1）
+ *   --warmup N      前 N 帧不计入统计（默认 10）
+ *   --roi           开启跟踪引导的 ROI 检测
+ *   --color red|blue 按敌方颜色做颜色差分二值化，代替灰度自适应阈值
+ *   --label         用连通域统计找灯条，代替 findContours + minAreaRect
+ *   --mean N        灰度自适应阈值改用积分图均值阈值，窗口 N（3 到 1023 的奇数）
+ *   --json FILE     JSON 写到文件，默认写到标准输出
+ *   --trace FILE    导出 Chrome trace（需要 -DTJURM_TRACE=ON 构建）
+ */
+
+#include "armor_detect.h"
+#include "trace.h"
+#include <opencv2/opencv.hpp>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+// 帧来源：视频文件，或者按文件名排序的图片目录
+class FrameSource {
+public:
+    FrameSource() : next_(0) {}
+
+    bool open(const string& path) {
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            vector<String> files;
+            glob(path + "/*", files, false);
+            for (const auto& file : files) {
+                if (isImageFile(file)) {
+                    files_.push_back(file);
+                }
+            }
+            sort(files_.begin(), files_.end());
+            return !files_.empty();
+        }
+        return capture_.open(path);
+    }
+
+    bool read(Mat& frame) {
+        if (!capture_.isOpened()) {
+            // 读不出来的图片跳过
+            while (next_ < files_.size()) {
+                frame = imread(files_[next_++], IMREAD_COLOR);
+                if (!frame.empty()) return true;
+                cerr << "跳过无法读取的图片: " << files_[next_ - 1] << endl;
+            }
+            return false;
+        }
+        return capture_.read(frame) && !frame.empty();
+    }
+
+    void rewind() {
+        next_ = 0;
+        if (capture_.isOpened()) {
+            capture_.set(CAP_PROP_POS_FRAMES, 0);
+        }
+    }
+
+private:
+    static bool isImageFile(const string& file) {
+        static const char* exts[] = {".png", ".jpg", ".jpeg", ".bmp", ".tif", ".tiff"};
+        string lower = file;
+        transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        for (const char* ext : exts) {
+            size_t n = strlen(ext);
+            if (lower.size() >= n && lower.compare(lower.size() - n, n, ext) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    VideoCapture capture_;
+    vector<string> files_;
+    size_t next_;
+};
+
+// 一个阶段的延迟样本（毫秒）
+struct LatencySeries {
+    string name;
+    vector<double> samples;
+
+    explicit LatencySeries(const string& _name) : name(_name) {}
+
+    // 最近秩法取分位数，samples 需已排序
+    double percentile(double p) const {
+        if (samples.empty()) return 0;
+        size_t rank = (size_t)ceil(p * samples.size());
+        return samples[min(samples.size(), max<size_t>(rank, 1)) - 1];
+    }
+
+    void writeJson(ostream& out) {
+        sort(samples.begin(), samples.end());
+        double sum = 0;
+        for (double v : samples) sum += v;
+        double mean = samples.empty() ? 0 : sum / samples.size();
+        out << "\"" << name << "\": {\"mean\": " << mean
+            << ", \"p50\": " << percentile(0.50)
+            << ", \"p90\": " << percentile(0.90)
+            << ", \"p99\": " << percentile(0.99)
+            << ", \"max\": " << (samples.empty() ? 0 : samples.back()) << "}";
+    }
+};
+
+static string jsonEscape(const string& s) {
+    string out;
+    for (char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        case '\r': out += "\\r"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        default:
+            // 其余控制字符按 \u00XX 输出；UTF-8 的多字节部分原样保留
+            if ((unsigned char)c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out;
+}
+
+static void printUsage() {
+    cerr << "用法: armor_replay <视频文件|图片目录> [--rate FPS] [--loops N] [--warmup N] "
+            "[--roi] [--color red|blue] [--label] [--mean N] [--json FILE] [--trace FILE]" << endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    string input = argv[1];
+    double rate = 0;
+    int loops = 1;
+    int warmup = 10;
+    bool roi = false;
+    bool label = false;
+    int mean_block = 0;
+    string color;
+    string json_path;
+    string trace_path;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--rate" && has_value) {
+            rate = atof(argv[++i]);
+        } else if (arg == "--loops" && has_value) {
+            loops = max(1, atoi(argv[++i]));
+        } else if (arg == "--warmup" && has_value) {
+            warmup = max(0, atoi(argv[++i]));
+        } else if (arg == "--roi") {
+            roi = true;
+        } else if (arg == "--color" && has_value && (string(argv[i + 1]) == "red" || string(argv[i + 1]) == "blue")) {
+            color = argv[++i];
+        } else if (arg == "--label") {
+            label = true;
+        } else if (arg == "--mean" && has_value && atoi(argv[i + 1]) % 2 == 1 && atoi(argv[i + 1]) > 1 &&
+                   atoi(argv[i + 1]) <= 1023) {
+            mean_block = atoi(argv[++i]);
+        } else if (arg == "--json" && has_value) {
+            json_path = argv[++i];
+        } else if (arg == "--trace" && has_value) {
+            trace_path = argv[++i];
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    FrameSource source;
+    if (!source.open(input)) {
+        cerr << "无法打开输入: " << input << endl;
+        return 1;
+    }
+
+    TRACE_THREAD_NAME("replay");
+    ArmorDetector detector;
+    detector.setRoiMode(roi);
+    detector.setLabelMode(label);
+    if (mean_block > 0) {
+        detector.setMeanThresholdMode(true, mean_block);
+    }
+    if (!color.empty()) {
+        detector.setColorMode(true, ColorMaskParams(color == "blue" ? EnemyColor::BLUE : EnemyColor::RED));
+    }
+
+    vector<LatencySeries> series = {
+        LatencySeries("preprocess"), LatencySeries("find_light_bars"), LatencySeries("pair_light_bars"),
+        LatencySeries("tracker"), LatencySeries("pose"), LatencySeries("total")
+    };
+
+    typedef chrono::steady_clock Clock;
+    const Clock::duration period = rate > 0
+        ? chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / rate))
+        : Clock::duration::zero();
+
+    Mat frame;
+    Size resolution;
+    long long frames = 0, measured = 0, late_frames = 0, armor_count = 0;
+    Clock::time_point start, deadline;
+
+    for (int loop = 0; loop < loops; loop++) {
+        if (loop > 0) source.rewind();
+        while (source.read(frame)) {
+            if (frames == warmup) {
+                start = Clock::now();
+                deadline = start;
+            }
+            // 固定帧率：等到本帧的送帧时刻；处理超过一个周期的帧记为迟到，不丢帧
+            if (rate > 0 && frames >= warmup) {
+                this_thread::sleep_until(deadline);
+            }
+
+            int64 t0 = getTickCount();
+            const vector<TrackedArmor>& armors = detector.processFrame(frame);
+            double total_ms = (getTickCount() - t0) * 1000.0 / getTickFrequency();
+            frames++;
+
+            if (frames <= warmup) continue;
+
+            const ArmorStageTimes& t = detector.lastStageTimes();
+            series[0].samples.push_back(t.preprocess);
+            series[1].samples.push_back(t.find_light_bars);
+            series[2].samples.push_back(t.pair_light_bars);
+            series[3].samples.push_back(t.tracker);
+            series[4].samples.push_back(t.pose);
+            series[5].samples.push_back(total_ms);
+            armor_count += armors.size();
+            resolution = frame.size();
+            measured++;
+
+            if (rate > 0) {
+                deadline += period;
+                if (Clock::now() > deadline) late_frames++;
+            }
+        }
+    }
+
+    if (measured == 0) {
+        cerr << "有效帧数为 0（共 " << frames << " 帧，预热 " << warmup << " 帧）" << endl;
+        return 1;
+    }
+
+    double wall_s = chrono::duration<double>(Clock::now() - start).count();
+    double busy_ms = 0;
+    for (double v : series[5].samples) busy_ms += v;
+
+    ofstream file;
+    if (!json_path.empty()) {
+        file.open(json_path.c_str());
+        if (!file) {
+            cerr << "无法写入: " << json_path << endl;
+            return 1;
+        }
+    }
+    ostream& out = json_path.empty() ? cout : file;
+
+    out << "{\"input\": \"" << jsonEscape(input) << "\""
+        << ", \"mode\": \"" << (rate > 0 ? "fixed_rate" : "max_speed") << "\""
+        << ", \"rate\": " << rate
+        << ", \"roi\": " << (roi ? "true" : "false")
+        << ", \"color\": \"" << (color.empty() ? "gray" : color) << "\""
+        << ", \"label\": " << (label ? "true" : "false")
+        << ", \"mean_block\": " << mean_block
+        << ", \"headless\": "
+#ifdef ARMOR_HEADLESS
+        << "true"
+#else
+        << "false"
+#endif
+        << ", \"width\": " << resolution.width << ", \"height\": " << resolution.height
+        << ", \"frames\": " << measured
+        << ", \"warmup\": " << warmup
+        << ", \"fps\": " << measured / wall_s
+        << ", \"processing_fps\": " << measured * 1000.0 / busy_ms
+        << ", \"late_frames\": " << late_frames
+        << ", \"armors_per_frame\": " << (double)armor_count / measured
+        << ", \"latency_ms\": {";
+    for (size_t i = 0; i < series.size(); i++) {
+        if (i) out << ", ";
+        series[i].writeJson(out);
+    }
+    out << "}}" << endl;
+
+    cerr << measured << " 帧 " << resolution.width << "x" << resolution.height
+         << ", " << measured / wall_s << " FPS, total p99 " << series[5].percentile(0.99) << " ms";
+    if (rate > 0) cerr << ", 迟到 " << late_frames << " 帧";
+    cerr << endl;
+
+    if (!trace_path.empty()) {
+#ifdef TJURM_TRACE
+        if (!TRACE_DUMP(trace_path.c_str())) {
+            cerr << "无法写入: " << trace_path << endl;
+        }
+#else
+        cerr << "--trace 需要用 -DTJURM_TRACE=ON 重新构建" << endl;
+#endif
+    }
+    return 0;
+}